@@ -0,0 +1,92 @@
+#include "AllocationTracker.hpp"
+
+#ifdef KMS_TRACK_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace {
+std::atomic<bool> tracking{false};
+std::atomic<size_t> frameAllocations{0};
+std::atomic<size_t> frameBytes{0};
+size_t frameNumber = 0;
+size_t lastReported = 0;
+
+void count(size_t size) {
+    if (tracking.load(std::memory_order_relaxed)) {
+        frameAllocations.fetch_add(1, std::memory_order_relaxed);
+        frameBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+void* trackedAlloc(size_t size) noexcept {
+    count(size);
+    return std::malloc(size ? size : 1);
+}
+
+// aligned_alloc wants the size rounded up to the alignment
+void* trackedAlloc(size_t size, std::align_val_t align) noexcept {
+    count(size);
+    size_t a = static_cast<size_t>(align);
+    return std::aligned_alloc(a, size ? (size + a - 1) / a * a : a);
+}
+
+template <typename... Align>
+void* trackedOrThrow(size_t size, Align... align) {
+    void* p = trackedAlloc(size, align...);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+}
+
+// every replaceable form, the aligned ones are what the SIMD containers use
+void* operator new(size_t size) { return trackedOrThrow(size); }
+void* operator new[](size_t size) { return trackedOrThrow(size); }
+void* operator new(size_t size, std::align_val_t align) { return trackedOrThrow(size, align); }
+void* operator new[](size_t size, std::align_val_t align) { return trackedOrThrow(size, align); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return trackedAlloc(size, align);
+}
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return trackedAlloc(size, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace AllocationTracker {
+void beginFrame() {
+    ++frameNumber;
+    frameAllocations.store(0, std::memory_order_relaxed);
+    frameBytes.store(0, std::memory_order_relaxed);
+    tracking.store(true, std::memory_order_relaxed);
+}
+
+size_t endFrame() {
+    tracking.store(false, std::memory_order_relaxed);
+    size_t count = frameAllocations.load(std::memory_order_relaxed);
+    // the same steady leak every frame is printed once, changes again
+    if (count != lastReported) {
+        if (count) {
+            std::cerr << "Frame " << frameNumber << " made " << count << " heap allocations ("
+                      << frameBytes.load(std::memory_order_relaxed) << " bytes)!!!" << std::endl;
+        }
+        lastReported = count;
+    }
+    return count;
+}
+}
+#endif
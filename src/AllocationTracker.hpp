@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+// debug hook on every form of the global operator new, aligned and nothrow
+// included, built with -DKMS_TRACK_ALLOCATIONS=ON; counts heap allocations
+// from any thread between beginFrame() and endFrame() and reports frames
+// that made some. compiles to nothing otherwise
+namespace AllocationTracker {
+#ifdef KMS_TRACK_ALLOCATIONS
+void beginFrame();
+// allocations since beginFrame(), printed when nonzero
+size_t endFrame();
+#else
+inline void beginFrame() {}
+inline size_t endFrame() { return 0; }
+#endif
+}
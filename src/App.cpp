@@ -1,14 +1,19 @@
 #include "App.hpp"
+#include "AssetCache.hpp"
+#include "AllocationTracker.hpp"
+#include <chrono>
 #include <cstdlib>
 #include <ctime>
 
 App::App()
     : window(nullptr),
       currentSceneIdx(0),
+      activeSceneIdx(-1),
       deltaTime(0.0f),
       lastFrame(0.0f) {}
 
 App::~App() {
+    AssetCache::instance().stop();
     if (window) glfwDestroyWindow(window);
     glfwTerminate();
 }
@@ -18,11 +23,15 @@ void App::init() {
         std::cerr << "Failed to init GLFW!!!\n";
         exit(EXIT_FAILURE);
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    window = glfwCreateWindow(800, 600, "ZPG", nullptr, nullptr);
+    // 4.3 enables the indirect and compute paths, everything else runs on 3.3
+    const int contextVersions[][2] = {{4, 3}, {3, 3}};
+    for (const auto& version : contextVersions) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        window = glfwCreateWindow(800, 600, "ZPG", nullptr, nullptr);
+        if (window) break;
+    }
     if (!window) {
         std::cerr << "Failed to create GLFW window!!!\n";
         glfwTerminate();
@@ -69,14 +78,58 @@ void App::init() {
     scenes.push_back(std::make_unique<WrongOneBallScene>());
     scenes.push_back(std::make_unique<ModelScene>());
     scenes.push_back(std::make_unique<WhackAMoleScene>());
+    scenes.push_back(std::make_unique<WorldScene>());
+
+    frameWorkers = std::make_unique<ThreadPool>();
+    frameArena = std::make_unique<FrameArena>();
     for (auto& scene : scenes) {
-        scene->init();
-        scene->attachToCamera(camera.get());
+        scene->setWorkers(frameWorkers.get());
+        scene->setFrameArena(frameArena.get());
     }
+
+    // only the first scene is built before the first frame, the rest initialize
+    // on activation with their files read ahead by the cache workers
+    AssetCache::instance().start(2);
+    activateScene(currentSceneIdx);
+}
+
+void App::activateScene(int idx) {
+    if (idx == activeSceneIdx) return;
+    if (activeSceneIdx >= 0) {
+        scenes[activeSceneIdx]->deactivate(camera.get());
+    }
+
+    BaseScene* scene = scenes[idx].get();
+    if (!scene->isInitialized()) {
+        AssetManifest declared;
+        scene->declareAssets(declared);
+        AssetCache::instance().beginScene(declared);
+        auto start = std::chrono::steady_clock::now();
+        scene->activate(camera.get());
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Scene " << idx << " initialized in " << ms << " ms\n";
+    } else {
+        scene->activate(camera.get());
+    }
+    // whatever the scene didn't take, e.g. a prefetch for a scene that was skipped
+    AssetCache::instance().endScene();
+    activeSceneIdx = idx;
+
+    // Tab walks the scenes in order, so the next one is the likeliest pick
+    prefetchScene((idx + 1) % static_cast<int>(scenes.size()));
+}
+
+void App::prefetchScene(int idx) {
+    BaseScene* scene = scenes[idx].get();
+    if (scene->isInitialized()) return;
+    AssetManifest assets;
+    scene->declareAssets(assets);
+    AssetCache::instance().prefetch(assets);
 }
 
 void App::run() {
     while (!glfwWindowShouldClose(window)) {
+        AllocationTracker::beginFrame();
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
@@ -88,24 +141,37 @@ void App::run() {
         }
         controls->procCameraInput(deltaTime);
         controls->procSceneSwitch(currentSceneIdx, scenes.size());
+        activateScene(currentSceneIdx);
 
         // SCENE SPECIFIC INPUTS START
         MultiShaderForestScene* forestScene = dynamic_cast<MultiShaderForestScene*>(scenes[currentSceneIdx].get());
         controls->procBatteryToggle(forestScene);
         controls->procEditModeToggle(forestScene);
+        controls->procSnapshotKeys(forestScene);
         //
         WhackAMoleScene* whackAMoleScene = dynamic_cast<WhackAMoleScene*>(scenes[currentSceneIdx].get());
         if (whackAMoleScene) {
             whackAMoleScene->update(deltaTime);
         }
         controls->procWhackAMoleInput(whackAMoleScene);
+        WorldScene* worldScene = dynamic_cast<WorldScene*>(scenes[currentSceneIdx].get());
+        if (worldScene) {
+            worldScene->update(deltaTime);
+        }
         controls->procMouseHover(forestScene);
+        controls->procAnimationModeToggle(dynamic_cast<SolarSystemScene*>(scenes[currentSceneIdx].get()));
+        controls->procIndirectToggle(dynamic_cast<ModelScene*>(scenes[currentSceneIdx].get()));
+        controls->procCullingToggle(scenes[currentSceneIdx].get());
+        controls->procDepthPrepassToggle(scenes[currentSceneIdx].get());
+        controls->procStatsKey(scenes[currentSceneIdx].get());
         // SCENE SPECIFIC INPUTS END
         
         if (!scenes.empty()) {
             scenes[currentSceneIdx]->draw();
         }
+        AllocationTracker::endFrame();
         glfwSwapBuffers(window);
+        frameArena->reset();
         glfwPollEvents();
     }
 }
\ No newline at end of file
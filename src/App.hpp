@@ -12,6 +12,8 @@
 #include "Model.hpp"
 #include "Camera.hpp"
 #include "Controls.hpp"
+#include "ThreadPool.hpp"
+#include "FrameArena.hpp"
 
 #include "trans/Transform.hpp"
 
@@ -26,6 +28,7 @@
 #include "scenes/WrongOneBallScene.hpp"
 #include "scenes/ModelScene.hpp"
 #include "scenes/WhackAMoleScene.hpp"
+#include "scenes/WorldScene.hpp"
 
 class App {
 public:
@@ -37,9 +40,17 @@ public:
 private:
     GLFWwindow* window;
     int currentSceneIdx;
+    int activeSceneIdx;
     float deltaTime;
     float lastFrame;
     std::unique_ptr<Camera> camera;
     std::unique_ptr<Controls> controls;
+    // per-frame CPU work of the scenes (culling, transform updates)
+    std::unique_ptr<ThreadPool> frameWorkers;
+    // scratch memory of the current frame, reset after the swap
+    std::unique_ptr<FrameArena> frameArena;
     std::vector<std::unique_ptr<BaseScene>> scenes;
+
+    void activateScene(int idx);
+    void prefetchScene(int idx);
 };
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "AssetCache.hpp"
+#include "Utils.hpp"
+#include "renderers/Texture.hpp"
+#include <iostream>
+
+AssetCache& AssetCache::instance() {
+    static AssetCache cache;
+    return cache;
+}
+
+void AssetCache::start(unsigned int workerCount) {
+    if (!workers) {
+        workers = std::make_unique<ThreadPool>(workerCount);
+    }
+}
+
+void AssetCache::stop() {
+    // joins the workers, queued loads that never ran are dropped with the entries
+    workers.reset();
+    std::lock_guard<std::mutex> lock(mutex);
+    meshes.clear();
+    images.clear();
+    shaderSources.clear();
+}
+
+void AssetCache::prefetch(const AssetManifest& manifest) {
+    for (auto& shader : manifest.shaders) {
+        request(shaderSources, shader, [shader]() {
+            return std::make_shared<std::string>(readTextFile(shader));
+        });
+    }
+    for (auto& model : manifest.models) {
+        std::string path = model.first;
+        ModelType type = model.second;
+        request(meshes, meshKey(path, type), [path, type]() {
+            auto mesh = std::make_shared<MeshData>();
+            if (!Model::ReadMeshFile(path, type, mesh->vertices, mesh->stride)) return std::shared_ptr<MeshData>();
+            return mesh;
+        });
+    }
+    for (auto& texture : manifest.textures) {
+        request(images, texture, [texture]() {
+            auto image = std::make_shared<ImageData>();
+            if (!Texture::DecodeImage(texture, true, *image)) return std::shared_ptr<ImageData>();
+            return image;
+        });
+    }
+}
+
+void AssetCache::beginScene(const AssetManifest& declared) {
+    std::lock_guard<std::mutex> lock(mutex);
+    declaredKeys.clear();
+    addKeys(declared, declaredKeys);
+    checkingScene = true;
+}
+
+void AssetCache::endScene() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& key : declaredKeys) {
+        if (!takenKeys.count(key)) {
+            std::cerr << "Asset " << key << " was declared but never loaded!!!" << std::endl;
+        }
+    }
+    // loads still queued keep running, their results just have no owner anymore
+    meshes.clear();
+    images.clear();
+    shaderSources.clear();
+    declaredKeys.clear();
+    takenKeys.clear();
+    checkingScene = false;
+}
+
+void AssetCache::addKeys(const AssetManifest& manifest, std::unordered_set<std::string>& keys) {
+    for (auto& model : manifest.models) keys.insert(meshKey(model.first, model.second));
+    keys.insert(manifest.textures.begin(), manifest.textures.end());
+    keys.insert(manifest.shaders.begin(), manifest.shaders.end());
+}
+
+std::shared_ptr<MeshData> AssetCache::takeMesh(const std::string& path, ModelType type) {
+    return take(meshes, meshKey(path, type));
+}
+
+std::shared_ptr<ImageData> AssetCache::takeImage(const std::string& path) {
+    return take(images, path);
+}
+
+std::shared_ptr<std::string> AssetCache::takeShaderSrc(const std::string& path) {
+    return take(shaderSources, path);
+}
+
+template <typename T, typename Loader>
+void AssetCache::request(Entries<T>& entries, const std::string& key, Loader loader) {
+    if (!workers) return;
+    auto task = std::make_shared<std::packaged_task<std::shared_ptr<T>()>>(loader);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.count(key)) return;
+        entries.emplace(key, task->get_future().share());
+    }
+    workers->enqueue([task]() { (*task)(); });
+}
+
+template <typename T>
+std::shared_ptr<T> AssetCache::take(Entries<T>& entries, const std::string& key) {
+    std::shared_future<std::shared_ptr<T>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (checkingScene) {
+            if (!declaredKeys.count(key)) {
+                std::cerr << "Asset " << key << " was loaded without being declared!!!" << std::endl;
+            }
+            takenKeys.insert(key);
+        }
+        auto it = entries.find(key);
+        if (it == entries.end()) return nullptr;
+        pending = it->second;
+        entries.erase(it);
+    }
+    try {
+        return pending.get();
+    } catch (const std::future_error&) {
+        // load was dropped before a worker picked it up
+        return nullptr;
+    }
+}
+
+std::string AssetCache::meshKey(const std::string& path, ModelType type) {
+    return path + "#" + std::to_string(static_cast<int>(type));
+}
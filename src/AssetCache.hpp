@@ -0,0 +1,100 @@
+#pragma once
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "Model.hpp"
+#include "ThreadPool.hpp"
+
+// CPU-side results of loading an asset, no GL objects involved so they can be
+// produced on worker threads and uploaded later on the thread owning the context
+struct MeshData {
+    std::vector<float> vertices;
+    int stride = 0;
+};
+
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<unsigned char> pixels;
+};
+
+// the files a scene's init() reads, so they can be loaded ahead of it. a
+// scene keeps one at file scope, filled by the path constants init() loads
+// through, and declareAssets() hands that same list to the prefetcher
+struct AssetManifest {
+    std::vector<ModelFile> models;
+    std::vector<std::string> textures;
+    std::vector<std::string> shaders;
+
+    // list a file and get its path back
+    std::string shader(const std::string& path) {
+        shaders.push_back(path);
+        return path;
+    }
+    std::string texture(const std::string& path) {
+        textures.push_back(path);
+        return path;
+    }
+    ModelFile model(const std::string& path, ModelType type) {
+        models.emplace_back(path, type);
+        return models.back();
+    }
+    void append(const AssetManifest& other) {
+        models.insert(models.end(), other.models.begin(), other.models.end());
+        textures.insert(textures.end(), other.textures.begin(), other.textures.end());
+        shaders.insert(shaders.end(), other.shaders.begin(), other.shaders.end());
+    }
+};
+
+class AssetCache {
+public:
+    static AssetCache& instance();
+
+    void start(unsigned int workerCount = 0);
+    void stop();
+    void prefetch(const AssetManifest& manifest);
+
+    // brackets a scene's init(): loads it didn't declare are reported, and
+    // endScene() reports what it declared but never took, then drops every
+    // entry still cached, including ones prefetched for other scenes
+    void beginScene(const AssetManifest& declared);
+    void endScene();
+
+    // hand over a prefetched asset (waiting for it if still in flight),
+    // nullptr when it was never requested so the caller loads it itself
+    std::shared_ptr<MeshData> takeMesh(const std::string& path, ModelType type);
+    std::shared_ptr<ImageData> takeImage(const std::string& path);
+    std::shared_ptr<std::string> takeShaderSrc(const std::string& path);
+
+private:
+    template <typename T>
+    using Entries = std::unordered_map<std::string, std::shared_future<std::shared_ptr<T>>>;
+
+    AssetCache() = default;
+
+    std::unique_ptr<ThreadPool> workers;
+    std::mutex mutex;
+    Entries<MeshData> meshes;
+    Entries<ImageData> images;
+    Entries<std::string> shaderSources;
+    // what the scene being initialized declared and what it loaded so far,
+    // empty outside of beginScene/endScene
+    std::unordered_set<std::string> declaredKeys;
+    std::unordered_set<std::string> takenKeys;
+    bool checkingScene = false;
+
+    template <typename T, typename Loader>
+    void request(Entries<T>& entries, const std::string& key, Loader loader);
+    template <typename T>
+    std::shared_ptr<T> take(Entries<T>& entries, const std::string& key);
+    static void addKeys(const AssetManifest& manifest, std::unordered_set<std::string>& keys);
+
+    static std::string meshKey(const std::string& path, ModelType type);
+};
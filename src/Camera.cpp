@@ -86,6 +86,11 @@ void Camera::updateAspectRatio(float width, float height) {
     notify();
 }
 
+void Camera::refreshObservers() {
+    lastChangeType = ChangeType::PROJECTION;
+    notify();
+}
+
 void Camera::updateCameraVecs() {
     glm::vec3 newFront;
     newFront.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
@@ -36,6 +36,8 @@ public:
     void procMouseMovement(float xoffset, float yoffset, bool constrainPitch = true);
     void procMouseScroll(float yoffset);
     void updateAspectRatio(float width, float height);
+    // pushes both view and projection, for observers attached after startup
+    void refreshObservers();
     //
     void setPosition(const glm::vec3& pos) {
         position = pos;
@@ -5,6 +5,7 @@
 #include "scenes/MultiShaderForestScene.hpp"
 #include "scenes/ModelScene.hpp"
 #include "scenes/WhackAMoleScene.hpp"
+#include "scenes/SolarSystemScene.hpp"
 
 Controls::Controls(GLFWwindow* window, Camera* camera)
     : window(window),
@@ -17,7 +18,14 @@ Controls::Controls(GLFWwindow* window, Camera* camera)
       lMousePressed(false),
       fPressed(false),
       tPressed(false),
-      mPressed(false) {}
+      mPressed(false),
+      gPressed(false),
+      iPressed(false),
+      cPressed(false),
+      pPressed(false),
+      lPressed(false),
+      f5Pressed(false),
+      f9Pressed(false) {}
 
 void Controls::setupCallbacks() {
     glfwSetWindowUserPointer(window, this);
@@ -160,6 +168,71 @@ void Controls::procEditModeToggle(MultiShaderForestScene* forestScene) {
     }
 }
 
+void Controls::procAnimationModeToggle(SolarSystemScene* solarScene) {
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS) {
+        if (!gPressed) {
+            if (solarScene) {
+                solarScene->toggleGpuAnimation();
+            }
+            gPressed = true;
+        }
+    } else {
+        gPressed = false;
+    }
+}
+
+void Controls::procIndirectToggle(ModelScene* modelScene) {
+    if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS) {
+        if (!iPressed) {
+            if (modelScene) {
+                modelScene->toggleIndirect();
+            }
+            iPressed = true;
+        }
+    } else {
+        iPressed = false;
+    }
+}
+
+void Controls::procCullingToggle(BaseScene* scene) {
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
+        if (!cPressed) {
+            if (scene) {
+                scene->toggleCulling();
+            }
+            cPressed = true;
+        }
+    } else {
+        cPressed = false;
+    }
+}
+
+void Controls::procDepthPrepassToggle(BaseScene* scene) {
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
+        if (!pPressed) {
+            if (scene) {
+                scene->toggleDepthPrepass();
+            }
+            pPressed = true;
+        }
+    } else {
+        pPressed = false;
+    }
+}
+
+void Controls::procStatsKey(BaseScene* scene) {
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) {
+        if (!lPressed) {
+            if (scene) {
+                scene->printStats();
+            }
+            lPressed = true;
+        }
+    } else {
+        lPressed = false;
+    }
+}
+
 void Controls::procMouseHover(MultiShaderForestScene* forestScene) {
     if (!forestScene) return;
     
@@ -172,6 +245,30 @@ void Controls::procMouseHover(MultiShaderForestScene* forestScene) {
     forestScene->updateMouseHover(xpos, ypos, width, height);
 }
 
+void Controls::procSnapshotKeys(MultiShaderForestScene* forestScene) {
+    if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS) {
+        if (!f5Pressed) {
+            if (forestScene) {
+                forestScene->saveSnapshot(MultiShaderForestScene::SNAPSHOT_PATH);
+            }
+            f5Pressed = true;
+        }
+    } else {
+        f5Pressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS) {
+        if (!f9Pressed) {
+            if (forestScene) {
+                forestScene->loadSnapshot(MultiShaderForestScene::SNAPSHOT_PATH);
+            }
+            f9Pressed = true;
+        }
+    } else {
+        f9Pressed = false;
+    }
+}
+
 bool Controls::shouldClose() const {
     return glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS;
 }
@@ -5,6 +5,8 @@ class Camera;
 class MultiShaderForestScene;
 class ModelScene;
 class WhackAMoleScene;
+class SolarSystemScene;
+class BaseScene;
 
 class Controls {
 public:
@@ -17,7 +19,13 @@ public:
     void procSkyboxToggle(ModelScene* modelScene);
     void procEditModeToggle(MultiShaderForestScene* forestScene);
     void procWhackAMoleInput(WhackAMoleScene* whackAMoleScene);
+    void procAnimationModeToggle(SolarSystemScene* solarScene);
+    void procIndirectToggle(ModelScene* modelScene);
+    void procCullingToggle(BaseScene* scene);
+    void procDepthPrepassToggle(BaseScene* scene);
+    void procStatsKey(BaseScene* scene);
     void procMouseHover(MultiShaderForestScene* forestScene);
+    void procSnapshotKeys(MultiShaderForestScene* forestScene);
     bool shouldClose() const;
     
     Camera* getCamera() const { return camera; }
@@ -34,6 +42,13 @@ private:
     bool fPressed;
     bool tPressed;
     bool mPressed;
+    bool gPressed;
+    bool iPressed;
+    bool cPressed;
+    bool pPressed;
+    bool lPressed;
+    bool f5Pressed;
+    bool f9Pressed;
     
     static void mouseCallback(GLFWwindow* window, double xpos, double ypos);
     static void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
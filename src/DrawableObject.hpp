@@ -2,7 +2,10 @@
 #include "Model.hpp"
 #include "renderers/Shader.hpp"
 #include "renderers/Texture.hpp"
+#include "renderers/Material.hpp"
+#include "renderers/RenderLayers.hpp"
 #include "trans/Transform.hpp"
+#include "SlotMap.hpp"
 #include <memory>
 
 struct DrawableObject {
@@ -13,4 +16,12 @@ struct DrawableObject {
     Texture* normalMap = nullptr;
     Material material = Material::Plastic();
     int normalIntensity = 1;
-};
\ No newline at end of file
+    // drawn by an InstanceGroup, skipped by the per-object paths
+    bool instanced = false;
+    // RenderLayer bits, change them through BaseScene::setLayers
+    uint32_t layers = RenderLayer::OPAQUE;
+    // stencil value of the ID pass for PICKABLE objects, 1-255
+    uint8_t pickId = 0;
+};
+// what scenes keep to refer to an object across removals of other objects
+using ObjectHandle = SlotHandle;
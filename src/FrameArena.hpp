@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// bump allocator for data that lives for one frame; reset() at the end of the
+// frame hands everything back at once. when a frame needs more than the
+// current block another one is chained on, and the next reset merges them so
+// the following frames fit in a single block again. main thread only
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity = 1 << 20) {
+        addBlock(capacity);
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        Block& block = blocks.back();
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        uintptr_t start = (base + offset + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+        if (start + bytes > base + block.size) {
+            addBlock(std::max(block.size * 2, bytes + align));
+            return allocate(bytes, align);
+        }
+        offset = start + bytes - base;
+        used += bytes;
+        return reinterpret_cast<void*>(start);
+    }
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // everything handed out since the last reset is invalid afterwards
+    void reset() {
+        if (used > peak) peak = used;
+        if (blocks.size() > 1) {
+            size_t total = 0;
+            for (const auto& b : blocks) total += b.size;
+            blocks.clear();
+            addBlock(total);
+        }
+        offset = 0;
+        used = 0;
+    }
+
+    size_t getUsed() const { return used; }
+    size_t getPeak() const { return peak > used ? peak : used; }
+    size_t getCapacity() const {
+        size_t total = 0;
+        for (const auto& b : blocks) total += b.size;
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t offset = 0;
+    size_t used = 0;
+    size_t peak = 0;
+
+    void addBlock(size_t size) {
+        blocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+        offset = 0;
+    }
+};
+
+// std allocator over a FrameArena, frees are no-ops; without an arena it
+// falls back to the heap so the same containers work outside a frame
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator(FrameArena* arena = nullptr) : arena(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.getArena()) {}
+
+    T* allocate(size_t n) {
+        if (arena) return arena->allocateArray<T>(n);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) {
+        if (!arena) ::operator delete(p);
+    }
+
+    FrameArena* getArena() const { return arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& o) const { return arena == o.getArena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& o) const { return arena != o.getArena(); }
+
+private:
+    FrameArena* arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
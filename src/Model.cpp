@@ -1,8 +1,12 @@
 #include "Model.hpp"
+#include "AssetCache.hpp"
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 static inline void bindAttributes(ModelType type, GLuint VAO, GLuint VBO, int strideFloats) {
@@ -92,37 +96,185 @@ static inline void extractMeshData(const aiMesh* mesh, std::vector<float>& data,
     }
 }
 
+namespace {
+// a vertex is keyed by its index in the source array and compared by its raw
+// bits, so deduplicating doesn't copy any vertex into a key of its own
+struct VertexHash {
+    const float* vertices;
+    size_t stride;
+    size_t operator()(uint32_t i) const {
+        size_t h = 2166136261u;
+        for (size_t k = 0; k < stride; ++k) {
+            uint32_t bits;
+            std::memcpy(&bits, vertices + i * stride + k, sizeof(float));
+            h = (h ^ bits) * 16777619u;
+        }
+        return h;
+    }
+};
+
+struct VertexEqual {
+    const float* vertices;
+    size_t stride;
+    bool operator()(uint32_t a, uint32_t b) const {
+        return std::memcmp(vertices + a * stride, vertices + b * stride, stride * sizeof(float)) == 0;
+    }
+};
+}
+
+// meshes arrive as flat triangle lists, identical vertices are merged and
+// referenced through an index buffer instead
+static void buildIndexedMesh(const float* vertices, int count, int stride,
+                             std::vector<float>& unique, std::vector<uint32_t>& indices) {
+    size_t n = static_cast<size_t>(stride);
+    // source vertex -> index in unique
+    std::unordered_map<uint32_t, uint32_t, VertexHash, VertexEqual> seen(
+        count, VertexHash{vertices, n}, VertexEqual{vertices, n});
+    indices.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        auto [it, inserted] = seen.emplace(static_cast<uint32_t>(i), static_cast<uint32_t>(unique.size() / n));
+        if (inserted) {
+            const float* v = vertices + static_cast<size_t>(i) * n;
+            unique.insert(unique.end(), v, v + n);
+        }
+        indices.push_back(it->second);
+    }
+}
+
 Model::Model(float* vertices, size_t byte_cnt, int stride, ModelType type)
-    : type(type)
+    : type(type), stride(stride)
 {
-    vertexCount = byte_cnt / (stride * sizeof(float));
+    int count = byte_cnt / (stride * sizeof(float));
+
+    std::vector<float> unique;
+    std::vector<uint32_t> indices;
+    buildIndexedMesh(vertices, count, stride, unique, indices);
+    upload(unique, indices);
+}
+
+Model::Model(const std::vector<float>& vertices, const std::vector<uint32_t>& indices, int stride, ModelType type)
+    : type(type), stride(stride)
+{
+    upload(vertices, indices);
+}
+
+void Model::upload(const std::vector<float>& unique, const std::vector<uint32_t>& indices) {
+    indexCount = static_cast<int>(indices.size());
+    vertexCount = unique.size() / stride;
+    std::vector<float> positions;
+    positions.reserve(vertexCount * 3);
+    for (size_t i = 0; i + 2 < unique.size(); i += stride) {
+        bounds.expand(glm::vec3(unique[i], unique[i + 1], unique[i + 2]));
+        positions.insert(positions.end(), &unique[i], &unique[i] + 3);
+    }
+
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, byte_cnt, vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, unique.size() * sizeof(float), unique.data(), GL_STATIC_DRAW);
 
     bindAttributes(type, VAO, VBO, stride);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
     glBindVertexArray(0);
+
+    // 12 bytes per vertex instead of the full 12-40 byte layout, sharing the EBO
+    if (type == ModelType::BASIC) {
+        positionVBO = 0;
+        positionVAO = VAO;
+    } else {
+        glGenBuffers(1, &positionVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW);
+        positionVAO = CreateVAO(ModelType::BASIC, positionVBO, EBO);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Model::readBack(std::vector<float>& vertices, std::vector<uint32_t>& indices) const {
+    vertices.resize(static_cast<size_t>(vertexCount) * stride);
+    indices.resize(indexCount);
+    // the copy target leaves the array and VAO bindings alone
+    glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, EBO);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, indices.size() * sizeof(uint32_t), indices.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
 }
 
 Model::~Model() {
+    if (positionVAO != VAO) glDeleteVertexArrays(1, &positionVAO);
+    if (positionVBO) glDeleteBuffers(1, &positionVBO);
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
 }
 
 void Model::draw(GLenum mode) {
     glBindVertexArray(VAO);
-    glDrawArrays(mode, 0, vertexCount);
+    glDrawElements(mode, indexCount, GL_UNSIGNED_INT, (GLvoid*)0);
     glBindVertexArray(0);
 }
 
+void Model::drawPositions(GLenum mode) {
+    glBindVertexArray(positionVAO);
+    glDrawElements(mode, indexCount, GL_UNSIGNED_INT, (GLvoid*)0);
+    glBindVertexArray(0);
+}
+
+void Model::drawInstanced(int instanceCount, GLenum mode) {
+    drawInstancedVAO(VAO, instanceCount, mode);
+}
+
+void Model::drawInstancedVAO(GLuint instancedVAO, int instanceCount, GLenum mode) {
+    glBindVertexArray(instancedVAO);
+    glDrawElementsInstanced(mode, indexCount, GL_UNSIGNED_INT, (GLvoid*)0, instanceCount);
+    glBindVertexArray(0);
+}
+
+GLuint Model::CreateVAO(ModelType type, GLuint vbo, GLuint ebo) {
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    bindAttributes(type, vao, vbo, 0);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBindVertexArray(0);
+    return vao;
+}
+
+GLuint Model::createInstancedVAO(GLuint instanceBuffer, bool positionsOnly) const {
+    GLuint instancedVAO = positionsOnly && positionVBO ? CreateVAO(ModelType::BASIC, positionVBO, EBO)
+                                                       : CreateVAO(type, VBO, EBO);
+
+    glBindVertexArray(instancedVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+    // per instance: mat4 model followed by the normal matrix as three vec4 columns
+    GLsizei instanceStride = 7 * 4 * sizeof(float);
+    for (int col = 0; col < 7; ++col) {
+        GLuint loc = 4 + col;
+        glEnableVertexAttribArray(loc);
+        glVertexAttribPointer(loc, col < 4 ? 4 : 3, GL_FLOAT, GL_FALSE, instanceStride,
+                              (GLvoid*)(col * 4 * sizeof(float)));
+        glVertexAttribDivisor(loc, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return instancedVAO;
+}
+
 std::unique_ptr<Model> Model::LoadFromHeader(float* vertices, size_t size, int stride, ModelType type) {
     return std::make_unique<Model>(vertices, size, stride, type);
 }
 
-std::unique_ptr<Model> Model::LoadFromFile(const std::string& path, ModelType type) {
+bool Model::ReadMeshFile(const std::string& path, ModelType type, std::vector<float>& data, int& stride) {
     Assimp::Importer importer;
     unsigned int importOptions =
         aiProcess_Triangulate |
@@ -135,26 +287,40 @@ std::unique_ptr<Model> Model::LoadFromFile(const std::string& path, ModelType ty
     const aiScene* scene = importer.ReadFile(path, importOptions);
     if (!scene || !scene->HasMeshes()) {
         std::cerr << "Assimp load failed: " << path << std::endl;
-        return nullptr;
+        return false;
     }
 
     aiMesh* mesh = scene->mMeshes[0];
-    std::vector<float> data;
 
     bool includeUV = (type == ModelType::UV || type == ModelType::TAN);
     bool includeTangent = (type == ModelType::TAN);
 
-    int stride =
+    stride =
         type == ModelType::BASIC ? 3 :
         type == ModelType::NORMAL ? 6 :
         type == ModelType::UV ? 8 :
         type == ModelType::TAN ? 10 : 0;
 
+    data.clear();
     data.reserve(mesh->mNumFaces * 3 * stride);
     extractMeshData(mesh, data, includeUV, includeTangent);
 
     if (data.empty()) {
         std::cerr << "No vertex data loaded from: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Model> Model::LoadFromFile(const std::string& path, ModelType type) {
+    std::vector<float> data;
+    int stride = 0;
+
+    std::shared_ptr<MeshData> prefetched = AssetCache::instance().takeMesh(path, type);
+    if (prefetched) {
+        data = std::move(prefetched->vertices);
+        stride = prefetched->stride;
+    } else if (!ReadMeshFile(path, type, data, stride)) {
         return nullptr;
     }
 
@@ -1,7 +1,11 @@
 #pragma once
 #include <GL/glew.h>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+#include "spatial/Bounds.hpp"
 
 enum class ModelType {
     BASIC,
@@ -10,19 +14,58 @@ enum class ModelType {
     TAN
 };
 
+// a mesh file and the layout to read it with
+using ModelFile = std::pair<std::string, ModelType>;
+
 class Model {
 public:
     Model(float* vertices, size_t size, int stride, ModelType type = ModelType::NORMAL);
+    // already indexed vertices, e.g. merged meshes
+    Model(const std::vector<float>& vertices, const std::vector<uint32_t>& indices, int stride, ModelType type);
     ~Model();
 
     void draw(GLenum mode = GL_TRIANGLES);
+    // positions only, for depth and picking passes that don't need the other attributes
+    void drawPositions(GLenum mode = GL_TRIANGLES);
+    void drawInstanced(int instanceCount, GLenum mode = GL_TRIANGLES);
+    // same mesh through a VAO from createInstancedVAO
+    void drawInstancedVAO(GLuint instancedVAO, int instanceCount, GLenum mode = GL_TRIANGLES);
+    // new VAO sharing this mesh's buffers, with per-instance model (locations 4-7)
+    // and normal matrices (8-10) read from instanceBuffer; the caller deletes it.
+    // with positionsOnly the mesh side reads the position stream instead
+    GLuint createInstancedVAO(GLuint instanceBuffer, bool positionsOnly = false) const;
     static std::unique_ptr<Model> LoadFromHeader(float* vertices, size_t size, int stride, ModelType type = ModelType::NORMAL);
     static std::unique_ptr<Model> LoadFromFile(const std::string& path, ModelType type = ModelType::NORMAL);
+    static std::unique_ptr<Model> LoadFromFile(const ModelFile& file) { return LoadFromFile(file.first, file.second); }
+    // no GL calls, safe to run on a worker thread
+    static bool ReadMeshFile(const std::string& path, ModelType type, std::vector<float>& data, int& stride);
     ModelType getType() const { return type; }
+    GLuint getVAO() const { return VAO; }
+    GLuint getVBO() const { return VBO; }
+    GLuint getEBO() const { return EBO; }
+    // tightly packed vec3 positions at location 0, indexed by the same EBO
+    GLuint getPositionVAO() const { return positionVAO; }
+    int getVertexCount() const { return vertexCount; }
+    int getIndexCount() const { return indexCount; }
+    int getStride() const { return stride; }
+    // object space bounds of the vertex positions
+    const Aabb& getBounds() const { return bounds; }
+    // VAO reading vertices of the given layout from vbo and indices from ebo
+    static GLuint CreateVAO(ModelType type, GLuint vbo, GLuint ebo);
+    // copies the indexed mesh back from the GPU, stalls, meant for build time
+    void readBack(std::vector<float>& vertices, std::vector<uint32_t>& indices) const;
 
 private:
     GLuint VAO;
     GLuint VBO;
+    GLuint EBO;
+    GLuint positionVAO;
+    GLuint positionVBO;
     int vertexCount;
+    int indexCount;
     ModelType type;
+    int stride;
+    Aabb bounds;
+
+    void upload(const std::vector<float>& vertices, const std::vector<uint32_t>& indices);
 };
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+const float TWO_PI = 6.28318530718f;
+
+// integer mix with full avalanche, for turning seeds and coordinates into
+// well spread bits
+inline uint32_t hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// tiny LCG behind a hash, good enough for placement and fully reproducible
+struct SeededRandom {
+    uint32_t state;
+
+    // uniform in [0, 1)
+    float next() {
+        state = state * 1664525u + 1013904223u;
+        return (hash(state) >> 8) * (1.0f / 16777216.0f);
+    }
+};
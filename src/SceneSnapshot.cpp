@@ -0,0 +1,256 @@
+#include "SceneSnapshot.hpp"
+#include "renderers/Light.hpp"
+#include "renderers/Material.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char MAGIC[4] = {'K', 'M', 'S', 'S'};
+
+size_t alignUp(size_t offset) {
+    return (offset + 15) & ~static_cast<size_t>(15);
+}
+
+const size_t RECORD_SIZES[Snapshot::SECTION_COUNT] = {
+    1,
+    sizeof(Snapshot::ObjectRecord),
+    sizeof(Snapshot::LightRecord),
+    sizeof(Snapshot::PathRecord),
+    sizeof(Snapshot::PointRecord),
+    sizeof(Snapshot::BlockRecord),
+    1
+};
+}
+
+uint32_t SceneSnapshotWriter::addString(const std::string& s) {
+    if (s.empty()) return Snapshot::NO_STRING;
+    auto it = stringOffsets.find(s);
+    if (it != stringOffsets.end()) return it->second;
+    uint32_t offset = static_cast<uint32_t>(strings.size());
+    strings.insert(strings.end(), s.begin(), s.end());
+    strings.push_back('\0');
+    stringOffsets.emplace(s, offset);
+    return offset;
+}
+
+void SceneSnapshotWriter::addObject(uint32_t tag, const std::string& model, const std::string& texture,
+                                    const glm::mat4& matrix, const Material& material, uint32_t layers,
+                                    uint32_t pickId) {
+    Snapshot::ObjectRecord record{};
+    record.tag = tag;
+    record.model = addString(model);
+    record.texture = addString(texture);
+    record.layers = layers;
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) record.matrix[c * 4 + r] = matrix[c][r];
+    }
+    record.material[0] = material.getShininess();
+    record.material[1] = material.getAmbient();
+    record.material[2] = material.getDiffuse();
+    record.material[3] = material.getSpecular();
+    record.pickId = pickId;
+    objects.push_back(record);
+}
+
+void SceneSnapshotWriter::addLight(const Light& light) {
+    Snapshot::LightRecord record{};
+    record.type = static_cast<uint32_t>(light.getType());
+    glm::vec3 position = light.getPosition();
+    glm::vec3 direction = light.getDirection();
+    glm::vec3 color = light.getColor();
+    for (int i = 0; i < 3; ++i) {
+        record.position[i] = position[i];
+        record.direction[i] = direction[i];
+        record.color[i] = color[i];
+    }
+    record.ambient = light.getAmbient();
+    record.diffuse = light.getDiffuse();
+    record.specular = light.getSpecular();
+    record.cutOff = light.getCutOff();
+    record.outerCutOff = light.getOuterCutOff();
+    record.constant = light.getConstant();
+    record.linear = light.getLinear();
+    record.quadratic = light.getQuadratic();
+    lights.push_back(record);
+}
+
+void SceneSnapshotWriter::addPath(uint32_t tag, const std::vector<glm::vec3>& pathPoints) {
+    paths.push_back({tag, static_cast<uint32_t>(points.size()), static_cast<uint32_t>(pathPoints.size()), 0});
+    for (const glm::vec3& p : pathPoints) points.push_back({{p.x, p.y, p.z}});
+}
+
+void SceneSnapshotWriter::addBlock(uint32_t tag, const void* data, size_t size) {
+    uint32_t offset = static_cast<uint32_t>(alignUp(bytes.size()));
+    bytes.resize(offset + size);
+    if (size) std::memcpy(bytes.data() + offset, data, size);
+    blocks.push_back({tag, offset, static_cast<uint32_t>(size), 0});
+}
+
+bool SceneSnapshotWriter::write(const std::string& path) const {
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, error);
+
+    Snapshot::Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = Snapshot::VERSION;
+
+    const void* sources[Snapshot::SECTION_COUNT] = {strings.data(), objects.data(), lights.data(), paths.data(),
+                                                    points.data(), blocks.data(), bytes.data()};
+    size_t counts[Snapshot::SECTION_COUNT] = {strings.size(), objects.size(), lights.size(), paths.size(),
+                                              points.size(), blocks.size(), bytes.size()};
+    size_t offset = alignUp(sizeof(header));
+    for (int s = 0; s < Snapshot::SECTION_COUNT; ++s) {
+        header.sections[s] = {static_cast<uint32_t>(offset), static_cast<uint32_t>(counts[s])};
+        offset = alignUp(offset + counts[s] * RECORD_SIZES[s]);
+    }
+    header.byteSize = static_cast<uint32_t>(offset);
+
+    std::vector<unsigned char> bytes(offset, 0);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    for (int s = 0; s < Snapshot::SECTION_COUNT; ++s) {
+        if (counts[s]) std::memcpy(bytes.data() + header.sections[s].offset, sources[s], counts[s] * RECORD_SIZES[s]);
+    }
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out) {
+            std::cerr << "Can't write scene snapshot " << tmpPath << "!!!" << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Can't replace scene snapshot " << path << "!!!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<SceneSnapshot> SceneSnapshot::Open(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "No scene snapshot at " << path << "!!!" << std::endl;
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Snapshot::Header)) {
+        close(fd);
+        std::cerr << "Scene snapshot " << path << " is too small!!!" << std::endl;
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file alive on its own
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Can't map scene snapshot " << path << "!!!" << std::endl;
+        return nullptr;
+    }
+
+    std::unique_ptr<SceneSnapshot> snapshot(new SceneSnapshot(static_cast<const unsigned char*>(mapped), size));
+    if (!snapshot->validate()) {
+        std::cerr << "Scene snapshot " << path << " is not a version " << Snapshot::VERSION << " snapshot!!!"
+                  << std::endl;
+        return nullptr;
+    }
+    return snapshot;
+}
+
+SceneSnapshot::~SceneSnapshot() {
+    if (data) munmap(const_cast<unsigned char*>(data), size);
+}
+
+bool SceneSnapshot::validate() const {
+    const Snapshot::Header& h = header();
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != Snapshot::VERSION || h.byteSize != size) {
+        return false;
+    }
+    for (int s = 0; s < Snapshot::SECTION_COUNT; ++s) {
+        const Snapshot::SectionRange& range = h.sections[s];
+        if (range.offset % 16 != 0 || range.offset < sizeof(Snapshot::Header) || range.offset > size ||
+            range.count > (size - range.offset) / RECORD_SIZES[s]) {
+            return false;
+        }
+    }
+
+    // references are checked once here so the accessors can trust them
+    size_t stringBytes = count(Snapshot::STRINGS);
+    const char* strings = records<char>(Snapshot::STRINGS);
+    if (stringBytes > 0 && strings[stringBytes - 1] != '\0') return false;
+    auto validString = [&](uint32_t offset) { return offset == Snapshot::NO_STRING || offset < stringBytes; };
+    for (size_t i = 0; i < objectCount(); ++i) {
+        if (!validString(objects()[i].model) || !validString(objects()[i].texture)) return false;
+    }
+    size_t pointCount = count(Snapshot::POINTS);
+    for (size_t i = 0; i < pathCount(); ++i) {
+        const Snapshot::PathRecord& p = paths()[i];
+        if (p.first > pointCount || p.count > pointCount - p.first) return false;
+    }
+    size_t byteCount = count(Snapshot::BYTES);
+    for (size_t i = 0; i < count(Snapshot::BLOCKS); ++i) {
+        const Snapshot::BlockRecord& b = records<Snapshot::BlockRecord>(Snapshot::BLOCKS)[i];
+        if (b.offset % 16 != 0 || b.offset > byteCount || b.size > byteCount - b.offset) return false;
+    }
+    return true;
+}
+
+const char* SceneSnapshot::string(uint32_t offset) const {
+    if (offset == Snapshot::NO_STRING) return "";
+    return records<char>(Snapshot::STRINGS) + offset;
+}
+
+std::vector<glm::vec3> SceneSnapshot::pathPoints(const Snapshot::PathRecord& path) const {
+    const Snapshot::PointRecord* points = records<Snapshot::PointRecord>(Snapshot::POINTS) + path.first;
+    std::vector<glm::vec3> out;
+    out.reserve(path.count);
+    for (uint32_t i = 0; i < path.count; ++i) {
+        out.emplace_back(points[i].position[0], points[i].position[1], points[i].position[2]);
+    }
+    return out;
+}
+
+const void* SceneSnapshot::block(uint32_t tag, size_t& blockSize) const {
+    const Snapshot::BlockRecord* blocks = records<Snapshot::BlockRecord>(Snapshot::BLOCKS);
+    for (size_t i = 0; i < count(Snapshot::BLOCKS); ++i) {
+        if (blocks[i].tag != tag) continue;
+        blockSize = blocks[i].size;
+        return records<unsigned char>(Snapshot::BYTES) + blocks[i].offset;
+    }
+    blockSize = 0;
+    return nullptr;
+}
+
+glm::mat4 SceneSnapshot::Matrix(const Snapshot::ObjectRecord& object) {
+    glm::mat4 m;
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) m[c][r] = object.matrix[c * 4 + r];
+    }
+    return m;
+}
+
+Material SceneSnapshot::MaterialOf(const Snapshot::ObjectRecord& object) {
+    return Material(object.material[0], object.material[1], object.material[2], object.material[3]);
+}
+
+void SceneSnapshot::Apply(const Snapshot::LightRecord& record, Light& light) {
+    light.setPosition(glm::vec3(record.position[0], record.position[1], record.position[2]));
+    light.setDirection(glm::vec3(record.direction[0], record.direction[1], record.direction[2]));
+    light.setColor(glm::vec3(record.color[0], record.color[1], record.color[2]));
+    light.setAmbient(record.ambient);
+    light.setDiffuse(record.diffuse);
+    light.setSpecular(record.specular);
+    light.setCutOff(record.cutOff);
+    light.setOuterCutOff(record.outerCutOff);
+    light.setConstant(record.constant);
+    light.setLinear(record.linear);
+    light.setQuadratic(record.quadratic);
+}
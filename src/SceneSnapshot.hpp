@@ -0,0 +1,168 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Light;
+class Material;
+
+// flat binary dump of a scene's state. every section is an array of plain
+// records at a 16 byte aligned offset, so a snapshot is used straight from a
+// read-only mapping of the file: opening it checks the header and the
+// section bounds and nothing is parsed or copied. assets are referenced by
+// path through the string section, the scene resolves them to its models.
+// generated bulk data (heights, placements) goes into tagged blocks of raw
+// bytes that the scene reads in place instead of generating it again.
+// native byte order, a snapshot is a cache of this machine's scene
+namespace Snapshot {
+constexpr uint32_t VERSION = 2;
+// no asset
+constexpr uint32_t NO_STRING = UINT32_MAX;
+
+enum Section : uint32_t {
+    STRINGS,
+    OBJECTS,
+    LIGHTS,
+    PATHS,
+    POINTS,
+    BLOCKS,
+    // raw bytes of the blocks, 1 per record
+    BYTES,
+    SECTION_COUNT
+};
+
+struct SectionRange {
+    uint32_t offset;
+    uint32_t count;
+};
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteSize;
+    uint32_t reserved;
+    SectionRange sections[SECTION_COUNT];
+};
+
+// tag says what the object is to the scene that wrote it
+struct ObjectRecord {
+    uint32_t tag;
+    // string offsets
+    uint32_t model;
+    uint32_t texture;
+    uint32_t layers;
+    float matrix[16];
+    // shininess, ambient, diffuse, specular
+    float material[4];
+    uint32_t pickId;
+    uint32_t reserved[3];
+};
+
+struct LightRecord {
+    uint32_t type;
+    float position[3];
+    float direction[3];
+    float color[3];
+    float ambient;
+    float diffuse;
+    float specular;
+    float cutOff;
+    float outerCutOff;
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+// a run of POINTS, e.g. the control points of a curve
+struct PathRecord {
+    uint32_t tag;
+    uint32_t first;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct PointRecord {
+    float position[3];
+};
+
+// offset into BYTES, 16 byte aligned like the sections
+struct BlockRecord {
+    uint32_t tag;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t reserved;
+};
+}
+
+class SceneSnapshotWriter {
+public:
+    // empty path means no asset
+    void addObject(uint32_t tag, const std::string& model, const std::string& texture, const glm::mat4& matrix,
+                   const Material& material, uint32_t layers, uint32_t pickId = 0);
+    void addLight(const Light& light);
+    void addPath(uint32_t tag, const std::vector<glm::vec3>& points);
+    // copied now, so data may go away before write()
+    void addBlock(uint32_t tag, const void* data, size_t size);
+
+    // goes through a temporary file, so an open mapping of the old snapshot stays valid
+    bool write(const std::string& path) const;
+
+private:
+    std::vector<char> strings;
+    std::unordered_map<std::string, uint32_t> stringOffsets;
+    std::vector<Snapshot::ObjectRecord> objects;
+    std::vector<Snapshot::LightRecord> lights;
+    std::vector<Snapshot::PathRecord> paths;
+    std::vector<Snapshot::PointRecord> points;
+    std::vector<Snapshot::BlockRecord> blocks;
+    std::vector<unsigned char> bytes;
+
+    uint32_t addString(const std::string& s);
+};
+
+// read-only mapping of a snapshot file, the records point into it
+class SceneSnapshot {
+public:
+    // nullptr when the file is missing or doesn't check out
+    static std::unique_ptr<SceneSnapshot> Open(const std::string& path);
+    ~SceneSnapshot();
+    SceneSnapshot(const SceneSnapshot&) = delete;
+    SceneSnapshot& operator=(const SceneSnapshot&) = delete;
+
+    const Snapshot::ObjectRecord* objects() const { return records<Snapshot::ObjectRecord>(Snapshot::OBJECTS); }
+    size_t objectCount() const { return count(Snapshot::OBJECTS); }
+    const Snapshot::LightRecord* lights() const { return records<Snapshot::LightRecord>(Snapshot::LIGHTS); }
+    size_t lightCount() const { return count(Snapshot::LIGHTS); }
+    const Snapshot::PathRecord* paths() const { return records<Snapshot::PathRecord>(Snapshot::PATHS); }
+    size_t pathCount() const { return count(Snapshot::PATHS); }
+
+    // empty for NO_STRING
+    const char* string(uint32_t offset) const;
+    std::vector<glm::vec3> pathPoints(const Snapshot::PathRecord& path) const;
+    // the first block with tag, nullptr when there is none; points into the mapping
+    const void* block(uint32_t tag, size_t& size) const;
+
+    static glm::mat4 Matrix(const Snapshot::ObjectRecord& object);
+    static Material MaterialOf(const Snapshot::ObjectRecord& object);
+    // position, direction, color and the light terms; the type is not
+    // changed, callers only apply records whose type matches the light
+    static void Apply(const Snapshot::LightRecord& record, Light& light);
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+    SceneSnapshot(const unsigned char* data, size_t size) : data(data), size(size) {}
+
+    const Snapshot::Header& header() const { return *reinterpret_cast<const Snapshot::Header*>(data); }
+    size_t count(Snapshot::Section s) const { return header().sections[s].count; }
+    template <typename T>
+    const T* records(Snapshot::Section s) const {
+        return reinterpret_cast<const T*>(data + header().sections[s].offset);
+    }
+    bool validate() const;
+};
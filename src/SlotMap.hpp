@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// stable reference into a SlotMap; a removed value bumps its slot's
+// generation, so old handles to it stop resolving instead of aliasing
+// whatever takes the slot next
+struct SlotHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool isValid() const { return slot != UINT32_MAX; }
+    bool operator==(const SlotHandle& o) const { return slot == o.slot && generation == o.generation; }
+    bool operator!=(const SlotHandle& o) const { return !(*this == o); }
+};
+
+// values live packed in one vector in no particular order, handles go
+// through a slot table to find them; add and remove are O(1), removal moves
+// the last value into the hole
+template <typename T>
+class SlotMap {
+public:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    SlotHandle insert(T value) {
+        uint32_t slot;
+        if (freeSlots.empty()) {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back({0, 0});
+        } else {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        slots[slot].dense = static_cast<uint32_t>(values.size());
+        values.push_back(std::move(value));
+        denseToSlot.push_back(slot);
+        return {slot, slots[slot].generation};
+    }
+
+    // dense index the value had, NONE for a stale handle; the value that
+    // was last before the call now sits at that index
+    size_t remove(SlotHandle h) {
+        size_t idx = indexOf(h);
+        if (idx == NONE) return NONE;
+
+        size_t last = values.size() - 1;
+        if (idx != last) {
+            values[idx] = std::move(values[last]);
+            denseToSlot[idx] = denseToSlot[last];
+            slots[denseToSlot[idx]].dense = static_cast<uint32_t>(idx);
+        }
+        values.pop_back();
+        denseToSlot.pop_back();
+
+        ++slots[h.slot].generation;
+        freeSlots.push_back(h.slot);
+        return idx;
+    }
+
+    bool contains(SlotHandle h) const { return indexOf(h) != NONE; }
+
+    size_t indexOf(SlotHandle h) const {
+        if (h.slot >= slots.size() || slots[h.slot].generation != h.generation) return NONE;
+        return slots[h.slot].dense;
+    }
+
+    SlotHandle handleAt(size_t idx) const {
+        uint32_t slot = denseToSlot[idx];
+        return {slot, slots[slot].generation};
+    }
+
+    T* get(SlotHandle h) {
+        size_t idx = indexOf(h);
+        return idx == NONE ? nullptr : &values[idx];
+    }
+
+    const T* get(SlotHandle h) const {
+        size_t idx = indexOf(h);
+        return idx == NONE ? nullptr : &values[idx];
+    }
+
+    void reserve(size_t count) {
+        values.reserve(count);
+        denseToSlot.reserve(count);
+        slots.reserve(count);
+    }
+
+    void clear() {
+        for (uint32_t slot : denseToSlot) {
+            ++slots[slot].generation;
+            freeSlots.push_back(slot);
+        }
+        values.clear();
+        denseToSlot.clear();
+    }
+
+    // dense access, indices are only stable until the next remove
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+    T& operator[](size_t idx) { return values[idx]; }
+    const T& operator[](size_t idx) const { return values[idx]; }
+    T& back() { return values.back(); }
+    typename std::vector<T>::iterator begin() { return values.begin(); }
+    typename std::vector<T>::iterator end() { return values.end(); }
+    typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+    typename std::vector<T>::const_iterator end() const { return values.end(); }
+    const std::vector<T>& dense() const { return values; }
+
+private:
+    struct Slot {
+        uint32_t dense;
+        uint32_t generation;
+    };
+
+    std::vector<T> values;
+    std::vector<uint32_t> denseToSlot;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+};
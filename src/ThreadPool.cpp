@@ -0,0 +1,79 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int workerCount) {
+    if (workerCount == 0) {
+        unsigned int hw = std::thread::hardware_concurrency();
+        workerCount = hw > 1 ? hw - 1 : 1;
+    }
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    cond.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    cond.notify_one();
+}
+
+void ThreadPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.clear();
+}
+
+void ThreadPool::parallelFor(int count, int minChunk, const std::function<void(int, int)>& body) {
+    int maxChunks = static_cast<int>(workers.size()) + 1;
+    int chunks = std::min(maxChunks, (count + minChunk - 1) / std::max(minChunk, 1));
+    if (chunks <= 1) {
+        if (count > 0) body(0, count);
+        return;
+    }
+
+    int chunkSize = (count + chunks - 1) / chunks;
+    std::mutex doneMutex;
+    std::condition_variable doneCond;
+    int remaining = chunks - 1;
+
+    for (int c = 1; c < chunks; ++c) {
+        int begin = c * chunkSize;
+        int end = std::min(count, begin + chunkSize);
+        enqueue([&, begin, end]() {
+            if (begin < end) body(begin, end);
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (--remaining == 0) doneCond.notify_one();
+        });
+    }
+    body(0, std::min(count, chunkSize));
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCond.wait(lock, [&] { return remaining == 0; });
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int workerCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> job);
+    void clear();
+    // splits [0, count) into chunks of at least minChunk items, runs one chunk
+    // on the calling thread and returns once all of them are done
+    void parallelFor(int count, int minChunk, const std::function<void(int, int)>& body);
+    unsigned int getWorkerCount() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool stopping = false;
+
+    void workerLoop();
+};
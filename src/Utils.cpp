@@ -1,6 +1,7 @@
 #include "Utils.hpp"
+#include "AssetCache.hpp"
 
-std::string loadShaderSrc(const std::string& path) {
+std::string readTextFile(const std::string& path) {
     std::ifstream file(path);
     if (!file.is_open()) {
         std::cerr << "Failed to open shader file!!! " << path << "\n";
@@ -10,3 +11,11 @@ std::string loadShaderSrc(const std::string& path) {
     buffer << file.rdbuf();
     return buffer.str();
 }
+
+std::string loadShaderSrc(const std::string& path) {
+    std::shared_ptr<std::string> prefetched = AssetCache::instance().takeShaderSrc(path);
+    if (prefetched) {
+        return std::move(*prefetched);
+    }
+    return readTextFile(path);
+}
@@ -4,4 +4,5 @@
 #include <sstream>
 #include <iostream>
 
+std::string readTextFile(const std::string& path);
 std::string loadShaderSrc(const std::string& path);
@@ -0,0 +1,136 @@
+// dynamic TransformComposite vs StaticComposite vs the SoA TransformPool for
+// the bush/tree shape, built with -DKMS_BUILD_BENCH=ON, no GL context needed
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../trans/TransformComposite.hpp"
+#include "../trans/StaticComposite.hpp"
+#include "../trans/TransformPool.hpp"
+#include "../ThreadPool.hpp"
+
+static const int OBJECT_COUNT = 10000;
+static const int FRAMES = 200;
+
+// keeps the optimizer from dropping the matrix reads
+static float sink = 0.0f;
+
+template <typename F>
+static double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Sample {
+    glm::vec3 pos;
+    float angle;
+    float scale;
+};
+
+static void report(const char* name, double buildMs, double evalMs) {
+    double nsPerEval = evalMs * 1e6 / (static_cast<double>(OBJECT_COUNT) * FRAMES);
+    std::cout << name << ": build " << buildMs << " ms, "
+              << nsPerEval << " ns per rotated matrix" << std::endl;
+}
+
+static void benchDynamic(const std::vector<Sample>& samples) {
+    std::vector<std::shared_ptr<TransformComposite>> composites;
+    std::vector<std::shared_ptr<TransformRotation>> rotations;
+
+    double buildMs = timeMs([&] {
+        for (const auto& s : samples) {
+            auto rotation = std::make_shared<TransformRotation>(s.angle, glm::vec3(0.0f, 1.0f, 0.0f));
+            auto t = std::make_shared<TransformComposite>();
+            t->add(std::make_shared<TransformTranslation>(s.pos));
+            t->add(rotation);
+            t->add(std::make_shared<TransformScale>(glm::vec3(s.scale)));
+            composites.push_back(t);
+            rotations.push_back(rotation);
+        }
+    });
+
+    double evalMs = timeMs([&] {
+        for (int frame = 0; frame < FRAMES; ++frame) {
+            for (size_t i = 0; i < composites.size(); ++i) {
+                rotations[i]->setAngle(samples[i].angle + frame);
+                sink += composites[i]->getMatrix()[3][0];
+            }
+        }
+    });
+
+    report("TransformComposite", buildMs, evalMs);
+}
+
+static void benchStatic(const std::vector<Sample>& samples) {
+    std::vector<std::shared_ptr<TransformTRS>> composites;
+
+    double buildMs = timeMs([&] {
+        for (const auto& s : samples) {
+            composites.push_back(std::make_shared<TransformTRS>(
+                TransformTranslation(s.pos),
+                TransformRotation(s.angle, glm::vec3(0.0f, 1.0f, 0.0f)),
+                TransformScale(glm::vec3(s.scale))
+            ));
+        }
+    });
+
+    double evalMs = timeMs([&] {
+        for (int frame = 0; frame < FRAMES; ++frame) {
+            for (size_t i = 0; i < composites.size(); ++i) {
+                composites[i]->get<1>().setAngle(samples[i].angle + frame);
+                sink += composites[i]->getMatrix()[3][0];
+            }
+        }
+    });
+
+    report("StaticComposite", buildMs, evalMs);
+}
+
+// every matrix is rebuilt in update(), then read back the way the renderer does
+static void benchPool(const std::vector<Sample>& samples, ThreadPool* workers, const char* name) {
+    TransformPool pool;
+    pool.setWorkers(workers);
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+    double buildMs = timeMs([&] {
+        pool.reserve(samples.size());
+        for (const auto& s : samples) {
+            pool.add(s.pos, glm::angleAxis(glm::radians(s.angle), up), glm::vec3(s.scale));
+        }
+        pool.update();
+    });
+
+    double evalMs = timeMs([&] {
+        for (int frame = 0; frame < FRAMES; ++frame) {
+            for (uint32_t i = 0; i < samples.size(); ++i) {
+                pool.setRotation(i, glm::angleAxis(glm::radians(samples[i].angle + frame), up));
+            }
+            pool.update();
+            for (uint32_t i = 0; i < samples.size(); ++i) sink += pool.getWorld(i)[3][0];
+        }
+    });
+
+    report(name, buildMs, evalMs);
+}
+
+int main() {
+    std::srand(1234);
+    std::vector<Sample> samples(OBJECT_COUNT);
+    for (auto& s : samples) {
+        s.pos = glm::vec3(((rand() % 400) / 10.0f) - 20.0f, -1.0f, ((rand() % 400) / 10.0f) - 20.0f);
+        s.angle = static_cast<float>(rand() % 360);
+        s.scale = 0.3f + ((rand() % 50) / 100.0f);
+    }
+
+    std::cout << OBJECT_COUNT << " objects, " << FRAMES << " frames" << std::endl;
+    benchDynamic(samples);
+    benchStatic(samples);
+    std::cout << "TransformPool kernel: " << TransformPool::getKernelName() << std::endl;
+    benchPool(samples, nullptr, "TransformPool");
+    ThreadPool workers;
+    benchPool(samples, &workers, "TransformPool threaded");
+    std::cout << "(checksum " << sink << ")" << std::endl;
+    return 0;
+}
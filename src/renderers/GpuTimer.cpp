@@ -0,0 +1,48 @@
+#include "GpuTimer.hpp"
+
+GpuTimer::~GpuTimer() {
+    if (queries[0]) glDeleteQueries(RING, queries);
+}
+
+void GpuTimer::collect() {
+    for (int i = 0; i < RING; ++i) {
+        if (!pending[i]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &ns);
+        totalNs += static_cast<double>(ns);
+        ++samples;
+        pending[i] = false;
+    }
+}
+
+void GpuTimer::begin() {
+    if (!queries[0]) glGenQueries(RING, queries);
+    collect();
+    // every slot still in flight, skip this frame rather than wait
+    if (pending[current]) return;
+    glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+    running = true;
+}
+
+void GpuTimer::end() {
+    if (!running) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    pending[current] = true;
+    running = false;
+    current = (current + 1) % RING;
+}
+
+void GpuTimer::reset() {
+    // results still in flight belong to the old setting
+    for (int i = 0; i < RING; ++i) {
+        if (!pending[i]) continue;
+        GLuint64 ns;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &ns);
+        pending[i] = false;
+    }
+    totalNs = 0.0;
+    samples = 0;
+}
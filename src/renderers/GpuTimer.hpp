@@ -0,0 +1,32 @@
+#pragma once
+#include <GL/glew.h>
+
+// GL_TIME_ELAPSED queries in a small ring, so results are read a few frames
+// late instead of stalling on the current one; keeps a running average
+class GpuTimer {
+public:
+    GpuTimer() = default;
+    ~GpuTimer();
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin();
+    void end();
+
+    // average of the collected frames in milliseconds, 0 before the first result
+    float getAverageMs() const { return samples ? static_cast<float>(totalNs / samples) * 1e-6f : 0.0f; }
+    int getSampleCount() const { return samples; }
+    void reset();
+
+private:
+    static constexpr int RING = 4;
+
+    GLuint queries[RING] = {};
+    bool pending[RING] = {};
+    int current = 0;
+    bool running = false;
+    double totalNs = 0.0;
+    int samples = 0;
+
+    void collect();
+};
@@ -0,0 +1,90 @@
+#include "HiZPyramid.hpp"
+#include <algorithm>
+#include <iostream>
+
+HiZPyramid::HiZPyramid(Shader* reduceProgram) : program(reduceProgram) {
+    GLuint id = program->getID();
+    locations = {glGetUniformLocation(id, "depthSource"), glGetUniformLocation(id, "level"),
+                 glGetUniformLocation(id, "srcSize"), glGetUniformLocation(id, "dstSize")};
+}
+
+HiZPyramid::~HiZPyramid() {
+    release();
+}
+
+void HiZPyramid::release() {
+    if (depthFramebuffer) glDeleteFramebuffers(1, &depthFramebuffer);
+    if (depthCopy) glDeleteTextures(1, &depthCopy);
+    if (pyramid) glDeleteTextures(1, &pyramid);
+    depthFramebuffer = depthCopy = pyramid = 0;
+}
+
+void HiZPyramid::resize(int w, int h) {
+    release();
+    width = w;
+    height = h;
+    levels = 1;
+    while ((std::max(width, height) >> levels) > 0) ++levels;
+
+    // same format as the default framebuffer so the depth blit is allowed
+    glGenTextures(1, &depthCopy);
+    glBindTexture(GL_TEXTURE_2D, depthCopy);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenFramebuffers(1, &depthFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depthFramebuffer);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthCopy, 0);
+    if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Hi-Z depth framebuffer is incomplete!!!" << std::endl;
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+    glGenTextures(1, &pyramid);
+    glBindTexture(GL_TEXTURE_2D, pyramid);
+    glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void HiZPyramid::build(int w, int h) {
+    if (w <= 0 || h <= 0) return;
+    if (w != width || h != height) resize(w, h);
+
+    GLint drawFramebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, drawFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depthFramebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, drawFramebuffer);
+
+    program->use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthCopy);
+    glUniform1i(locations.depthSource, 0);
+
+    int srcW = width, srcH = height;
+    for (int level = 0; level < levels; ++level) {
+        int dstW = std::max(1, width >> level);
+        int dstH = std::max(1, height >> level);
+        glUniform1i(locations.level, level);
+        glUniform2i(locations.srcSize, srcW, srcH);
+        glUniform2i(locations.dstSize, dstW, dstH);
+        if (level > 0) {
+            glBindImageTexture(0, pyramid, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        }
+        glBindImageTexture(1, pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((dstW + 7) / 8, (dstH + 7) / 8, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        srcW = dstW;
+        srcH = dstH;
+    }
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "Shader.hpp"
+
+// max-depth mip chain of the depth buffer, built with a compute program
+// from hiz_compute.glsl; needs GL 4.3
+class HiZPyramid {
+public:
+    explicit HiZPyramid(Shader* reduceProgram);
+    ~HiZPyramid();
+    HiZPyramid(const HiZPyramid&) = delete;
+    HiZPyramid& operator=(const HiZPyramid&) = delete;
+
+    // copies the bound draw framebuffer's depth and reduces it level by level
+    void build(int width, int height);
+
+    GLuint getTexture() const { return pyramid; }
+    int getLevels() const { return levels; }
+    glm::vec2 getSize() const { return glm::vec2(width, height); }
+
+private:
+    Shader* program;
+    // set once per mip level, looked up when the pyramid is made
+    struct Locations {
+        GLint depthSource, level, srcSize, dstSize;
+    };
+    Locations locations;
+    GLuint depthCopy = 0;
+    GLuint depthFramebuffer = 0;
+    GLuint pyramid = 0;
+    int width = 0;
+    int height = 0;
+    int levels = 0;
+
+    void resize(int w, int h);
+    void release();
+};
@@ -0,0 +1,223 @@
+#include "Impostors.hpp"
+#include "Shader.hpp"
+#include "Texture.hpp"
+#include "../Model.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <iostream>
+
+namespace {
+// same basis as the billboards in impostor_vertex.glsl
+glm::vec3 frameUp(const glm::vec3& dir) {
+    return std::abs(dir.y) > 0.999f ? glm::vec3(0.0f, 0.0f, -1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+GLuint createAtlasTexture(int size) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // deeper levels would bleed neighbouring views into each other
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 3);
+    return texture;
+}
+}
+
+ImpostorAtlas::~ImpostorAtlas() {
+    if (albedo) glDeleteTextures(1, &albedo);
+    if (normalDepth) glDeleteTextures(1, &normalDepth);
+}
+
+glm::vec3 ImpostorAtlas::FrameDirection(const glm::vec2& grid) {
+    glm::vec2 e = grid * 2.0f - glm::vec2(1.0f);
+    glm::vec2 t((e.x + e.y) * 0.5f, (e.x - e.y) * 0.5f);
+    return glm::normalize(glm::vec3(t.x, 1.0f - std::abs(t.x) - std::abs(t.y), t.y));
+}
+
+bool ImpostorAtlas::bake(Model* model, Shader* bakeProgram, Texture* texture) {
+    if (!model || !bakeProgram) return false;
+    const Aabb& bounds = model->getBounds();
+    center = bounds.center();
+    radius = glm::length(bounds.extent());
+    if (radius <= 0.0f) {
+        std::cerr << "Impostor of an empty model!!!" << std::endl;
+        return false;
+    }
+
+    int size = FRAMES * FRAME_SIZE;
+    albedo = createAtlasTexture(size);
+    normalDepth = createAtlasTexture(size);
+
+    GLuint depthBuffer, framebuffer;
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalDepth, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    GLenum attachments[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, attachments);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete) {
+        std::cerr << "Impostor framebuffer is incomplete!!!" << std::endl;
+    } else {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        GLfloat clearColor[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+        // empty texels have zero coverage, the runtime weights by it
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        bakeProgram->use();
+        bakeProgram->SetUniform("projection", glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius));
+        bakeProgram->SetUniform("radius", radius);
+        bakeProgram->SetUniform("centerDepth", -2.0f * radius);
+        bakeProgram->SetUniform("useTexture", texture != nullptr);
+        if (texture) {
+            texture->bind(0);
+            bakeProgram->SetUniform("textureSampler", 0);
+        }
+
+        for (int y = 0; y < FRAMES; ++y) {
+            for (int x = 0; x < FRAMES; ++x) {
+                glm::vec3 dir = FrameDirection(glm::vec2(x, y) / static_cast<float>(FRAMES - 1));
+                glm::mat4 view = glm::lookAt(center + dir * 2.0f * radius, center, frameUp(dir));
+                bakeProgram->SetUniform("view", view);
+                glViewport(x * FRAME_SIZE, y * FRAME_SIZE, FRAME_SIZE, FRAME_SIZE);
+                model->draw(GL_TRIANGLES);
+            }
+        }
+
+        if (texture) texture->unbind();
+        glUseProgram(0);
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+
+    glBindTexture(GL_TEXTURE_2D, albedo);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, normalDepth);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return complete;
+}
+
+ImpostorRenderer::ImpostorRenderer() {
+    const float corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+    glGenBuffers(1, &quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ImpostorRenderer::~ImpostorRenderer() {
+    for (auto& b : batches) {
+        glDeleteVertexArrays(1, &b.vao);
+        glDeleteBuffers(1, &b.instanceBuffer);
+    }
+    glDeleteBuffers(1, &quadBuffer);
+}
+
+int ImpostorRenderer::addAtlas(std::unique_ptr<ImpostorAtlas> atlas) {
+    Batch b;
+    b.atlas = std::move(atlas);
+    glGenBuffers(1, &b.instanceBuffer);
+    glGenVertexArrays(1, &b.vao);
+    glBindVertexArray(b.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (GLvoid*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, b.instanceBuffer);
+    for (int i = 0; i < 2; ++i) {
+        glEnableVertexAttribArray(1 + i);
+        glVertexAttribPointer(1 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)(i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(1 + i, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    batches.push_back(std::move(b));
+    return static_cast<int>(batches.size()) - 1;
+}
+
+void ImpostorRenderer::add(int atlas, uint32_t group, const glm::vec3& position, float yawDeg, float scale,
+                           const glm::vec3& color) {
+    if (atlas < 0 || atlas >= static_cast<int>(batches.size())) {
+        std::cerr << "Impostor atlas " << atlas << " does not exist!!!" << std::endl;
+        return;
+    }
+    Batch& b = batches[atlas];
+    float yaw = glm::radians(yawDeg);
+    // the sphere follows the model's rotation about y, same as the mesh
+    glm::vec3 c = b.atlas->getCenter() * scale;
+    glm::vec3 rotated(std::cos(yaw) * c.x + std::sin(yaw) * c.z, c.y, -std::sin(yaw) * c.x + std::cos(yaw) * c.z);
+    b.instances.push_back({glm::vec4(position + rotated, b.atlas->getRadius() * scale), glm::vec4(color, yaw)});
+    b.groups.push_back(group);
+    b.dirty = true;
+}
+
+size_t ImpostorRenderer::size() const {
+    size_t total = 0;
+    for (const auto& b : batches) total += b.instances.size();
+    return total;
+}
+
+void ImpostorRenderer::draw(Shader& program, const std::vector<uint8_t>& groups, const glm::mat4& view,
+                            const glm::mat4& projection, const glm::vec3& viewPos) {
+    bool groupsChanged = groups != lastGroups;
+    if (groupsChanged) lastGroups = groups;
+
+    program.use();
+    program.SetUniform("view", view);
+    program.SetUniform("projection", projection);
+    program.SetUniform("viewPos", viewPos);
+    program.SetUniform("frames", ImpostorAtlas::FRAMES);
+    program.SetUniform("albedoAtlas", 0);
+    program.SetUniform("normalDepthAtlas", 1);
+
+    for (auto& b : batches) {
+        // the instances never move, the buffer changes only with the groups
+        if (groupsChanged || b.dirty) {
+            b.upload.clear();
+            for (size_t i = 0; i < b.instances.size(); ++i) {
+                uint32_t g = b.groups[i];
+                if (g < groups.size() && groups[g]) b.upload.push_back(b.instances[i]);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, b.instanceBuffer);
+            if (b.upload.size() > b.bufferCapacity) {
+                b.bufferCapacity = b.upload.size();
+                glBufferData(GL_ARRAY_BUFFER, b.bufferCapacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+            }
+            glBufferSubData(GL_ARRAY_BUFFER, 0, b.upload.size() * sizeof(InstanceData), b.upload.data());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            b.dirty = false;
+        }
+        if (b.upload.empty()) continue;
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, b.atlas->getAlbedo());
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, b.atlas->getNormalDepth());
+        glBindVertexArray(b.vao);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(b.upload.size()));
+    }
+
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Model;
+class Shader;
+class Texture;
+
+// octahedral impostor of one model: FRAMES x FRAMES orthographic views spread
+// over the upper hemisphere by a hemi-octahedral mapping, rendered once at
+// load time into an albedo/coverage atlas and a normal/depth atlas
+class ImpostorAtlas {
+public:
+    static constexpr int FRAMES = 8;
+    static constexpr int FRAME_SIZE = 128;
+
+    ImpostorAtlas() = default;
+    ~ImpostorAtlas();
+    ImpostorAtlas(const ImpostorAtlas&) = delete;
+    ImpostorAtlas& operator=(const ImpostorAtlas&) = delete;
+
+    // renders the views with bakeProgram (impostor_bake_*.glsl), texture is optional
+    bool bake(Model* model, Shader* bakeProgram, Texture* texture = nullptr);
+
+    GLuint getAlbedo() const { return albedo; }
+    GLuint getNormalDepth() const { return normalDepth; }
+    // object space sphere the views were fitted to
+    const glm::vec3& getCenter() const { return center; }
+    float getRadius() const { return radius; }
+
+    // view direction of a point in [0, 1]^2 of the atlas grid, y up;
+    // impostor_vertex.glsl inverts the same mapping
+    static glm::vec3 FrameDirection(const glm::vec2& grid);
+
+private:
+    GLuint albedo = 0;
+    GLuint normalDepth = 0;
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 1.0f;
+};
+
+// far instances of baked models as camera facing quads, each blending the
+// four atlas views nearest to its view direction. instances belong to groups
+// so a scene can hand whole groups between the meshes and the impostors
+class ImpostorRenderer {
+public:
+    ImpostorRenderer();
+    ~ImpostorRenderer();
+    ImpostorRenderer(const ImpostorRenderer&) = delete;
+    ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+    // index for add()
+    int addAtlas(std::unique_ptr<ImpostorAtlas> atlas);
+    // an instance of the atlas' model at position, turned yawDeg about y and scaled uniformly
+    void add(int atlas, uint32_t group, const glm::vec3& position, float yawDeg, float scale, const glm::vec3& color);
+    size_t size() const;
+
+    // the instances of groups whose flag is set; program is impostor_*.glsl
+    // with its lights already updated
+    void draw(Shader& program, const std::vector<uint8_t>& groups, const glm::mat4& view,
+              const glm::mat4& projection, const glm::vec3& viewPos);
+
+private:
+    // sphere center and radius, color and yaw in radians
+    struct InstanceData {
+        glm::vec4 sphere;
+        glm::vec4 colorYaw;
+    };
+
+    struct Batch {
+        std::unique_ptr<ImpostorAtlas> atlas;
+        std::vector<InstanceData> instances;
+        std::vector<uint32_t> groups;
+        std::vector<InstanceData> upload;
+        GLuint vao = 0;
+        GLuint instanceBuffer = 0;
+        size_t bufferCapacity = 0;
+        bool dirty = true;
+    };
+
+    std::vector<Batch> batches;
+    std::vector<uint8_t> lastGroups;
+    GLuint quadBuffer = 0;
+};
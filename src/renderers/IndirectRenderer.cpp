@@ -0,0 +1,349 @@
+#include "IndirectRenderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <string>
+
+namespace {
+const GLuint DRAW_INDEX_LOCATION = 11;
+const int TEXTURE_ARRAY_SIZE = 1024;
+}
+
+bool IndirectRenderer::isSupported() {
+    // the texture array also needs glTexStorage3D, so the ARB subset isn't enough
+    return GLEW_VERSION_4_3;
+}
+
+IndirectRenderer::~IndirectRenderer() {
+    release();
+}
+
+void IndirectRenderer::release() {
+    for (auto& entry : pools) {
+        glDeleteVertexArrays(1, &entry.second.vao);
+        glDeleteBuffers(1, &entry.second.vbo);
+        glDeleteBuffers(1, &entry.second.ebo);
+    }
+    pools.clear();
+    if (commandBuffer) glDeleteBuffers(1, &commandBuffer);
+    if (drawTable) glDeleteBuffers(1, &drawTable);
+    if (drawIndexBuffer) glDeleteBuffers(1, &drawIndexBuffer);
+    if (textureArray) glDeleteTextures(1, &textureArray);
+    commandBuffer = drawTable = drawIndexBuffer = textureArray = 0;
+    if (boundsBuffer) glDeleteBuffers(1, &boundsBuffer);
+    if (visibilityBuffer) glDeleteBuffers(1, &visibilityBuffer);
+    if (culledCommands[0]) glDeleteBuffers(2, culledCommands);
+    boundsBuffer = visibilityBuffer = culledCommands[0] = culledCommands[1] = 0;
+    cullProgram = nullptr;
+    hiz.reset();
+    gpuCulling = false;
+    built = false;
+}
+
+bool IndirectRenderer::build(const std::vector<DrawableObject>& objects, Shader* shader) {
+    release();
+    if (!isSupported()) {
+        std::cerr << "Indirect rendering needs OpenGL 4.3!!!" << std::endl;
+        return false;
+    }
+    program = shader;
+
+    // objects per vertex layout, each layout gets its own pool and multi-draw
+    std::map<ModelType, std::vector<size_t>> byType;
+    std::vector<Texture*> textures;
+    covered.assign(objects.size(), false);
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const auto& obj = objects[i];
+        if (obj.instanced || obj.normalMap || obj.model->getType() == ModelType::BASIC) continue;
+        byType[obj.model->getType()].push_back(i);
+        covered[i] = true;
+        if (obj.texture && !obj.texture->isCubemap() &&
+            std::find(textures.begin(), textures.end(), obj.texture) == textures.end()) {
+            textures.push_back(obj.texture);
+        }
+    }
+    if (byType.empty()) return false;
+
+    transforms.clear();
+    versions.clear();
+    drawData.clear();
+    drawBounds.clear();
+
+    std::vector<DrawCommand> commands;
+    for (const auto& entry : byType) {
+        for (size_t idx : entry.second) {
+            const auto& obj = objects[idx];
+            DrawData d;
+            d.material = glm::vec4(obj.material.getShininess(), obj.material.getAmbient(),
+                                   obj.material.getDiffuse(), obj.material.getSpecular());
+            auto layer = std::find(textures.begin(), textures.end(), obj.texture);
+            d.info = glm::ivec4(layer != textures.end() ? static_cast<int>(layer - textures.begin()) : -1, 0, 0, 0);
+            drawData.push_back(d);
+            const Aabb& local = obj.model->getBounds();
+            drawBounds.push_back({glm::vec4(local.min, 1.0f), glm::vec4(local.max, 1.0f)});
+            transforms.push_back(obj.transform);
+            versions.push_back(UINT64_MAX);
+        }
+        buildPool(entry.first, entry.second, objects, commands);
+    }
+
+    glGenBuffers(1, &commandBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawCommand), commands.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glGenBuffers(1, &drawTable);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawTable);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, drawData.size() * sizeof(DrawData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    buildTextureArray(textures);
+
+    program->use();
+    program->SetUniform("textureLayers", 0);
+    glUseProgram(0);
+
+    built = true;
+    update();
+    std::cout << "Indirect renderer: " << drawData.size() << " draws in " << pools.size()
+              << " multi-draw calls, " << textures.size() << " texture layers" << std::endl;
+    return true;
+}
+
+void IndirectRenderer::buildPool(ModelType type, const std::vector<size_t>& objectIndices,
+                                 const std::vector<DrawableObject>& objects, std::vector<DrawCommand>& commands) {
+    // each distinct mesh is copied once, objects sharing it share the range
+    std::map<Model*, MeshRange> ranges;
+    std::vector<Model*> meshes;
+    GLsizeiptr vertexBytes = 0;
+    GLsizeiptr indexBytes = 0;
+    for (size_t idx : objectIndices) {
+        Model* model = objects[idx].model;
+        if (ranges.count(model)) continue;
+        ranges[model] = {
+            static_cast<GLuint>(indexBytes / sizeof(GLuint)),
+            static_cast<GLint>(vertexBytes / (model->getStride() * sizeof(float))),
+            static_cast<GLuint>(model->getIndexCount())
+        };
+        meshes.push_back(model);
+        vertexBytes += model->getVertexCount() * model->getStride() * sizeof(float);
+        indexBytes += model->getIndexCount() * sizeof(GLuint);
+    }
+
+    GeometryPool& pool = pools[type];
+    glGenBuffers(1, &pool.vbo);
+    glGenBuffers(1, &pool.ebo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexBytes, nullptr, GL_STATIC_DRAW);
+    GLintptr offset = 0;
+    for (Model* model : meshes) {
+        GLsizeiptr size = model->getVertexCount() * model->getStride() * sizeof(float);
+        glBindBuffer(GL_COPY_READ_BUFFER, model->getVBO());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, offset, size);
+        offset += size;
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+    offset = 0;
+    for (Model* model : meshes) {
+        GLsizeiptr size = model->getIndexCount() * sizeof(GLuint);
+        glBindBuffer(GL_COPY_READ_BUFFER, model->getEBO());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, offset, size);
+        offset += size;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    // draw i reads entry i of the table through its base instance
+    if (drawIndexBuffer == 0) {
+        glGenBuffers(1, &drawIndexBuffer);
+    }
+    std::vector<GLuint> drawIndices(drawData.size());
+    std::iota(drawIndices.begin(), drawIndices.end(), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, drawIndexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, drawIndices.size() * sizeof(GLuint), drawIndices.data(), GL_STATIC_DRAW);
+
+    pool.vao = Model::CreateVAO(type, pool.vbo, pool.ebo);
+    glBindVertexArray(pool.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, drawIndexBuffer);
+    glEnableVertexAttribArray(DRAW_INDEX_LOCATION);
+    glVertexAttribIPointer(DRAW_INDEX_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), (GLvoid*)0);
+    glVertexAttribDivisor(DRAW_INDEX_LOCATION, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    pool.firstCommand = commands.size();
+    GLuint drawIndex = static_cast<GLuint>(drawData.size() - objectIndices.size());
+    for (size_t idx : objectIndices) {
+        const MeshRange& r = ranges[objects[idx].model];
+        commands.push_back({r.indexCount, 1, r.firstIndex, r.baseVertex, drawIndex++});
+    }
+    pool.commandCount = commands.size() - pool.firstCommand;
+}
+
+void IndirectRenderer::buildTextureArray(const std::vector<Texture*>& textures) {
+    if (textures.empty()) return;
+
+    int levels = 1 + static_cast<int>(std::log2(TEXTURE_ARRAY_SIZE));
+    glGenTextures(1, &textureArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, TEXTURE_ARRAY_SIZE, TEXTURE_ARRAY_SIZE,
+                   static_cast<GLsizei>(textures.size()));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // textures differ in size, so each one is scaled into its layer by a blit
+    GLuint framebuffers[2];
+    glGenFramebuffers(2, framebuffers);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+    for (size_t layer = 0; layer < textures.size(); ++layer) {
+        Texture* tex = textures[layer];
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex->getID(), 0);
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureArray, 0,
+                                  static_cast<GLint>(layer));
+        glBlitFramebuffer(0, 0, tex->getWidth(), tex->getHeight(), 0, 0, TEXTURE_ARRAY_SIZE, TEXTURE_ARRAY_SIZE,
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(2, framebuffers);
+
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void IndirectRenderer::update() {
+    if (!built) return;
+
+    size_t first = drawData.size();
+    size_t last = 0;
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        uint64_t version = transforms[i]->getVersion();
+        if (version == versions[i]) continue;
+        versions[i] = version;
+
+        const glm::mat4& m = transforms[i]->getMatrix();
+        drawData[i].model = m;
+        drawData[i].normal = glm::mat4(glm::mat3(glm::transpose(glm::inverse(m))));
+        first = std::min(first, i);
+        last = i;
+    }
+    if (first > last) return;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawTable);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(DrawData), (last - first + 1) * sizeof(DrawData),
+                    drawData.data() + first);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+bool IndirectRenderer::enableGpuCulling(Shader* cull, Shader* hizProgram) {
+    if (!built || !GLEW_VERSION_4_3) {
+        std::cerr << "GPU culling needs OpenGL 4.3 and a built indirect renderer!!!" << std::endl;
+        return false;
+    }
+    cullProgram = cull;
+    hiz = std::make_unique<HiZPyramid>(hizProgram);
+    GLuint id = cullProgram->getID();
+    cullLocations = {glGetUniformLocation(id, "drawCount"), glGetUniformLocation(id, "phase"),
+                     glGetUniformLocation(id, "viewProj"), glGetUniformLocation(id, "frustumPlanes"),
+                     glGetUniformLocation(id, "hiz"), glGetUniformLocation(id, "hizSize"),
+                     glGetUniformLocation(id, "hizLevels")};
+
+    glGenBuffers(1, &boundsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, drawBounds.size() * sizeof(DrawBounds), drawBounds.data(),
+                 GL_STATIC_DRAW);
+
+    // everything counts as visible before the first frame, so phase 0 draws it all
+    std::vector<GLuint> visible(drawData.size(), 1);
+    glGenBuffers(1, &visibilityBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibilityBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, visible.size() * sizeof(GLuint), visible.data(), GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glGenBuffers(2, culledCommands);
+    for (GLuint buffer : culledCommands) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, drawData.size() * sizeof(DrawCommand), nullptr, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    return true;
+}
+
+void IndirectRenderer::cull(int phase) {
+    Frustum frustum(viewProj);
+    cullProgram->use();
+    glUniform1ui(cullLocations.drawCount, static_cast<GLuint>(drawData.size()));
+    glUniform1i(cullLocations.phase, phase);
+    glUniformMatrix4fv(cullLocations.viewProj, 1, GL_FALSE, glm::value_ptr(viewProj));
+    glm::vec4 planes[6];
+    for (int i = 0; i < 6; ++i) {
+        planes[i] = frustum.getPlane(i);
+    }
+    glUniform4fv(cullLocations.frustumPlanes, 6, &planes[0].x);
+    if (phase == 1) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, hiz->getTexture());
+        glUniform1i(cullLocations.hiz, 1);
+        glUniform2fv(cullLocations.hizSize, 1, glm::value_ptr(hiz->getSize()));
+        glUniform1i(cullLocations.hizLevels, hiz->getLevels());
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, drawTable);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, boundsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, visibilityBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, culledCommands[phase]);
+    glDispatchCompute(static_cast<GLuint>((drawData.size() + 63) / 64), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    if (phase == 1) {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    for (GLuint binding = 1; binding <= 4; ++binding) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+}
+
+void IndirectRenderer::drawCommands(GLuint buffer) {
+    program->use();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, drawTable);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+
+    for (const auto& entry : pools) {
+        const GeometryPool& pool = entry.second;
+        glBindVertexArray(pool.vao);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                    (GLvoid*)(pool.firstCommand * sizeof(DrawCommand)),
+                                    static_cast<GLsizei>(pool.commandCount), 0);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glUseProgram(0);
+}
+
+void IndirectRenderer::draw() {
+    if (!built) return;
+    if (!gpuCulling) {
+        drawCommands(commandBuffer);
+        return;
+    }
+
+    cull(0);
+    drawCommands(culledCommands[0]);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    hiz->build(viewport[2], viewport[3]);
+
+    cull(1);
+    drawCommands(culledCommands[1]);
+}
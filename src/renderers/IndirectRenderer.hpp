@@ -0,0 +1,117 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include "../DrawableObject.hpp"
+#include "HiZPyramid.hpp"
+
+// submits a whole object list with one glMultiDrawElementsInstancedIndirect per
+// vertex layout: meshes are copied into shared per-layout buffers, matrices and
+// materials live in a shader storage table and textures in one texture array;
+// needs GL 4.3, scenes keep their regular path when isSupported() is false
+//
+// with GPU culling on, a compute pass rewrites the commands every frame: the
+// draws visible last frame go first, their depth becomes a Hi-Z pyramid and
+// a second pass draws whatever that pyramid newly reveals
+class IndirectRenderer {
+public:
+    static bool isSupported();
+
+    IndirectRenderer() = default;
+    ~IndirectRenderer();
+    IndirectRenderer(const IndirectRenderer&) = delete;
+    IndirectRenderer& operator=(const IndirectRenderer&) = delete;
+
+    // takes every object it can draw (no normal map, not instanced, has
+    // normals); program must be built from vertex_indirect/frag_indirect
+    bool build(const std::vector<DrawableObject>& objects, Shader* program);
+    bool isBuilt() const { return built; }
+    bool covers(size_t objectIndex) const {
+        return objectIndex < covered.size() && covered[objectIndex];
+    }
+
+    // cull_compute.glsl and hiz_compute.glsl programs, call after build()
+    bool enableGpuCulling(Shader* cullProgram, Shader* hizProgram);
+    bool hasGpuCulling() const { return cullProgram != nullptr; }
+    void setGpuCulling(bool enabled) { gpuCulling = enabled && hasGpuCulling(); }
+    bool isGpuCulling() const { return gpuCulling; }
+    void setViewProjection(const glm::mat4& m) { viewProj = m; }
+
+    // re-uploads matrices of objects whose transform changed
+    void update();
+    void draw();
+
+private:
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    struct DrawData {
+        glm::mat4 model;
+        glm::mat4 normal;
+        glm::vec4 material;
+        glm::ivec4 info;
+    };
+
+    struct DrawBounds {
+        glm::vec4 min;
+        glm::vec4 max;
+    };
+
+    struct MeshRange {
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint indexCount;
+    };
+
+    struct GeometryPool {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLuint ebo = 0;
+        size_t firstCommand = 0;
+        size_t commandCount = 0;
+    };
+
+    Shader* program = nullptr;
+    bool built = false;
+    std::vector<bool> covered;
+
+    std::map<ModelType, GeometryPool> pools;
+    std::vector<std::shared_ptr<Transform>> transforms;
+    std::vector<uint64_t> versions;
+    std::vector<DrawData> drawData;
+    std::vector<DrawBounds> drawBounds;
+
+    GLuint commandBuffer = 0;
+    GLuint drawTable = 0;
+    GLuint drawIndexBuffer = 0;
+    GLuint textureArray = 0;
+
+    Shader* cullProgram = nullptr;
+    // cull_compute.glsl runs twice a frame, so its uniforms are looked up once
+    struct CullLocations {
+        GLint drawCount, phase, viewProj, frustumPlanes, hiz, hizSize, hizLevels;
+    };
+    CullLocations cullLocations = {-1, -1, -1, -1, -1, -1, -1};
+    std::unique_ptr<HiZPyramid> hiz;
+    bool gpuCulling = false;
+    glm::mat4 viewProj = glm::mat4(1.0f);
+    GLuint boundsBuffer = 0;
+    GLuint visibilityBuffer = 0;
+    // commands written by the two culling phases
+    GLuint culledCommands[2] = {0, 0};
+
+    void buildPool(ModelType type, const std::vector<size_t>& objectIndices,
+                   const std::vector<DrawableObject>& objects, std::vector<DrawCommand>& commands);
+    void buildTextureArray(const std::vector<Texture*>& textures);
+    void cull(int phase);
+    void drawCommands(GLuint buffer);
+    void release();
+};
@@ -0,0 +1,148 @@
+#include "InstanceGroup.hpp"
+#include "../DrawableObject.hpp"
+#include <algorithm>
+
+InstanceGroup::InstanceGroup(Model* model, Shader* shader, Texture* texture, const Material& material)
+    : model(model), shader(shader), texture(texture), material(material) {
+    glGenBuffers(1, &instanceBuffer);
+    vao = model->createInstancedVAO(instanceBuffer);
+    depthVao = model->createInstancedVAO(instanceBuffer, true);
+}
+
+InstanceGroup::~InstanceGroup() {
+    glDeleteVertexArrays(1, &vao);
+    glDeleteVertexArrays(1, &depthVao);
+    glDeleteBuffers(1, &instanceBuffer);
+}
+
+bool InstanceGroup::matches(const DrawableObject& obj) const {
+    return obj.model == model && obj.shader == shader && obj.texture == texture && !obj.normalMap &&
+           obj.material == material;
+}
+
+void InstanceGroup::add(std::shared_ptr<Transform> transform, size_t objectIndex) {
+    drawList.push_back(static_cast<uint32_t>(transforms.size()));
+    transforms.push_back(std::move(transform));
+    objectIndices.push_back(objectIndex);
+    // a version that never matches forces the first upload
+    versions.push_back(UINT64_MAX);
+    data.emplace_back();
+}
+
+void InstanceGroup::removeObject(size_t objectIndex, size_t movedFrom) {
+    for (size_t i = 0; i < objectIndices.size(); ++i) {
+        if (objectIndices[i] != objectIndex) continue;
+        // same swap and pop as the scene, the moved instance is uploaded again
+        size_t last = objectIndices.size() - 1;
+        transforms[i] = std::move(transforms[last]);
+        objectIndices[i] = objectIndices[last];
+        data[i] = data[last];
+        versions[i] = UINT64_MAX;
+        transforms.pop_back();
+        objectIndices.pop_back();
+        data.pop_back();
+        versions.pop_back();
+
+        // positions in the draw list shifted, draw everything until the next setVisibility
+        drawList.clear();
+        for (size_t j = 0; j < transforms.size(); ++j) drawList.push_back(static_cast<uint32_t>(j));
+        drawListChanged = true;
+        break;
+    }
+    for (size_t& idx : objectIndices) {
+        if (idx == movedFrom) idx = objectIndex;
+    }
+}
+
+void InstanceGroup::setVisibility(const std::vector<uint8_t>& objectVisible) {
+    nextDrawList.clear();
+    for (size_t i = 0; i < objectIndices.size(); ++i) {
+        size_t idx = objectIndices[i];
+        if (idx >= objectVisible.size() || objectVisible[idx]) nextDrawList.push_back(static_cast<uint32_t>(i));
+    }
+    if (nextDrawList != drawList) {
+        drawList.swap(nextDrawList);
+        drawListChanged = true;
+    }
+}
+
+void InstanceGroup::update() {
+    size_t first = data.size();
+    size_t last = 0;
+
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        uint64_t version = transforms[i]->getVersion();
+        if (version == versions[i]) continue;
+        versions[i] = version;
+
+        // matches what the vertex shaders derive from the model uniform
+        const glm::mat4& m = transforms[i]->getMatrix();
+        glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(m)));
+        data[i].model = m;
+        data[i].normal[0] = glm::vec4(normal[0], 0.0f);
+        data[i].normal[1] = glm::vec4(normal[1], 0.0f);
+        data[i].normal[2] = glm::vec4(normal[2], 0.0f);
+
+        first = std::min(first, i);
+        last = i;
+    }
+
+    bool changed = first <= last && first < data.size();
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    if (bufferCapacity < data.size()) {
+        bufferCapacity = data.size();
+        glBufferData(GL_ARRAY_BUFFER, bufferCapacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+        drawListChanged = true;
+    }
+
+    if (drawList.size() == data.size()) {
+        // nothing culled, the buffer mirrors data and only changed ranges go up
+        if (drawListChanged) {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, data.size() * sizeof(InstanceData), data.data());
+        } else if (changed) {
+            glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(InstanceData),
+                            (last - first + 1) * sizeof(InstanceData), data.data() + first);
+        }
+    } else if (!drawList.empty() && (drawListChanged || changed)) {
+        compacted.resize(drawList.size());
+        for (size_t i = 0; i < drawList.size(); ++i) compacted[i] = data[drawList[i]];
+        glBufferSubData(GL_ARRAY_BUFFER, 0, compacted.size() * sizeof(InstanceData), compacted.data());
+    }
+    drawListChanged = false;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceGroup::draw() {
+    if (drawList.empty()) return;
+
+    shader->use();
+    shader->SetUniform("material.shininess", material.getShininess());
+    shader->SetUniform("material.ambient", material.getAmbient());
+    shader->SetUniform("material.diffuse", material.getDiffuse());
+    shader->SetUniform("material.specular", material.getSpecular());
+
+    if (texture) {
+        texture->bind(0);
+        shader->SetUniform("textureSampler", 0);
+        shader->SetUniform("useTexture", true);
+    } else {
+        shader->SetUniform("useTexture", false);
+    }
+    shader->SetUniform("useNormalMap", false);
+
+    shader->SetUniform("useInstancing", true);
+    model->drawInstancedVAO(vao, static_cast<int>(drawList.size()), GL_TRIANGLES);
+    shader->SetUniform("useInstancing", false);
+
+    if (texture) {
+        texture->unbind();
+    }
+}
+
+void InstanceGroup::drawDepth(const Shader& depthShader) {
+    if (drawList.empty()) return;
+    depthShader.use();
+    depthShader.SetUniform("useInstancing", true);
+    model->drawInstancedVAO(depthVao, static_cast<int>(drawList.size()), GL_TRIANGLES);
+    depthShader.SetUniform("useInstancing", false);
+}
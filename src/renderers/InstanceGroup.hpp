@@ -0,0 +1,67 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Material.hpp"
+
+class Model;
+class Shader;
+class Texture;
+class Transform;
+struct DrawableObject;
+
+// objects sharing model, program, texture and material, drawn with one
+// glDrawElementsInstanced; per-instance matrices are re-uploaded only for
+// transforms whose version moved since the last frame, or compacted to the
+// visible instances while some of them are culled
+class InstanceGroup {
+public:
+    InstanceGroup(Model* model, Shader* shader, Texture* texture, const Material& material);
+    ~InstanceGroup();
+    InstanceGroup(const InstanceGroup&) = delete;
+    InstanceGroup& operator=(const InstanceGroup&) = delete;
+
+    bool matches(const DrawableObject& obj) const;
+    void add(std::shared_ptr<Transform> transform, size_t objectIndex);
+    // the scene dropped objectIndex and moved object movedFrom into its place
+    void removeObject(size_t objectIndex, size_t movedFrom);
+    size_t size() const { return transforms.size(); }
+    size_t visibleCount() const { return drawList.size(); }
+
+    // per scene object visibility, indexed like the scene's object list
+    void setVisibility(const std::vector<uint8_t>& objectVisible);
+
+    void update();
+    void draw();
+    // same instances through a position-only program
+    void drawDepth(const Shader& depthShader);
+
+private:
+    struct InstanceData {
+        glm::mat4 model;
+        glm::vec4 normal[3];
+    };
+
+    Model* model;
+    Shader* shader;
+    Texture* texture;
+    Material material;
+
+    std::vector<std::shared_ptr<Transform>> transforms;
+    std::vector<uint64_t> versions;
+    std::vector<InstanceData> data;
+    std::vector<size_t> objectIndices;
+    // instances to draw, in order; all of them unless something is culled
+    std::vector<uint32_t> drawList;
+    std::vector<uint32_t> nextDrawList;
+    std::vector<InstanceData> compacted;
+    bool drawListChanged = false;
+
+    GLuint vao = 0;
+    // same instance buffer, mesh side reads the model's position stream
+    GLuint depthVao = 0;
+    GLuint instanceBuffer = 0;
+    size_t bufferCapacity = 0;
+};
@@ -45,6 +45,11 @@ void Light::setOuterCutOff(float angle) {
     notify();
 }
 
+void Light::setConstant(float c) {
+    constant = c;
+    notify();
+}
+
 void Light::setLinear(float lin) {
     linear = lin;
     notify();
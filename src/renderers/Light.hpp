@@ -23,6 +23,7 @@ public:
     void setSpecular(float spec);
     void setCutOff(float angle);
     void setOuterCutOff(float angle);
+    void setConstant(float c);
     void setLinear(float lin);
     void setQuadratic(float quad);
     void updateObservers();
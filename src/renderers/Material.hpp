@@ -27,6 +27,11 @@ public:
     void setAmbient(float a) { ambient = a; }
     void setDiffuse(float d) { diffuse = d; }
     void setSpecular(float s) { specular = s; }
+
+    bool operator==(const Material& o) const {
+        return shininess == o.shininess && ambient == o.ambient && diffuse == o.diffuse && specular == o.specular;
+    }
+    bool operator!=(const Material& o) const { return !(*this == o); }
     
 private:
     float shininess;
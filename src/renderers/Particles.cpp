@@ -0,0 +1,148 @@
+#include "Particles.hpp"
+#include "Shader.hpp"
+#include "../Random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+const std::vector<const char*> ParticleSystem::FEEDBACK_VARYINGS = {
+    "outPositionAge", "outVelocityLifetime", "outOrbit", "outExtra"
+};
+
+ParticleSystem::ParticleSystem(const Settings& settings) : settings(settings) {
+    if (this->settings.capacity == 0) {
+        std::cerr << "Particle system needs a capacity!!!" << std::endl;
+        this->settings.capacity = 1;
+    }
+
+    // everything starts out dead, older than its zero lifetime
+    Particle dead{glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f)};
+    std::vector<Particle> initial(this->settings.capacity, dead);
+
+    glGenBuffers(2, buffers);
+    glGenVertexArrays(2, vaos);
+    for (int i = 0; i < 2; ++i) {
+        glBindVertexArray(vaos[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, initial.size() * sizeof(Particle), initial.data(), GL_DYNAMIC_COPY);
+        for (GLuint loc = 0; loc < 4; ++loc) {
+            glEnableVertexAttribArray(loc);
+            glVertexAttribPointer(loc, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (GLvoid*)(loc * sizeof(glm::vec4)));
+        }
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ParticleSystem::~ParticleSystem() {
+    glDeleteVertexArrays(2, vaos);
+    glDeleteBuffers(2, buffers);
+}
+
+ParticleSystem::Particle ParticleSystem::Orbiter(float phase, float angularSpeed, float radius, float height,
+                                                 float drift, float seed, float size) {
+    glm::vec3 position(radius * std::cos(phase), height, -radius * std::sin(phase));
+    return {glm::vec4(position, 0.0f), glm::vec4(0.0f, 0.0f, 0.0f, -1.0f),
+            glm::vec4(phase, angularSpeed, radius, height), glm::vec4(drift, seed, size, 0.0f)};
+}
+
+float ParticleSystem::random() {
+    randomState = randomState * 1664525u + 1013904223u;
+    return (randomState >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleSystem::emit(const Particle* particles, size_t count) {
+    // only the newest capacity particles would survive anyway
+    if (count > settings.capacity) {
+        particles += count - settings.capacity;
+        count = settings.capacity;
+    }
+    emitted += count;
+    lastEmitTime = clock;
+    for (size_t i = 0; i < count; ++i) longestLifetime = std::max(longestLifetime, particles[i].velocityLifetime.w);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[current]);
+    while (count > 0) {
+        size_t run = std::min(count, settings.capacity - cursor);
+        glBufferSubData(GL_ARRAY_BUFFER, cursor * sizeof(Particle), run * sizeof(Particle), particles);
+        particles += run;
+        count -= run;
+        cursor = (cursor + run) % settings.capacity;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleSystem::emitBurst(const glm::vec3& position, size_t count, float speed, float lifetime) {
+    burst.clear();
+    for (size_t i = 0; i < count; ++i) {
+        float angle = random() * TWO_PI;
+        float up = 0.3f + 0.7f * random();
+        float out = std::sqrt(1.0f - up * up);
+        glm::vec3 velocity = glm::vec3(out * std::cos(angle), up, out * std::sin(angle)) *
+                             (speed * (0.3f + 0.7f * random()));
+        float life = lifetime * (0.5f + 0.5f * random());
+        burst.push_back({glm::vec4(position, 0.0f), glm::vec4(velocity, life), glm::vec4(0.0f),
+                         glm::vec4(0.0f, random(), 0.5f + random(), 0.0f)});
+    }
+    emit(burst.data(), burst.size());
+}
+
+bool ParticleSystem::isIdle(float time) const {
+    if (emitted == 0) return true;
+    if (settings.motion == Motion::ORBIT) return false;
+    return time - lastEmitTime > longestLifetime;
+}
+
+void ParticleSystem::update(Shader& program, float time, float deltaTime) {
+    clock = time;
+    if (isIdle(time)) return;
+    // particles past the ones ever emitted are still the dead initial ones
+    GLsizei count = static_cast<GLsizei>(std::min(emitted, settings.capacity));
+
+    program.use();
+    program.SetUniform("motion", settings.motion == Motion::ORBIT ? 0 : 1);
+    program.SetUniform("time", time);
+    program.SetUniform("deltaTime", std::min(deltaTime, 0.1f));
+    program.SetUniform("center", settings.center);
+    program.SetUniform("gravity", settings.gravity);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(vaos[current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[1 - current]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, count);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glUseProgram(0);
+
+    current = 1 - current;
+}
+
+void ParticleSystem::draw(Shader& program, const glm::mat4& view, const glm::mat4& projection, float viewportHeight,
+                          float time) {
+    if (isIdle(time)) return;
+    GLsizei count = static_cast<GLsizei>(std::min(emitted, settings.capacity));
+
+    program.use();
+    program.SetUniform("view", view);
+    program.SetUniform("projection", projection);
+    program.SetUniform("viewportHeight", viewportHeight);
+    program.SetUniform("pointSize", settings.size);
+    program.SetUniform("particleColor", settings.color);
+    program.SetUniform("motion", settings.motion == Motion::ORBIT ? 0 : 1);
+    program.SetUniform("time", time);
+
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    glDepthMask(GL_FALSE);
+    glBindVertexArray(vaos[current]);
+    glDrawArrays(GL_POINTS, 0, count);
+    glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+    glUseProgram(0);
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Shader;
+
+// particles that live only in GPU buffers: each update runs every particle
+// through particles_update.glsl once with transform feedback into the other
+// buffer of a pair, and they are drawn from there as point sprites. the CPU
+// only writes newly emitted particles, into a ring over the buffer, so the
+// cost per frame is the same for ten particles or fifty thousand
+class ParticleSystem {
+public:
+    enum class Motion {
+        // circles around the center on its own orbit, pushed around by a
+        // noise field and pulled back to the orbit by a spring; never dies
+        ORBIT,
+        // free flight under gravity and drag until its lifetime runs out
+        BALLISTIC
+    };
+
+    // the GPU layout, four vec4 attributes at locations 0-3
+    struct Particle {
+        // xyz position, w age in seconds
+        glm::vec4 positionAge;
+        // xyz velocity, w lifetime, below zero lives forever
+        glm::vec4 velocityLifetime;
+        // ORBIT: phase, radians per second, radius, height above the center
+        glm::vec4 orbit;
+        // noise drift strength, random seed in [0, 1), size multiplier, unused
+        glm::vec4 extra;
+    };
+    static_assert(sizeof(Particle) == 64, "particles are uploaded as they are");
+
+    struct Settings {
+        Motion motion = Motion::BALLISTIC;
+        size_t capacity = 4096;
+        glm::vec3 center = glm::vec3(0.0f);
+        glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+        glm::vec3 color = glm::vec3(1.0f);
+        // world size of a sprite with size multiplier 1
+        float size = 0.05f;
+    };
+
+    explicit ParticleSystem(const Settings& settings);
+    ~ParticleSystem();
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    // ORBIT particles standing on their orbit at time 0
+    static Particle Orbiter(float phase, float angularSpeed, float radius, float height, float drift, float seed,
+                            float size = 1.0f);
+
+    // writes over the oldest particles
+    void emit(const Particle* particles, size_t count);
+    // count BALLISTIC sparks from position, thrown up and out at up to speed
+    void emitBurst(const glm::vec3& position, size_t count, float speed, float lifetime);
+
+    // program is particles_update.glsl built with FEEDBACK_VARYINGS
+    void update(Shader& program, float time, float deltaTime);
+    // program is particles_vertex/fragment.glsl, blended additively over the scene without writing depth
+    void draw(Shader& program, const glm::mat4& view, const glm::mat4& projection, float viewportHeight, float time);
+
+    size_t getCapacity() const { return settings.capacity; }
+    // nothing alive to simulate or draw
+    bool isIdle(float time) const;
+
+    static const std::vector<const char*> FEEDBACK_VARYINGS;
+
+private:
+    Settings settings;
+    GLuint buffers[2] = {0, 0};
+    GLuint vaos[2] = {0, 0};
+    // the buffer holding the latest state
+    int current = 0;
+    size_t cursor = 0;
+    size_t emitted = 0;
+    // BALLISTIC systems go idle once everything emitted has run out
+    float lastEmitTime = -1.0f;
+    float longestLifetime = 0.0f;
+    float clock = 0.0f;
+    uint32_t randomState = 0x9e3779b9u;
+    std::vector<Particle> burst;
+
+    float random();
+};
@@ -0,0 +1,64 @@
+#include "ProceduralAnimation.hpp"
+#include "../trans/TransformBezier.hpp"
+
+ProceduralAnimation::~ProceduralAnimation() {
+    if (texture != 0) glDeleteTextures(1, &texture);
+    if (buffer != 0) glDeleteBuffers(1, &buffer);
+}
+
+int ProceduralAnimation::addCurve(const TransformBezier& curve) {
+    const auto& segments = curve.getSegments();
+    curves.push_back({static_cast<int>(curveTexels.size()), static_cast<int>(segments.size())});
+    for (const auto& s : segments) {
+        curveTexels.push_back(glm::vec4(s.a, 0.0f));
+        curveTexels.push_back(glm::vec4(s.b, 0.0f));
+        curveTexels.push_back(glm::vec4(s.c, 0.0f));
+        curveTexels.push_back(glm::vec4(s.d, 1.0f));
+    }
+    return static_cast<int>(curves.size()) - 1;
+}
+
+int ProceduralAnimation::addBody(const Body& body) {
+    bodies.push_back(body);
+    return static_cast<int>(bodies.size()) - 1;
+}
+
+void ProceduralAnimation::upload() {
+    int curveBase = static_cast<int>(bodies.size()) * 2;
+
+    std::vector<glm::vec4> texels;
+    texels.reserve(curveBase + curveTexels.size());
+    for (const auto& b : bodies) {
+        float start = 0.0f;
+        float segments = 0.0f;
+        if (b.curve >= 0) {
+            start = static_cast<float>(curveBase + curves[b.curve].first);
+            segments = static_cast<float>(curves[b.curve].segments);
+        }
+        texels.push_back(glm::vec4(static_cast<float>(b.parent), start, segments, b.scale));
+        texels.push_back(glm::vec4(b.curveSpeed, b.orbitRadius, b.orbitSpeed, b.spinSpeed));
+    }
+    texels.insert(texels.end(), curveTexels.begin(), curveTexels.end());
+
+    if (buffer == 0) glGenBuffers(1, &buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, texels.size() * sizeof(glm::vec4), texels.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    if (texture == 0) glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void ProceduralAnimation::bind(unsigned int slot) const {
+    boundSlot = slot;
+    glActiveTexture(GL_TEXTURE0 + slot);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+}
+
+void ProceduralAnimation::unbind() const {
+    glActiveTexture(GL_TEXTURE0 + boundSlot);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class TransformBezier;
+
+// static animation parameters of many bodies in a buffer texture, posed by
+// vertex_procedural.glsl from the time uniform alone
+class ProceduralAnimation {
+public:
+    struct Body {
+        int parent = -1;            // >= 0 rides on that body's curve instead of its own
+        int curve = -1;
+        float curveSpeed = 0.0f;    // curve params per second
+        float orbitRadius = 0.0f;
+        float orbitSpeed = 0.0f;    // radians per second around the frame's Y
+        float spinSpeed = 0.0f;     // radians per second around own Y
+        float scale = 1.0f;
+    };
+
+    ProceduralAnimation() = default;
+    ~ProceduralAnimation();
+    ProceduralAnimation(const ProceduralAnimation&) = delete;
+    ProceduralAnimation& operator=(const ProceduralAnimation&) = delete;
+
+    int addCurve(const TransformBezier& curve);
+    int addBody(const Body& body);
+    int getBodyCount() const { return static_cast<int>(bodies.size()); }
+
+    // builds the texel data and sends it to the GPU, call after all adds
+    void upload();
+    void bind(unsigned int slot) const;
+    void unbind() const;
+
+private:
+    struct CurveRange {
+        int first;
+        int segments;
+    };
+
+    std::vector<Body> bodies;
+    std::vector<CurveRange> curves;
+    std::vector<glm::vec4> curveTexels;
+
+    GLuint buffer = 0;
+    GLuint texture = 0;
+    mutable unsigned int boundSlot = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// which passes draw an object, one bit each
+namespace RenderLayer {
+    enum : uint32_t {
+        // the sorted opaque queue and the instance groups
+        OPAQUE = 1u << 0,
+        // shaded in its own pass, then written to the stencil ID pass with its pickId
+        PICKABLE = 1u << 1,
+        // hover highlight, drawn after the other passes
+        OUTLINED = 1u << 2,
+    };
+    constexpr int COUNT = 3;
+}
+
+// object indices per layer, kept up to date on every add, layer change and
+// swap-and-pop removal so a pass walks only its own members
+class LayerLists {
+public:
+    const std::vector<uint32_t>& members(uint32_t layer) const {
+        return lists[bitIndex(layer)];
+    }
+
+    void add(size_t objectIndex, uint32_t mask) {
+        if (positions.size() <= objectIndex) positions.resize(objectIndex + 1);
+        for (int l = 0; l < RenderLayer::COUNT; ++l) {
+            if (mask & (1u << l)) insert(l, objectIndex);
+        }
+    }
+
+    void change(size_t objectIndex, uint32_t oldMask, uint32_t newMask) {
+        for (int l = 0; l < RenderLayer::COUNT; ++l) {
+            uint32_t bit = 1u << l;
+            if ((oldMask & bit) && !(newMask & bit)) erase(l, objectIndex);
+            if (!(oldMask & bit) && (newMask & bit)) insert(l, objectIndex);
+        }
+    }
+
+    // mirrors the scene's swap and pop, the object at movedFrom now lives at objectIndex
+    void remove(size_t objectIndex, uint32_t mask, size_t movedFrom, uint32_t movedMask) {
+        for (int l = 0; l < RenderLayer::COUNT; ++l) {
+            if (mask & (1u << l)) erase(l, objectIndex);
+        }
+        if (movedFrom != objectIndex) {
+            for (int l = 0; l < RenderLayer::COUNT; ++l) {
+                if (movedMask & (1u << l)) lists[l][positions[movedFrom][l]] = static_cast<uint32_t>(objectIndex);
+            }
+            positions[objectIndex] = positions[movedFrom];
+        }
+        positions.pop_back();
+    }
+
+private:
+    std::array<std::vector<uint32_t>, RenderLayer::COUNT> lists;
+    // where each object sits in every list it belongs to
+    std::vector<std::array<uint32_t, RenderLayer::COUNT>> positions;
+
+    static int bitIndex(uint32_t layer) {
+        int l = 0;
+        while (l < RenderLayer::COUNT - 1 && !(layer & (1u << l))) ++l;
+        return l;
+    }
+
+    void insert(int l, size_t objectIndex) {
+        positions[objectIndex][l] = static_cast<uint32_t>(lists[l].size());
+        lists[l].push_back(static_cast<uint32_t>(objectIndex));
+    }
+
+    void erase(int l, size_t objectIndex) {
+        uint32_t pos = positions[objectIndex][l];
+        uint32_t moved = lists[l].back();
+        lists[l][pos] = moved;
+        positions[moved][l] = pos;
+        lists[l].pop_back();
+    }
+};
@@ -0,0 +1,253 @@
+#include "RenderQueue.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+const int PASS_BITS = 4;
+const int PROGRAM_BITS = 10;
+const int MATERIAL_BITS = 8;
+const int TEXTURE_BITS = 10;
+const int VAO_BITS = 12;
+const int DEPTH_BITS = 20;
+
+const int DEPTH_SHIFT = 0;
+const int VAO_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+const int TEXTURE_SHIFT = VAO_SHIFT + VAO_BITS;
+const int MATERIAL_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+const int PROGRAM_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+const int PASS_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS;
+static_assert(PASS_SHIFT + PASS_BITS == 64, "sort key fields must fill 64 bits");
+
+// depths are squared distances, so keys order the nearest 100 units
+const float MAX_SORT_DEPTH_SQ = 100.0f * 100.0f;
+
+uint64_t field(uint64_t value, int shift, int bits) {
+    return (value & ((uint64_t(1) << bits) - 1)) << shift;
+}
+}
+
+void RenderQueue::clear() {
+    if (!arena) {
+        packets.clear();
+        keys.clear();
+        order.clear();
+        return;
+    }
+
+    // last frame's arrays went with the arena reset, take new ones sized for
+    // about as many draws so they don't grow piecewise
+    size_t expected = packets.size();
+    packets = FrameVector<DrawPacket>(ArenaAllocator<DrawPacket>(arena));
+    keys = FrameVector<uint64_t>(ArenaAllocator<uint64_t>(arena));
+    order = FrameVector<uint32_t>(ArenaAllocator<uint32_t>(arena));
+    scratchKeys = FrameVector<uint64_t>(ArenaAllocator<uint64_t>(arena));
+    scratchOrder = FrameVector<uint32_t>(ArenaAllocator<uint32_t>(arena));
+    packets.reserve(expected);
+    keys.reserve(expected);
+    order.reserve(expected);
+}
+
+uint32_t RenderQueue::denseId(std::unordered_map<GLuint, uint32_t>& ids, GLuint name, uint32_t limit) {
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+    // past the limit ids wrap, which only costs grouping, not correctness
+    uint32_t id = static_cast<uint32_t>(ids.size()) % limit;
+    ids.emplace(name, id);
+    return id;
+}
+
+uint32_t RenderQueue::materialId(const Material& m) {
+    for (size_t i = 0; i < materials.size(); ++i) {
+        if (materials[i] == m) return static_cast<uint32_t>(i);
+    }
+    materials.push_back(m);
+    return static_cast<uint32_t>(materials.size() - 1);
+}
+
+void RenderQueue::submit(const DrawableObject& obj, uint8_t pass, float depth) {
+    DrawPacket packet;
+    packet.object = &obj;
+    packet.program = obj.shader->getID();
+    packet.texture = obj.texture ? obj.texture->getID() : 0;
+    packet.vao = obj.model->getVAO();
+    packet.material = materialId(obj.material);
+
+    float normalized = std::min(std::max(depth, 0.0f) / MAX_SORT_DEPTH_SQ, 1.0f);
+    uint64_t depthBits = static_cast<uint64_t>(normalized * ((1u << DEPTH_BITS) - 1));
+
+    uint64_t key = field(pass, PASS_SHIFT, PASS_BITS) |
+                   field(denseId(programIds, packet.program, 1u << PROGRAM_BITS), PROGRAM_SHIFT, PROGRAM_BITS) |
+                   field(packet.material, MATERIAL_SHIFT, MATERIAL_BITS) |
+                   field(denseId(textureIds, packet.texture, 1u << TEXTURE_BITS), TEXTURE_SHIFT, TEXTURE_BITS) |
+                   field(denseId(vaoIds, packet.vao, 1u << VAO_BITS), VAO_SHIFT, VAO_BITS) |
+                   field(depthBits, DEPTH_SHIFT, DEPTH_BITS);
+
+    order.push_back(static_cast<uint32_t>(packets.size()));
+    packets.push_back(packet);
+    keys.push_back(key);
+}
+
+void RenderQueue::submit(const std::vector<DrawableObject>& objects, const glm::vec3& viewPos, uint8_t pass,
+                         const std::vector<uint8_t>* visible) {
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const auto& obj = objects[i];
+        if (obj.instanced) continue;
+        if (visible && i < visible->size() && !(*visible)[i]) continue;
+        const glm::mat4& m = obj.transform->getMatrix();
+        glm::vec3 pos = glm::vec3(m[3]) / m[3][3];
+        glm::vec3 d = pos - viewPos;
+        submit(obj, pass, glm::dot(d, d));
+    }
+}
+
+void RenderQueue::submit(const std::vector<DrawableObject>& objects, const std::vector<uint32_t>& members,
+                         const glm::vec3& viewPos, uint8_t pass, const std::vector<uint8_t>* visible) {
+    for (uint32_t i : members) {
+        const auto& obj = objects[i];
+        if (obj.instanced) continue;
+        if (visible && i < visible->size() && !(*visible)[i]) continue;
+        const glm::mat4& m = obj.transform->getMatrix();
+        glm::vec3 pos = glm::vec3(m[3]) / m[3][3];
+        glm::vec3 d = pos - viewPos;
+        submit(obj, pass, glm::dot(d, d));
+    }
+}
+
+void RenderQueue::sort() {
+    unsortedStats = countChanges(order);
+
+    // LSD radix sort on bytes, stable so equal keys keep submission order
+    size_t n = keys.size();
+    scratchKeys.resize(n);
+    scratchOrder.resize(n);
+    for (int shift = 0; shift < 64 && n > 1; shift += 8) {
+        uint32_t counts[256 + 1] = {};
+        for (size_t i = 0; i < n; ++i) {
+            ++counts[((keys[i] >> shift) & 0xFF) + 1];
+        }
+        // every key shares this byte, the pass would not move anything
+        if (counts[((keys[0] >> shift) & 0xFF) + 1] == n) continue;
+
+        for (int d = 0; d < 256; ++d) {
+            counts[d + 1] += counts[d];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t dst = counts[(keys[i] >> shift) & 0xFF]++;
+            scratchKeys[dst] = keys[i];
+            scratchOrder[dst] = order[i];
+        }
+        keys.swap(scratchKeys);
+        order.swap(scratchOrder);
+    }
+
+    sortedStats = countChanges(order);
+}
+
+RenderQueue::Stats RenderQueue::countChanges(const FrameVector<uint32_t>& sequence) const {
+    Stats stats;
+    GLuint program = 0, texture = 0, vao = 0;
+    for (uint32_t idx : sequence) {
+        const DrawPacket& p = packets[idx];
+        if (stats.draws == 0 || p.program != program) ++stats.programChanges;
+        if (stats.draws == 0 || p.texture != texture) ++stats.textureChanges;
+        if (stats.draws == 0 || p.vao != vao) ++stats.vaoChanges;
+        program = p.program;
+        texture = p.texture;
+        vao = p.vao;
+        ++stats.draws;
+    }
+    return stats;
+}
+
+void RenderQueue::execute() {
+    GLuint boundProgram = 0;
+    GLuint boundTexture = 0;
+    GLuint boundNormalMap = 0;
+    // uniforms live in the program, so these start over on every program change;
+    // -1 means not uploaded yet
+    int64_t boundMaterial = -1;
+    int textureFlag = -1;
+    int normalMapFlag = -1;
+    float normalIntensity = -1.0f;
+
+    for (uint32_t idx : order) {
+        const DrawPacket& p = packets[idx];
+        const DrawableObject& obj = *p.object;
+        const Shader& shader = *obj.shader;
+
+        if (p.program != boundProgram) {
+            shader.use();
+            boundProgram = p.program;
+            boundMaterial = -1;
+            textureFlag = -1;
+            normalMapFlag = -1;
+            normalIntensity = -1.0f;
+            shader.SetUniform("textureSampler", 0);
+            shader.SetUniform("normalMap", 1);
+        }
+
+        if (p.material != boundMaterial) {
+            shader.SetUniform("material.shininess", obj.material.getShininess());
+            shader.SetUniform("material.ambient", obj.material.getAmbient());
+            shader.SetUniform("material.diffuse", obj.material.getDiffuse());
+            shader.SetUniform("material.specular", obj.material.getSpecular());
+            boundMaterial = p.material;
+        }
+
+        if (obj.texture && p.texture != boundTexture) {
+            obj.texture->bind(0);
+            boundTexture = p.texture;
+        }
+        int useTexture = obj.texture ? 1 : 0;
+        if (useTexture != textureFlag) {
+            shader.SetUniform("useTexture", useTexture != 0);
+            textureFlag = useTexture;
+        }
+
+        int useNormalMap = obj.normalMap && obj.model->getType() == ModelType::TAN ? 1 : 0;
+        if (useNormalMap) {
+            if (obj.normalMap->getID() != boundNormalMap) {
+                obj.normalMap->bind(1);
+                boundNormalMap = obj.normalMap->getID();
+            }
+            if (obj.normalIntensity != normalIntensity) {
+                shader.SetUniform("normalIntensity", obj.normalIntensity);
+                normalIntensity = obj.normalIntensity;
+            }
+        }
+        if (useNormalMap != normalMapFlag) {
+            shader.SetUniform("useNormalMap", useNormalMap != 0);
+            normalMapFlag = useNormalMap;
+        }
+
+        shader.SetUniform("model", obj.transform->getMatrix());
+        obj.model->draw(GL_TRIANGLES);
+    }
+
+    if (boundNormalMap) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+}
+
+void RenderQueue::executeDepth(const Shader& depthShader) {
+    depthShader.use();
+    depthShader.SetUniform("useInstancing", false);
+    for (uint32_t idx : order) {
+        const DrawableObject& obj = *packets[idx].object;
+        depthShader.SetUniform("model", obj.transform->getMatrix());
+        obj.model->drawPositions(GL_TRIANGLES);
+    }
+    glUseProgram(0);
+}
+
+void RenderQueue::logStats(const char* name) const {
+    std::cout << name << ": " << sortedStats.draws << " draws, program/texture/VAO changes "
+              << unsortedStats.programChanges << "/" << unsortedStats.textureChanges << "/" << unsortedStats.vaoChanges
+              << " unsorted -> "
+              << sortedStats.programChanges << "/" << sortedStats.textureChanges << "/" << sortedStats.vaoChanges
+              << " sorted" << std::endl;
+}
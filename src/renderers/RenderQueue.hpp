@@ -0,0 +1,78 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../DrawableObject.hpp"
+#include "../FrameArena.hpp"
+
+// collects the objects of one frame as 64-bit sort keys, radix sorts them and
+// submits in key order so draws sharing a program, texture and VAO end up
+// next to each other
+//
+// key layout from the top bit down:
+//   pass 4 | program 10 | material 8 | texture 10 | VAO 12 | depth 20
+class RenderQueue {
+public:
+    struct Stats {
+        int draws = 0;
+        int programChanges = 0;
+        int textureChanges = 0;
+        int vaoChanges = 0;
+    };
+
+    // per-frame arrays come from the arena when one is set, they must not be
+    // used after the arena's reset and before the next clear()
+    void setArena(FrameArena* frameArena) { arena = frameArena; }
+    void clear();
+    // depth is the squared distance to the camera, nearer draws go first
+    void submit(const DrawableObject& obj, uint8_t pass = 0, float depth = 0.0f);
+    // visible, when given, holds one flag per object and culled ones are skipped
+    void submit(const std::vector<DrawableObject>& objects, const glm::vec3& viewPos, uint8_t pass = 0,
+                const std::vector<uint8_t>* visible = nullptr);
+    // only the objects listed in members, e.g. one render layer
+    void submit(const std::vector<DrawableObject>& objects, const std::vector<uint32_t>& members,
+                const glm::vec3& viewPos, uint8_t pass = 0, const std::vector<uint8_t>* visible = nullptr);
+    void sort();
+    void execute();
+    // positions only through depthShader, in the same sorted order
+    void executeDepth(const Shader& depthShader);
+
+    size_t size() const { return packets.size(); }
+    // state changes of the frame in submission and in sorted order
+    const Stats& getUnsortedStats() const { return unsortedStats; }
+    const Stats& getSortedStats() const { return sortedStats; }
+    // prints the last frame's stats, on request rather than every frame
+    void logStats(const char* name) const;
+
+private:
+    struct DrawPacket {
+        const DrawableObject* object;
+        GLuint program;
+        GLuint texture;
+        GLuint vao;
+        // index into materials, unlike the key field it never wraps
+        uint32_t material;
+    };
+
+    FrameArena* arena = nullptr;
+    FrameVector<DrawPacket> packets;
+    FrameVector<uint64_t> keys;
+    FrameVector<uint32_t> order;
+
+    FrameVector<uint64_t> scratchKeys;
+    FrameVector<uint32_t> scratchOrder;
+
+    // dense ids so GL names and materials fit their key fields
+    std::unordered_map<GLuint, uint32_t> programIds;
+    std::unordered_map<GLuint, uint32_t> textureIds;
+    std::unordered_map<GLuint, uint32_t> vaoIds;
+    std::vector<Material> materials;
+
+    Stats unsortedStats;
+    Stats sortedStats;
+
+    uint32_t denseId(std::unordered_map<GLuint, uint32_t>& ids, GLuint name, uint32_t limit);
+    uint32_t materialId(const Material& material);
+    Stats countChanges(const FrameVector<uint32_t>& sequence) const;
+};
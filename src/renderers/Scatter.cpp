@@ -0,0 +1,324 @@
+#include "Scatter.hpp"
+#include "Shader.hpp"
+#include "Texture.hpp"
+#include "../AssetCache.hpp"
+#include "../Model.hpp"
+#include "../Random.hpp"
+#include "../ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+uint16_t toUnorm16(float v) {
+    return static_cast<uint16_t>(std::clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+}
+
+DensityMap::DensityMap(int width, int height, std::vector<float> values)
+    : width(width), height(height), values(std::move(values)) {
+    if (this->values.size() != static_cast<size_t>(width) * height) {
+        std::cerr << "Density map size does not match its values!!!" << std::endl;
+        this->values.clear();
+    }
+}
+
+DensityMap DensityMap::FromFunction(int width, int height, const glm::vec2& origin, const glm::vec2& size,
+                                    const std::function<float(float, float)>& f) {
+    std::vector<float> values(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            float wx = origin.x + (x + 0.5f) / width * size.x;
+            float wz = origin.y + (y + 0.5f) / height * size.y;
+            values[y * width + x] = std::clamp(f(wx, wz), 0.0f, 1.0f);
+        }
+    }
+    return DensityMap(width, height, std::move(values));
+}
+
+DensityMap DensityMap::FromImage(const std::string& path) {
+    ImageData image;
+    if (!Texture::DecodeImage(path, false, image)) return DensityMap();
+    std::vector<float> values(static_cast<size_t>(image.width) * image.height);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = image.pixels[i * image.channels] / 255.0f;
+    return DensityMap(image.width, image.height, std::move(values));
+}
+
+float DensityMap::sample(float u, float v) const {
+    if (values.empty()) return 1.0f;
+    float fx = std::clamp(u * width - 0.5f, 0.0f, static_cast<float>(width - 1));
+    float fy = std::clamp(v * height - 0.5f, 0.0f, static_cast<float>(height - 1));
+    int x0 = static_cast<int>(fx);
+    int y0 = static_cast<int>(fy);
+    int x1 = std::min(x0 + 1, width - 1);
+    int y1 = std::min(y0 + 1, height - 1);
+    float tx = fx - x0;
+    float ty = fy - y0;
+    float top = values[y0 * width + x0] * (1.0f - tx) + values[y0 * width + x1] * tx;
+    float bottom = values[y1 * width + x0] * (1.0f - tx) + values[y1 * width + x1] * tx;
+    return top * (1.0f - ty) + bottom * ty;
+}
+
+ScatterField::ScatterField(const glm::vec2& origin, const glm::vec2& size, float cellSize, uint32_t seed)
+    : origin(origin), extent(size), cellSize(cellSize), seed(seed) {
+    cellsX = std::max(1, static_cast<int>(std::ceil(extent.x / cellSize)));
+    cellsZ = std::max(1, static_cast<int>(std::ceil(extent.y / cellSize)));
+    cellStates.assign(cellsX * cellsZ, HIDDEN);
+    impostorCells.assign(cellsX * cellsZ, 0);
+}
+
+ScatterField::~ScatterField() {
+    for (auto& r : rules) {
+        if (r.vao) glDeleteVertexArrays(1, &r.vao);
+    }
+    if (instanceBuffer) glDeleteBuffers(1, &instanceBuffer);
+}
+
+void ScatterField::setWind(const glm::vec2& direction, float strength) {
+    float len = glm::length(direction);
+    windDirection = len > 0.0f ? direction / len : glm::vec2(1.0f, 0.0f);
+    windStrength = strength;
+}
+
+int ScatterField::addImpostor(std::unique_ptr<ImpostorAtlas> atlas) {
+    return impostors.addAtlas(std::move(atlas));
+}
+
+int ScatterField::addRule(const ScatterRule& rule) {
+    if (!rule.model || !rule.shader || rule.maxScale <= 0.0f) {
+        std::cerr << "Scatter rule needs a model, a program and a positive scale!!!" << std::endl;
+        return -1;
+    }
+    RuleData data;
+    data.rule = rule;
+    rules.push_back(std::move(data));
+    return static_cast<int>(rules.size()) - 1;
+}
+
+void ScatterField::placeCell(size_t ruleIdx, int cx, int cz, std::vector<Instance>& out) const {
+    const ScatterRule& rule = rules[ruleIdx].rule;
+    SeededRandom rng{hash(seed ^ hash(static_cast<uint32_t>(ruleIdx) * 73856093u ^ static_cast<uint32_t>(cx) * 19349663u ^
+                                    static_cast<uint32_t>(cz) * 83492791u))};
+
+    float x0 = origin.x + cx * cellSize;
+    float z0 = origin.y + cz * cellSize;
+    float w = std::min(cellSize, origin.x + extent.x - x0);
+    float h = std::min(cellSize, origin.y + extent.y - z0);
+    // the fraction rounds up or down at random so the mean stays exact
+    float expected = rule.density * w * h;
+    int candidates = static_cast<int>(expected + rng.next());
+
+    for (int i = 0; i < candidates; ++i) {
+        float x = x0 + rng.next() * w;
+        float z = z0 + rng.next() * h;
+        float keep = rng.next();
+        float yaw = rng.next();
+        float scale = rule.minScale + rng.next() * (rule.maxScale - rule.minScale);
+        if (keep >= rule.densityMap.sample((x - origin.x) / extent.x, (z - origin.y) / extent.y)) continue;
+
+        float y = heightAt ? heightAt(x, z) : 0.0f;
+        out.push_back({glm::vec3(x, y, z), toUnorm16(yaw), toUnorm16(scale / rule.maxScale)});
+    }
+}
+
+void ScatterField::build() {
+    int cellCount = cellsX * cellsZ;
+    std::vector<std::vector<Instance>> placed(rules.size() * cellCount);
+    auto placeCells = [&](int begin, int end) {
+        for (int c = begin; c < end; ++c) {
+            for (size_t r = 0; r < rules.size(); ++r) placeCell(r, c % cellsX, c / cellsX, placed[r * cellCount + c]);
+        }
+    };
+    if (workers) {
+        workers->parallelFor(cellCount, 4, placeCells);
+    } else {
+        placeCells(0, cellCount);
+    }
+
+    instances.clear();
+    for (size_t r = 0; r < rules.size(); ++r) {
+        RuleData& data = rules[r];
+        data.cellFirst.resize(cellCount + 1);
+        for (int c = 0; c < cellCount; ++c) {
+            data.cellFirst[c] = static_cast<uint32_t>(instances.size());
+            instances.insert(instances.end(), placed[r * cellCount + c].begin(), placed[r * cellCount + c].end());
+        }
+        data.cellFirst[cellCount] = static_cast<uint32_t>(instances.size());
+    }
+    finishBuild();
+}
+
+bool ScatterField::build(const Instance* placed, size_t count, const uint32_t* cellRanges, size_t rangeCount) {
+    size_t perRule = static_cast<size_t>(cellsX) * cellsZ + 1;
+    if (rangeCount != rules.size() * perRule) {
+        std::cerr << "Scatter placement is for a different field!!!" << std::endl;
+        return false;
+    }
+    // the ranges have to run through the instances in order without gaps
+    bool fits = rangeCount == 0 || cellRanges[0] == 0;
+    for (size_t i = 1; i < rangeCount && fits; ++i) {
+        // a rule starts where the one before it ended
+        fits = i % perRule == 0 ? cellRanges[i] == cellRanges[i - 1] : cellRanges[i] >= cellRanges[i - 1];
+    }
+    if (!fits || (rangeCount ? cellRanges[rangeCount - 1] : 0) != count) {
+        std::cerr << "Scatter placement ranges don't match its instances!!!" << std::endl;
+        return false;
+    }
+
+    instances.assign(placed, placed + count);
+    for (size_t r = 0; r < rules.size(); ++r) {
+        rules[r].cellFirst.assign(cellRanges + r * perRule, cellRanges + (r + 1) * perRule);
+    }
+    finishBuild();
+    return true;
+}
+
+std::vector<uint32_t> ScatterField::getCellRanges() const {
+    std::vector<uint32_t> ranges;
+    for (const auto& data : rules) ranges.insert(ranges.end(), data.cellFirst.begin(), data.cellFirst.end());
+    return ranges;
+}
+
+void ScatterField::finishBuild() {
+    int cellCount = cellsX * cellsZ;
+    cellBounds.assign(cellCount, Aabb());
+    for (size_t r = 0; r < rules.size(); ++r) {
+        RuleData& data = rules[r];
+        const ScatterRule& rule = data.rule;
+        const Aabb& local = rule.model->getBounds();
+        float radius = std::max(std::abs(local.min.x), std::abs(local.max.x));
+        radius = std::max(radius, std::max(std::abs(local.min.z), std::abs(local.max.z))) * 1.415f;
+
+        for (int c = 0; c < cellCount; ++c) {
+            for (uint32_t i = data.cellFirst[c]; i < data.cellFirst[c + 1]; ++i) {
+                const Instance& inst = instances[i];
+                float scale = inst.scale / 65535.0f * rule.maxScale;
+                // any yaw stays inside the circle around the model's y axis
+                cellBounds[c].expand(inst.position + glm::vec3(-radius, local.min.y, -radius) * scale);
+                cellBounds[c].expand(inst.position + glm::vec3(radius, local.max.y, radius) * scale);
+                if (rule.impostor >= 0) {
+                    impostors.add(rule.impostor, static_cast<uint32_t>(c), inst.position, inst.yaw / 65535.0f * 360.0f,
+                                  scale, rule.color);
+                }
+            }
+        }
+    }
+
+    if (!instanceBuffer) glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), instances.data(), GL_STATIC_DRAW);
+
+    // the instance attributes are pointed at each draw's first instance, GL 3.3 has no base instance
+    for (auto& data : rules) {
+        if (data.vao) glDeleteVertexArrays(1, &data.vao);
+        Model* model = data.rule.model;
+        data.vao = Model::CreateVAO(model->getType(), model->getVBO(), model->getEBO());
+        glBindVertexArray(data.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glEnableVertexAttribArray(4);
+        glEnableVertexAttribArray(5);
+        glVertexAttribDivisor(4, 1);
+        glVertexAttribDivisor(5, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    std::cout << "Scatter: " << instances.size() << " instances of " << rules.size() << " rules in " << cellCount
+              << " cells\n";
+}
+
+void ScatterField::addOccluders(OcclusionCuller& culler) const {
+    for (const auto& data : rules) {
+        const ScatterRule& rule = data.rule;
+        if (rule.occluder.indices.empty()) continue;
+        for (uint32_t i = data.cellFirst.front(); i < data.cellFirst.back(); ++i) {
+            const Instance& inst = instances[i];
+            // the same yaw and scale vertex_scatter.glsl applies
+            float yaw = inst.yaw / 65535.0f * TWO_PI;
+            float scale = inst.scale / 65535.0f * rule.maxScale;
+            float c = std::cos(yaw);
+            float s = std::sin(yaw);
+            OccluderMesh mesh;
+            mesh.indices = rule.occluder.indices;
+            for (const glm::vec3& local : rule.occluder.positions) {
+                glm::vec3 p = local * scale;
+                mesh.positions.push_back(inst.position + glm::vec3(c * p.x + s * p.z, p.y, -s * p.x + c * p.z));
+            }
+            culler.addStaticOccluder(std::move(mesh));
+        }
+    }
+}
+
+void ScatterField::cull(const glm::mat4& viewProj, const glm::vec3& eye, float impostorDistance, float maxDistance,
+                        const OcclusionCuller* occlusion) {
+    Frustum frustum(viewProj);
+    for (size_t c = 0; c < cellBounds.size(); ++c) {
+        const Aabb& bounds = cellBounds[c];
+        CellState state = HIDDEN;
+        // a cell's own occluders lie inside its bounds, so it never hides itself
+        if (!bounds.isEmpty() && frustum.test(bounds) != Frustum::Result::OUTSIDE &&
+            !(occlusion && occlusion->isOccluded(bounds))) {
+            float dist = glm::length(glm::clamp(eye, bounds.min, bounds.max) - eye);
+            if (dist <= impostorDistance) state = NEAR;
+            else if (dist <= maxDistance) state = FAR;
+        }
+        cellStates[c] = state;
+        impostorCells[c] = state == FAR;
+    }
+}
+
+void ScatterField::draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos, float time) {
+    int cellCount = static_cast<int>(cellStates.size());
+    for (auto& data : rules) {
+        const ScatterRule& rule = data.rule;
+        const Aabb& local = rule.model->getBounds();
+        bool hasImpostor = rule.impostor >= 0;
+
+        rule.shader->use();
+        rule.shader->SetUniform("view", view);
+        rule.shader->SetUniform("projection", projection);
+        rule.shader->SetUniform("viewPos", viewPos);
+        rule.shader->SetUniform("objectColor", rule.color);
+        rule.shader->SetUniform("maxScale", rule.maxScale);
+        rule.shader->SetUniform("modelBase", local.min.y);
+        rule.shader->SetUniform("modelHeight", std::max(local.max.y - local.min.y, 1e-4f));
+        rule.shader->SetUniform("time", time);
+        rule.shader->SetUniform("windDirection", windDirection);
+        rule.shader->SetUniform("windStrength", windStrength);
+
+        glBindVertexArray(data.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        auto drawn = [&](int cell) {
+            return cellStates[cell] == NEAR || (cellStates[cell] == FAR && !hasImpostor);
+        };
+        // neighbouring drawn cells are neighbours in the buffer too, one call per run
+        int c = 0;
+        while (c < cellCount) {
+            if (!drawn(c)) {
+                ++c;
+                continue;
+            }
+            int runEnd = c + 1;
+            while (runEnd < cellCount && drawn(runEnd)) ++runEnd;
+            uint32_t first = data.cellFirst[c];
+            uint32_t count = data.cellFirst[runEnd] - first;
+            c = runEnd;
+            if (count == 0) continue;
+
+            size_t offset = first * sizeof(Instance);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*)offset);
+            glVertexAttribPointer(5, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(Instance),
+                                  (GLvoid*)(offset + sizeof(glm::vec3)));
+            glDrawElementsInstanced(GL_TRIANGLES, rule.model->getIndexCount(), GL_UNSIGNED_INT, (GLvoid*)0, count);
+        }
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+}
+
+void ScatterField::drawImpostors(Shader& program, const glm::mat4& view, const glm::mat4& projection,
+                                 const glm::vec3& viewPos) {
+    if (impostors.size() == 0) return;
+    impostors.draw(program, impostorCells, view, projection, viewPos);
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Impostors.hpp"
+#include "../spatial/Bounds.hpp"
+#include "../spatial/OcclusionCuller.hpp"
+
+class Model;
+class Shader;
+class ThreadPool;
+
+// scalar field in [0, 1] stretched over a scatter field, sampled bilinearly;
+// an empty map is 1 everywhere
+class DensityMap {
+public:
+    DensityMap() = default;
+    // row 0 at the field's -z edge
+    DensityMap(int width, int height, std::vector<float> values);
+
+    // f gets world x and z of every texel center of a field at origin with size
+    static DensityMap FromFunction(int width, int height, const glm::vec2& origin, const glm::vec2& size,
+                                   const std::function<float(float, float)>& f);
+    // first channel of an image, top row at the -z edge
+    static DensityMap FromImage(const std::string& path);
+
+    // u and v in [0, 1] across the field
+    float sample(float u, float v) const;
+    bool isEmpty() const { return values.empty(); }
+
+private:
+    int width = 0;
+    int height = 0;
+    std::vector<float> values;
+};
+
+struct ScatterRule {
+    Model* model = nullptr;
+    // a lighting program on vertex_scatter.glsl
+    Shader* shader = nullptr;
+    glm::vec3 color = glm::vec3(1.0f);
+    // instances per square unit where the density map is 1
+    float density = 0.1f;
+    float minScale = 1.0f;
+    float maxScale = 1.0f;
+    DensityMap densityMap;
+    // atlas from ScatterField::addImpostor used past the impostor distance,
+    // -1 keeps the mesh at every distance
+    int impostor = -1;
+    // object space, placed with every instance by addOccluders(); empty for
+    // rules that hide nothing
+    OccluderMesh occluder;
+};
+
+// vegetation placed by density rules over a rectangle of ground, kept out
+// of the scene's object list. instances are stored 16 bytes each in one
+// buffer, sorted by rule and then by grid cell, so whole cells are culled at
+// once and each rule draws its visible cells with a few instanced calls.
+// the placement is a function of the seed, the rules and the cell only, so
+// the same field comes out on every run and on any number of threads
+class ScatterField {
+public:
+    // yaw over a full turn and scale over the rule's maxScale as unorm16
+    struct Instance {
+        glm::vec3 position;
+        uint16_t yaw;
+        uint16_t scale;
+    };
+    static_assert(sizeof(Instance) == 16, "scatter instances are uploaded as they are");
+
+    ScatterField(const glm::vec2& origin, const glm::vec2& size, float cellSize, uint32_t seed);
+    ~ScatterField();
+    ScatterField(const ScatterField&) = delete;
+    ScatterField& operator=(const ScatterField&) = delete;
+
+    void setWorkers(ThreadPool* pool) { workers = pool; }
+    // ground height under x, z; instances stand at 0 unless set
+    void setHeightFunction(std::function<float(float, float)> height) { heightAt = std::move(height); }
+    void setWind(const glm::vec2& direction, float strength);
+
+    int addImpostor(std::unique_ptr<ImpostorAtlas> atlas);
+    int addRule(const ScatterRule& rule);
+    // places the instances of every rule and uploads them, needs the GL context
+    void build();
+    // takes the placement of an earlier build() of the same rules and cells,
+    // e.g. from a snapshot, instead of placing again; cellRanges is
+    // getCellRanges() of that field. false, with nothing built, when the
+    // ranges don't fit this field
+    bool build(const Instance* placed, size_t count, const uint32_t* cellRanges, size_t rangeCount);
+
+    // hands the culler the occluder of every instance, after build()
+    void addOccluders(OcclusionCuller& culler) const;
+
+    // frustum test per cell, then meshes up to impostorDistance and
+    // impostors (or meshes of rules without one) up to maxDistance; with
+    // occlusion, cells behind what it rendered this frame are hidden too
+    void cull(const glm::mat4& viewProj, const glm::vec3& eye, float impostorDistance, float maxDistance,
+              const OcclusionCuller* occlusion = nullptr);
+    // the rules' programs need their lights updated; time drives the wind
+    void draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos, float time);
+    // program is impostor_*.glsl with its lights updated
+    void drawImpostors(Shader& program, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos);
+
+    size_t size() const { return instances.size(); }
+    const std::vector<Instance>& getInstances() const { return instances; }
+    // rule after rule, the first instance of every cell and then the end
+    std::vector<uint32_t> getCellRanges() const;
+    int getCellCount() const { return cellsX * cellsZ; }
+
+private:
+    enum CellState : uint8_t {
+        HIDDEN,
+        NEAR,
+        FAR
+    };
+
+    struct RuleData {
+        ScatterRule rule;
+        GLuint vao = 0;
+        // instances of cell c are [cellFirst[c], cellFirst[c + 1])
+        std::vector<uint32_t> cellFirst;
+    };
+
+    glm::vec2 origin;
+    glm::vec2 extent;
+    float cellSize;
+    int cellsX;
+    int cellsZ;
+    uint32_t seed;
+    ThreadPool* workers = nullptr;
+    std::function<float(float, float)> heightAt;
+    glm::vec2 windDirection = glm::vec2(1.0f, 0.0f);
+    float windStrength = 0.05f;
+
+    std::vector<RuleData> rules;
+    std::vector<Instance> instances;
+    std::vector<Aabb> cellBounds;
+    std::vector<CellState> cellStates;
+    std::vector<uint8_t> impostorCells;
+    ImpostorRenderer impostors;
+    GLuint instanceBuffer = 0;
+
+    void placeCell(size_t ruleIdx, int cx, int cz, std::vector<Instance>& out) const;
+    // cell bounds, impostors and GL objects from instances and cellFirst
+    void finishBuild();
+};
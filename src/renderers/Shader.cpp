@@ -23,6 +23,37 @@ Shader::Shader(const char* vertexSrc, const char* fragmentSrc) {
     glDeleteShader(fragment);
 }
 
+Shader::Shader(const char* computeSrc) {
+    GLuint compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &computeSrc, nullptr);
+    glCompileShader(compute);
+    checkCompileErrors(compute, "COMPUTE");
+
+    programID = glCreateProgram();
+    glAttachShader(programID, compute);
+    glLinkProgram(programID);
+    checkCompileErrors(programID, "PROGRAM");
+
+    glDeleteShader(compute);
+}
+
+Shader::Shader(const char* vertexSrc, const std::vector<const char*>& feedbackVaryings) {
+    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex, 1, &vertexSrc, nullptr);
+    glCompileShader(vertex);
+    checkCompileErrors(vertex, "VERTEX");
+
+    programID = glCreateProgram();
+    glAttachShader(programID, vertex);
+    // has to be set before linking
+    glTransformFeedbackVaryings(programID, static_cast<GLsizei>(feedbackVaryings.size()), feedbackVaryings.data(),
+                                GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(programID);
+    checkCompileErrors(programID, "PROGRAM");
+
+    glDeleteShader(vertex);
+}
+
 Shader::~Shader() {
     glDeleteProgram(programID);
 }
@@ -52,46 +83,62 @@ void Shader::update(Subject* subject) {
 
 void Shader::updateAllLights() {
     use();
+    if (lightLocations.size() != lights.size() + 1) {
+        lightLocations.clear();
+        for (size_t i = 0; i < lights.size(); i++) {
+            lightLocations.push_back(findLightLocations("lights[" + std::to_string(i) + "]"));
+        }
+        lightLocations.push_back(findLightLocations("light"));
+        numLightsLocation = glGetUniformLocation(programID, "numLights");
+    }
+
     int numLights = static_cast<int>(lights.size());
-    GLint numLightsLocation = glGetUniformLocation(programID, "numLights");
-    
     if (numLightsLocation != -1) {
-        SetUniform("numLights", numLights);
-        
+        glUniform1i(numLightsLocation, numLights);
         for (int i = 0; i < numLights; i++) {
-            std::string base = "lights[" + std::to_string(i) + "]";
-            SetUniform(base + ".position", lights[i]->getPosition());
-            SetUniform(base + ".direction", lights[i]->getDirection());
-            SetUniform(base + ".color", lights[i]->getColor());
-            SetUniform(base + ".ambient", lights[i]->getAmbient());
-            SetUniform(base + ".diffuse", lights[i]->getDiffuse());
-            SetUniform(base + ".specular", lights[i]->getSpecular());
-            SetUniform(base + ".type", static_cast<int>(lights[i]->getType()));
-            SetUniform(base + ".cutOff", glm::cos(glm::radians(lights[i]->getCutOff())));
-            SetUniform(base + ".outerCutOff", glm::cos(glm::radians(lights[i]->getOuterCutOff())));
-            SetUniform(base + ".constant", lights[i]->getConstant());
-            SetUniform(base + ".linear", lights[i]->getLinear());
-            SetUniform(base + ".quadratic", lights[i]->getQuadratic());
+            setLight(lightLocations[i], *lights[i]);
         }
     }
     
     if (numLights > 0) {
-        SetUniform("light.position", lights[0]->getPosition());
-        SetUniform("light.direction", lights[0]->getDirection());
-        SetUniform("light.color", lights[0]->getColor());
-        SetUniform("light.ambient", lights[0]->getAmbient());
-        SetUniform("light.diffuse", lights[0]->getDiffuse());
-        SetUniform("light.specular", lights[0]->getSpecular());
-        SetUniform("light.type", static_cast<int>(lights[0]->getType()));
-        SetUniform("light.cutOff", glm::cos(glm::radians(lights[0]->getCutOff())));
-        SetUniform("light.outerCutOff", glm::cos(glm::radians(lights[0]->getOuterCutOff())));
-        SetUniform("light.constant", lights[0]->getConstant());
-        SetUniform("light.linear", lights[0]->getLinear());
-        SetUniform("light.quadratic", lights[0]->getQuadratic());
+        setLight(lightLocations.back(), *lights[0]);
     }
     glUseProgram(0);
 }
 
+Shader::LightLocations Shader::findLightLocations(const std::string& base) const {
+    auto find = [&](const char* member) { return glGetUniformLocation(programID, (base + member).c_str()); };
+    LightLocations loc;
+    loc.position = find(".position");
+    loc.direction = find(".direction");
+    loc.color = find(".color");
+    loc.ambient = find(".ambient");
+    loc.diffuse = find(".diffuse");
+    loc.specular = find(".specular");
+    loc.type = find(".type");
+    loc.cutOff = find(".cutOff");
+    loc.outerCutOff = find(".outerCutOff");
+    loc.constant = find(".constant");
+    loc.linear = find(".linear");
+    loc.quadratic = find(".quadratic");
+    return loc;
+}
+
+void Shader::setLight(const LightLocations& loc, const Light& light) const {
+    glUniform3fv(loc.position, 1, glm::value_ptr(light.getPosition()));
+    glUniform3fv(loc.direction, 1, glm::value_ptr(light.getDirection()));
+    glUniform3fv(loc.color, 1, glm::value_ptr(light.getColor()));
+    glUniform1f(loc.ambient, light.getAmbient());
+    glUniform1f(loc.diffuse, light.getDiffuse());
+    glUniform1f(loc.specular, light.getSpecular());
+    glUniform1i(loc.type, static_cast<int>(light.getType()));
+    glUniform1f(loc.cutOff, glm::cos(glm::radians(light.getCutOff())));
+    glUniform1f(loc.outerCutOff, glm::cos(glm::radians(light.getOuterCutOff())));
+    glUniform1f(loc.constant, light.getConstant());
+    glUniform1f(loc.linear, light.getLinear());
+    glUniform1f(loc.quadratic, light.getQuadratic());
+}
+
 bool Shader::checkCompileErrors(GLuint shader, std::string type) {
     GLint success;
     GLchar infoLog[1024];
@@ -113,30 +160,38 @@ bool Shader::checkCompileErrors(GLuint shader, std::string type) {
     return true;
 }
 
-void Shader::SetUniform(const std::string& name, bool value) const {
-    glUniform1i(glGetUniformLocation(programID, name.c_str()), (int)value);
+GLint Shader::getUniformLocation(const char* name) const {
+    auto it = uniformLocations.find(name);
+    if (it != uniformLocations.end()) return it->second;
+    GLint location = glGetUniformLocation(programID, name);
+    uniformLocations.emplace(uniformNames.emplace_back(name), location);
+    return location;
+}
+
+void Shader::SetUniform(const char* name, bool value) const {
+    glUniform1i(getUniformLocation(name), (int)value);
 }
 
-void Shader::SetUniform(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(programID, name.c_str()), value);
+void Shader::SetUniform(const char* name, int value) const {
+    glUniform1i(getUniformLocation(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(programID, name.c_str()), value);
+void Shader::SetUniform(const char* name, float value) const {
+    glUniform1f(getUniformLocation(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, const glm::vec2& value) const {
-    glUniform2fv(glGetUniformLocation(programID, name.c_str()), 1, glm::value_ptr(value));
+void Shader::SetUniform(const char* name, const glm::vec2& value) const {
+    glUniform2fv(getUniformLocation(name), 1, glm::value_ptr(value));
 }
 
-void Shader::SetUniform(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(glGetUniformLocation(programID, name.c_str()), 1, glm::value_ptr(value));
+void Shader::SetUniform(const char* name, const glm::vec3& value) const {
+    glUniform3fv(getUniformLocation(name), 1, glm::value_ptr(value));
 }
 
-void Shader::SetUniform(const std::string& name, const glm::vec4& value) const {
-    glUniform4fv(glGetUniformLocation(programID, name.c_str()), 1, glm::value_ptr(value));
+void Shader::SetUniform(const char* name, const glm::vec4& value) const {
+    glUniform4fv(getUniformLocation(name), 1, glm::value_ptr(value));
 }
 
-void Shader::SetUniform(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(programID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+void Shader::SetUniform(const char* name, const glm::mat4& mat) const {
+    glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
 #include <iostream>
 #include <vector>
 #include "Observer.hpp"
@@ -12,21 +15,29 @@ class Light;
 class Shader : public Observer {
 public:
     Shader(const char* vertexSrc, const char* fragmentSrc);
+    // compute program, needs GL 4.3
+    explicit Shader(const char* computeSrc);
+    // vertex-only program whose outputs are captured interleaved by transform feedback
+    Shader(const char* vertexSrc, const std::vector<const char*>& feedbackVaryings);
     ~Shader();
 
     void use() const;
+    GLuint getID() const { return programID; }
     void update(Subject* subject) override;
 
-    void SetUniform(const std::string& name, bool value) const;
-    void SetUniform(const std::string& name, int value) const;
-    void SetUniform(const std::string& name, float value) const;
-    void SetUniform(const std::string& name, const glm::vec2& value) const;
-    void SetUniform(const std::string& name, const glm::vec3& value) const;
-    void SetUniform(const std::string& name, const glm::vec4& value) const;
-    void SetUniform(const std::string& name, const glm::mat4& mat) const;
+    void SetUniform(const char* name, bool value) const;
+    void SetUniform(const char* name, int value) const;
+    void SetUniform(const char* name, float value) const;
+    void SetUniform(const char* name, const glm::vec2& value) const;
+    void SetUniform(const char* name, const glm::vec3& value) const;
+    void SetUniform(const char* name, const glm::vec4& value) const;
+    void SetUniform(const char* name, const glm::mat4& mat) const;
+    // looked up from GL once per name, -1 when the program has no such uniform
+    GLint getUniformLocation(const char* name) const;
 
     void addLight(Light* light) { 
         lights.push_back(light); 
+        lightLocations.clear();
     }
     void updateAllLights();
     void setAutoUpdateCamera(bool value) { autoUpdateCamera = value; }
@@ -37,5 +48,19 @@ private:
     bool autoUpdateCamera = true;
     bool autoUpdateLight = true;
     std::vector<Light*> lights;
+
+    struct LightLocations {
+        GLint position, direction, color, ambient, diffuse, specular;
+        GLint type, cutOff, outerCutOff, constant, linear, quadratic;
+    };
+    // "lights[i]" for every light, then the single "light" struct; looked up
+    // once so updating lights doesn't build names every frame
+    std::vector<LightLocations> lightLocations;
+    GLint numLightsLocation = -1;
+    // keys view into uniformNames, a deque so they stay put as it grows
+    mutable std::unordered_map<std::string_view, GLint> uniformLocations;
+    mutable std::deque<std::string> uniformNames;
+    LightLocations findLightLocations(const std::string& base) const;
+    void setLight(const LightLocations& loc, const Light& light) const;
     bool checkCompileErrors(GLuint shader, std::string type);
 };
\ No newline at end of file
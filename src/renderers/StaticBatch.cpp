@@ -0,0 +1,101 @@
+#include "StaticBatch.hpp"
+#include "../DrawableObject.hpp"
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+// the scenes keep a uniform scale in m[3][3], divide it out like the shaders do
+glm::vec3 transformPoint(const glm::mat4& m, const glm::vec3& p) {
+    glm::vec4 world = m * glm::vec4(p, 1.0f);
+    return glm::vec3(world) / world.w;
+}
+}
+
+bool StaticBatcher::add(const DrawableObject& obj, const OccluderMesh* occluder) {
+    // the tangent layout stores two components only, it can't be rotated
+    if (!obj.model || !obj.shader || obj.normalMap || obj.model->getType() == ModelType::TAN) {
+        std::cerr << "Object can't be batched statically!!!" << std::endl;
+        return false;
+    }
+    glm::mat4 m = obj.transform ? obj.transform->getMatrix() : glm::mat4(1.0f);
+    glm::vec3 center = TransformBounds(obj.model->getBounds(), m).center();
+    Source s{obj.model, obj.shader, obj.texture, obj.material, m, {},
+             static_cast<int>(std::floor(center.x / cellSize)), static_cast<int>(std::floor(center.z / cellSize))};
+    if (occluder) {
+        s.occluder.indices = occluder->indices;
+        for (const auto& p : occluder->positions) s.occluder.positions.push_back(transformPoint(m, p));
+    }
+    sources.push_back(std::move(s));
+    return true;
+}
+
+std::vector<StaticBatcher::Chunk> StaticBatcher::build() const {
+    // chunk membership, sources in order of first appearance
+    std::vector<std::vector<size_t>> chunkSources;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const Source& s = sources[i];
+        bool placed = false;
+        for (auto& c : chunkSources) {
+            const Source& head = sources[c[0]];
+            if (head.shader == s.shader && head.texture == s.texture && head.model->getType() == s.model->getType() &&
+                head.cellX == s.cellX && head.cellZ == s.cellZ && head.material == s.material) {
+                c.push_back(i);
+                placed = true;
+                break;
+            }
+        }
+        if (!placed) chunkSources.push_back({i});
+    }
+
+    struct Mesh {
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+    };
+    std::unordered_map<Model*, Mesh> meshes;
+
+    std::vector<Chunk> chunks;
+    chunks.reserve(chunkSources.size());
+    for (const auto& c : chunkSources) {
+        const Source& head = sources[c[0]];
+        ModelType type = head.model->getType();
+        int stride = head.model->getStride();
+
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        OccluderMesh occluder;
+        for (size_t idx : c) {
+            const Source& s = sources[idx];
+            auto it = meshes.find(s.model);
+            if (it == meshes.end()) {
+                it = meshes.emplace(s.model, Mesh()).first;
+                s.model->readBack(it->second.vertices, it->second.indices);
+            }
+            const Mesh& mesh = it->second;
+
+            uint32_t base = static_cast<uint32_t>(vertices.size() / stride);
+            glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(s.matrix)));
+            for (size_t v = 0; v < mesh.vertices.size(); v += stride) {
+                const float* src = &mesh.vertices[v];
+                glm::vec3 p = transformPoint(s.matrix, glm::vec3(src[0], src[1], src[2]));
+                vertices.insert(vertices.end(), {p.x, p.y, p.z});
+                if (type == ModelType::BASIC) continue;
+                glm::vec3 n = normalMatrix * glm::vec3(src[3], src[4], src[5]);
+                float len = glm::length(n);
+                if (len > 0.0f) n /= len;
+                vertices.insert(vertices.end(), {n.x, n.y, n.z});
+                vertices.insert(vertices.end(), src + 6, src + stride);
+            }
+            for (uint32_t i : mesh.indices) indices.push_back(base + i);
+
+            uint32_t occluderBase = static_cast<uint32_t>(occluder.positions.size());
+            occluder.positions.insert(occluder.positions.end(), s.occluder.positions.begin(),
+                                      s.occluder.positions.end());
+            for (uint32_t i : s.occluder.indices) occluder.indices.push_back(occluderBase + i);
+        }
+
+        chunks.push_back({std::make_unique<Model>(vertices, indices, stride, type), head.shader, head.texture,
+                          head.material, std::move(occluder), c.size()});
+    }
+    return chunks;
+}
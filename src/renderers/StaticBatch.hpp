@@ -0,0 +1,53 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include "Material.hpp"
+#include "../spatial/OcclusionCuller.hpp"
+
+class Model;
+class Shader;
+class Texture;
+struct DrawableObject;
+
+// bakes objects that never move into world space meshes at scene build time.
+// objects sharing program, texture, material and vertex layout are merged
+// into one vertex and index buffer per cell of a grid over XZ, so the merged
+// chunks are still frustum and occlusion culled one by one. the chunks are
+// drawn with an identity model matrix
+class StaticBatcher {
+public:
+    struct Chunk {
+        std::unique_ptr<Model> model;
+        Shader* shader;
+        Texture* texture;
+        Material material;
+        // the sources' occluders moved to world space, empty when none had one
+        OccluderMesh occluder;
+        size_t sourceCount;
+    };
+
+    explicit StaticBatcher(float cellSize = 20.0f) : cellSize(cellSize) {}
+
+    // the transform is sampled here; objects with a normal map, or an
+    // occluder given in object space, are taken as they are
+    bool add(const DrawableObject& obj, const OccluderMesh* occluder = nullptr);
+    size_t size() const { return sources.size(); }
+
+    // reads the source meshes back once each, needs the GL context
+    std::vector<Chunk> build() const;
+
+private:
+    struct Source {
+        Model* model;
+        Shader* shader;
+        Texture* texture;
+        Material material;
+        glm::mat4 matrix;
+        OccluderMesh occluder;
+        int cellX, cellZ;
+    };
+
+    float cellSize;
+    std::vector<Source> sources;
+};
@@ -1,4 +1,6 @@
 #include "Texture.hpp"
+#include "../AssetCache.hpp"
+#include <cstring>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
@@ -22,15 +24,36 @@ Texture::~Texture() {
     }
 }
 
-bool Texture::load(const std::string& path) {
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+bool Texture::DecodeImage(const std::string& path, bool flipVertically, ImageData& out) {
+    unsigned char* data = stbi_load(path.c_str(), &out.width, &out.height, &out.channels, 0);
 
     if (!data) {
         std::cerr << "STB: Failed to load image!!! " << path << std::endl;
         std::cerr << "Reason: " << stbi_failure_reason() << std::endl;
         return false;
     }
+
+    size_t rowSize = static_cast<size_t>(out.width) * out.channels;
+    out.pixels.resize(rowSize * out.height);
+    for (int y = 0; y < out.height; ++y) {
+        int srcRow = flipVertically ? out.height - 1 - y : y;
+        std::memcpy(out.pixels.data() + y * rowSize, data + srcRow * rowSize, rowSize);
+    }
+    stbi_image_free(data);
+    return true;
+}
+
+bool Texture::load(const std::string& path) {
+    std::shared_ptr<ImageData> image = AssetCache::instance().takeImage(path);
+    if (!image) {
+        image = std::make_shared<ImageData>();
+        if (!DecodeImage(path, true, *image)) {
+            return false;
+        }
+    }
+    width = image->width;
+    height = image->height;
+    channels = image->channels;
     
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
@@ -47,9 +70,8 @@ bool Texture::load(const std::string& path) {
     else if (channels == 4)
         format = GL_RGBA;
     
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, image->pixels.data());
     glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
     glBindTexture(GL_TEXTURE_2D, 0);
     
     std::cout << "Loaded texture: " << path << " (" << width << "x" << height << ", " << channels << " channels)" << std::endl;
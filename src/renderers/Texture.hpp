@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+struct ImageData;
+
 class Texture {
 public:
     Texture(const std::string& path);
@@ -18,6 +20,10 @@ public:
     int getHeight() const { return height; }
     bool isCubemap() const { return cubemap; }
 
+    // flips rows by hand instead of through stb's global flag so decoding
+    // stays safe on worker threads
+    static bool DecodeImage(const std::string& path, bool flipVertically, ImageData& out);
+
 private:
     GLuint textureID;
     int width;
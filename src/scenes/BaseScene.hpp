@@ -1,6 +1,8 @@
 #pragma once
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <set>
@@ -8,6 +10,7 @@
 #include "../Utils.hpp"
 #include "../trans/Transform.hpp"
 #include "../trans/TransformComposite.hpp"
+#include "../trans/StaticComposite.hpp"
 #include "../trans/TransformIdentity.hpp"
 #include "../trans/TransformMatrix.hpp"
 #include "../trans/TransformRotation.hpp"
@@ -15,18 +18,28 @@
 #include "../trans/TransformTranslation.hpp"
 #include "../trans/TransformLinear.hpp"
 #include "../trans/TransformBezier.hpp"
+#include "../trans/BezierFollowers.hpp"
 #include "../ModelFactory.hpp"
 #include "../renderers/Light.hpp"
 #include "../renderers/Shader.hpp"
 #include "../Model.hpp"
 #include "../renderers/Texture.hpp"
 #include "../renderers/Material.hpp"
+#include "../renderers/RenderQueue.hpp"
+#include "../renderers/InstanceGroup.hpp"
+#include "../renderers/GpuTimer.hpp"
+#include "../renderers/StaticBatch.hpp"
 #include "../DrawableObject.hpp"
 #include "../Camera.hpp"
+#include "../AssetCache.hpp"
+#include "../spatial/Bvh.hpp"
+#include "../spatial/OcclusionCuller.hpp"
 
 class BaseScene {
 public:
-    std::vector<DrawableObject> objects;
+    // dense, so per-frame loops walk it by index; removal moves the last
+    // object into the hole, anything kept across frames holds an ObjectHandle
+    SlotMap<DrawableObject> objects;
     Camera* attachedCamera = nullptr;
 
     virtual ~BaseScene() = default;
@@ -34,17 +47,82 @@ public:
     virtual void draw() = 0;
     virtual void attachToCamera(Camera* camera) = 0;
     virtual void detachFromCamera(Camera* camera) = 0;
+    // files init() is going to load, so they can be read ahead of activation
+    virtual void declareAssets(AssetManifest& assets) const {}
+
+    bool isInitialized() const { return initialized; }
+
+    void setWorkers(ThreadPool* pool) {
+        workers = pool;
+        occlusion.setWorkers(pool);
+    }
+
+    void setFrameArena(FrameArena* arena) {
+        renderQueue.setArena(arena);
+    }
+
+    void activate(Camera* camera) {
+        if (!initialized) {
+            init();
+            initialized = true;
+        }
+        attachToCamera(camera);
+    }
+
+    void deactivate(Camera* camera) {
+        detachFromCamera(camera);
+    }
     
-    void addObject(Model* model, Shader* shader, std::shared_ptr<Transform> transform, 
-                   Texture* texture = nullptr, Material material = Material::Plastic()) {
-        objects.push_back({model, shader, transform, texture, nullptr, material, 1});
+    ObjectHandle addObject(Model* model, Shader* shader, std::shared_ptr<Transform> transform, 
+                           Texture* texture = nullptr, Material material = Material::Plastic()) {
+        ObjectHandle handle = objects.insert({model, shader, transform, texture, nullptr, material, 1});
+        layerLists.add(objects.size() - 1, objects.back().layers);
+        return handle;
     }
     
-    void addObjectWithNormalMap(Model* model, Shader* shader, std::shared_ptr<Transform> transform, 
-                                Texture* texture, Texture* normalMap, Material material = Material::Plastic(),
-                                int normalIntensity = 1) {
-        objects.push_back({model, shader, transform, texture, normalMap, material, normalIntensity});
+    ObjectHandle addObjectWithNormalMap(Model* model, Shader* shader, std::shared_ptr<Transform> transform, 
+                                        Texture* texture, Texture* normalMap, Material material = Material::Plastic(),
+                                        int normalIntensity = 1) {
+        ObjectHandle handle = objects.insert({model, shader, transform, texture, normalMap, material, normalIntensity});
+        layerLists.add(objects.size() - 1, objects.back().layers);
+        return handle;
+    }
+
+    // O(1), the last object takes the removed one's index and every
+    // subsystem holding object indices is told about the move
+    bool removeObject(ObjectHandle handle) {
+        const DrawableObject* removed = objects.get(handle);
+        if (!removed) {
+            std::cerr << "Removing an object that is already gone!!!" << std::endl;
+            return false;
+        }
+        uint32_t removedLayers = removed->layers;
+        size_t last = objects.size() - 1;
+        size_t idx = objects.remove(handle);
+        layerLists.remove(idx, removedLayers, last, idx != last ? objects[idx].layers : 0);
+        for (auto& group : instanceGroups) group->removeObject(idx, last);
+        occlusion.removeObject(idx, last);
+        if (last < visibility.size()) {
+            visibility[idx] = visibility[last];
+            visibility.pop_back();
+        }
+        return true;
     }
+
+    DrawableObject* getObject(ObjectHandle handle) { return objects.get(handle); }
+
+    void setLayers(ObjectHandle handle, uint32_t layers) {
+        size_t idx = objects.indexOf(handle);
+        if (idx == SlotMap<DrawableObject>::NONE || objects[idx].layers == layers) return;
+        layerLists.change(idx, objects[idx].layers, layers);
+        objects[idx].layers = layers;
+    }
+
+    // object indices of one RenderLayer bit, valid until the next add or remove
+    const std::vector<uint32_t>& layerMembers(uint32_t layer) const { return layerLists.members(layer); }
+
+    // dense index for per-frame arrays like the visibility flags, SIZE_MAX when gone
+    size_t indexOf(ObjectHandle handle) const { return objects.indexOf(handle); }
     
     void attachToCameraImpl(Camera* camera) {
         attachedCamera = camera;
@@ -55,7 +133,7 @@ public:
                 uniqueShaders.insert(obj.shader);
             }
         }
-        camera->notify();
+        camera->refreshObservers();
     }
     
     void detachFromCameraImpl(Camera* camera) {
@@ -69,43 +147,242 @@ public:
         }
     }
 
+    void toggleCulling() {
+        cullingEnabled = !cullingEnabled;
+        std::cout << "Frustum culling: " << (cullingEnabled ? "on" : "off") << std::endl;
+    }
+
+    // refreshes the BVH and marks which objects touch the camera frustum and
+    // aren't hidden behind the occluders, instance groups drop their culled instances
+    void cullObjects() {
+        bvh.update(objects.dense());
+        if (!cullingEnabled || !attachedCamera) {
+            visibility.assign(objects.size(), 1);
+        } else {
+            glm::mat4 viewProj = attachedCamera->getProjMat() * attachedCamera->getViewMat();
+            bvh.queryFrustum(Frustum(viewProj), visibility);
+            if (occlusion.hasOccluders()) occlusion.cull(objects.dense(), bvh, viewProj, visibility);
+        }
+        for (auto& group : instanceGroups) group->setVisibility(visibility);
+    }
+
+    // also starts timing the opaque pass on the GPU, printStats() shows the
+    // average since the last toggle so both settings can be compared per scene
+    void toggleDepthPrepass() {
+        depthPrepass = !depthPrepass;
+        timingEnabled = true;
+        opaqueTimer.reset();
+        std::cout << "Depth pre-pass: " << (depthPrepass ? "on" : "off") << std::endl;
+    }
+
+    // what the last frame drew, printed on a key press so the draw path stays quiet
+    virtual void printStats() const {
+        renderQueue.logStats("Render queue");
+        if (timingEnabled) {
+            std::cout << "Opaque pass: " << opaqueTimer.getAverageMs() << " ms over " << opaqueTimer.getSampleCount()
+                      << " frames, depth pre-pass " << (depthPrepass ? "on" : "off") << std::endl;
+        }
+    }
+
+    bool isVisible(size_t objectIndex) const {
+        return objectIndex >= visibility.size() || visibility[objectIndex];
+    }
+
+    bool isVisible(ObjectHandle handle) const {
+        size_t idx = objects.indexOf(handle);
+        return idx != SlotMap<DrawableObject>::NONE && isVisible(idx);
+    }
+
+    // draws every visible object through the render queue, grouped by program,
+    // material, texture and VAO rather than in insertion order
     void drawImpl() {
-        for (auto& obj : objects) {
-            obj.shader->use();
-            obj.shader->SetUniform("material.shininess", obj.material.getShininess());
-            obj.shader->SetUniform("material.ambient", obj.material.getAmbient());
-            obj.shader->SetUniform("material.diffuse", obj.material.getDiffuse());
-            obj.shader->SetUniform("material.specular", obj.material.getSpecular());
-            
-            if (obj.texture) {
-                obj.texture->bind(0);
-                obj.shader->SetUniform("textureSampler", 0);
-                obj.shader->SetUniform("useTexture", true);
-            } else {
-                obj.shader->SetUniform("useTexture", false);
+        cullObjects();
+        renderQueue.clear();
+        glm::vec3 viewPos = attachedCamera ? attachedCamera->getPosition() : glm::vec3(0.0f);
+        renderQueue.submit(objects.dense(), layerMembers(RenderLayer::OPAQUE), viewPos, 0, &visibility);
+        renderQueue.sort();
+        executeOpaque();
+    }
+
+    // the sorted queue and the instance groups; with the pre-pass on, depth is
+    // laid down by a position-only program first and the lighting shaders run
+    // with GL_EQUAL, once per visible pixel
+    void executeOpaque() {
+        if (timingEnabled) opaqueTimer.begin();
+
+        if (depthPrepass && attachedCamera && loadDepthShader()) {
+            depthShader->use();
+            depthShader->SetUniform("view", attachedCamera->getViewMat());
+            depthShader->SetUniform("projection", attachedCamera->getProjMat());
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            renderQueue.executeDepth(*depthShader);
+            for (auto& group : instanceGroups) {
+                group->update();
+                group->drawDepth(*depthShader);
             }
-            
-            if (obj.normalMap && obj.model->getType() == ModelType::TAN) {
-                obj.normalMap->bind(1);
-                obj.shader->SetUniform("normalMap", 1);
-                obj.shader->SetUniform("useNormalMap", true);
-                obj.shader->SetUniform("normalIntensity", obj.normalIntensity);
-            } else {
-                obj.shader->SetUniform("useNormalMap", false);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+            glDepthFunc(GL_EQUAL);
+            glDepthMask(GL_FALSE);
+            renderQueue.execute();
+            drawInstanceGroups();
+            glDepthMask(GL_TRUE);
+            glDepthFunc(GL_LESS);
+        } else {
+            renderQueue.execute();
+            drawInstanceGroups();
+        }
+
+        if (timingEnabled) opaqueTimer.end();
+    }
+
+    // stencil picking IDs of the visible PICKABLE objects, written after the
+    // shaded passes by position-only draws that pass only where the object's
+    // depth is the visible one; everything else keeps 0 from the clear
+    void writeStencilIds() {
+        const auto& pickable = layerMembers(RenderLayer::PICKABLE);
+        if (pickable.empty() || !attachedCamera || !loadDepthShader()) return;
+
+        depthShader->use();
+        depthShader->SetUniform("view", attachedCamera->getViewMat());
+        depthShader->SetUniform("projection", attachedCamera->getProjMat());
+        depthShader->SetUniform("useInstancing", false);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_LEQUAL);
+        glEnable(GL_STENCIL_TEST);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+        glStencilMask(0xFF);
+
+        for (uint32_t idx : pickable) {
+            if (!isVisible(idx)) continue;
+            const auto& obj = objects[idx];
+            glStencilFunc(GL_ALWAYS, obj.pickId, 0xFF);
+            depthShader->SetUniform("model", obj.transform->getMatrix());
+            obj.model->drawPositions(GL_TRIANGLES);
+        }
+
+        glStencilMask(0x00);
+        glDisable(GL_STENCIL_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glUseProgram(0);
+    }
+
+    // puts objects in [first, last) that share model, shader, texture and material
+    // into instance groups; groups smaller than minGroupSize stay per-object
+    void buildInstanceGroups(size_t first = 0, size_t last = SIZE_MAX, size_t minGroupSize = 2) {
+        last = std::min(last, objects.size());
+        std::vector<std::vector<size_t>> candidates;
+        for (size_t i = first; i < last; ++i) {
+            const auto& obj = objects[i];
+            if (obj.instanced || obj.normalMap) continue;
+
+            bool placed = false;
+            for (auto& c : candidates) {
+                const auto& head = objects[c[0]];
+                if (head.model == obj.model && head.shader == obj.shader && head.texture == obj.texture &&
+                    head.material == obj.material) {
+                    c.push_back(i);
+                    placed = true;
+                    break;
+                }
             }
-            
-            glm::mat4 model = obj.transform->getMatrix();
-            obj.shader->SetUniform("model", model);
-            obj.model->draw(GL_TRIANGLES);
-            
-            if (obj.texture) {
-                obj.texture->unbind();
+            if (!placed) candidates.push_back({i});
+        }
+
+        for (const auto& c : candidates) {
+            if (c.size() >= minGroupSize) addInstanceGroup(c);
+        }
+    }
+
+    // declared group, the objects must share model, shader, texture and material
+    InstanceGroup* addInstanceGroup(const std::vector<size_t>& objectIndices) {
+        if (objectIndices.empty()) return nullptr;
+        const auto& head = objects[objectIndices[0]];
+        auto group = std::make_unique<InstanceGroup>(head.model, head.shader, head.texture, head.material);
+        for (size_t idx : objectIndices) {
+            if (!group->matches(objects[idx])) {
+                std::cerr << "Object " << idx << " does not fit its instance group!!!" << std::endl;
+                continue;
             }
-            if (obj.normalMap) {
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, 0);
+            group->add(objects[idx].transform, idx);
+            objects[idx].instanced = true;
+        }
+        instanceGroups.push_back(std::move(group));
+        return instanceGroups.back().get();
+    }
+
+    // replaces objects that never move after init() by merged world space
+    // chunks, see StaticBatcher; occluders of the objects move to their chunk.
+    // the given handles are gone afterwards
+    void batchStatic(const std::vector<ObjectHandle>& handles, float cellSize = 20.0f) {
+        StaticBatcher batcher(cellSize);
+        std::vector<ObjectHandle> batched;
+        for (ObjectHandle h : handles) {
+            size_t idx = objects.indexOf(h);
+            if (idx == SlotMap<DrawableObject>::NONE) continue;
+            const DrawableObject& obj = objects[idx];
+            if (obj.instanced || obj.layers != RenderLayer::OPAQUE) {
+                std::cerr << "Object " << idx << " is instanced or on other layers, not batched!!!" << std::endl;
+                continue;
             }
+            if (batcher.add(obj, occlusion.findOccluder(idx))) batched.push_back(h);
+        }
+
+        std::vector<StaticBatcher::Chunk> chunks = batcher.build();
+        for (ObjectHandle h : batched) removeObject(h);
+
+        auto identity = std::make_shared<TransformIdentity>();
+        for (auto& chunk : chunks) {
+            if (!chunk.occluder.indices.empty()) occlusion.addOccluder(objects.size(), std::move(chunk.occluder));
+            addObject(chunk.model.get(), chunk.shader, identity, chunk.texture, chunk.material);
+            staticChunks.push_back(std::move(chunk.model));
+        }
+        std::cout << "Static batching: " << batched.size() << " objects into " << chunks.size() << " chunks\n";
+    }
+
+    void drawInstanceGroups() {
+        for (auto& group : instanceGroups) {
+            group->update();
+            group->draw();
         }
         glUseProgram(0);
     }
+
+protected:
+    RenderQueue renderQueue;
+    std::vector<std::unique_ptr<InstanceGroup>> instanceGroups;
+    // merged meshes of batchStatic()
+    std::vector<std::unique_ptr<Model>> staticChunks;
+    Bvh bvh;
+    OcclusionCuller occlusion;
+    ThreadPool* workers = nullptr;
+    // one flag per object, filled by cullObjects(). kept off the frame arena:
+    // removeObject() edits it between frames, after the arena was reset
+    std::vector<uint8_t> visibility;
+    LayerLists layerLists;
+    bool cullingEnabled = true;
+    bool depthPrepass = false;
+    std::unique_ptr<Shader> depthShader;
+    GpuTimer opaqueTimer;
+    bool timingEnabled = false;
+
+    bool loadDepthShader() {
+        if (!depthShader) {
+            std::string vertexSrc = loadShaderSrc("src/shaders/vertex_depth.glsl");
+            std::string fragmentSrc = loadShaderSrc("src/shaders/frag_depth.glsl");
+            if (vertexSrc.empty() || fragmentSrc.empty()) {
+                std::cerr << "Depth pre-pass shaders missing!!!" << std::endl;
+                depthPrepass = false;
+                return false;
+            }
+            depthShader = std::make_unique<Shader>(vertexSrc.c_str(), fragmentSrc.c_str());
+        }
+        return true;
+    }
+
+private:
+    bool initialized = false;
 };
\ No newline at end of file
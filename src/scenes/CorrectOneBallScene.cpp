@@ -1,11 +1,17 @@
 #include "CorrectOneBallScene.hpp"
 #include <string>
 
+namespace {
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/vertex.glsl");
+const std::string FRAG_PHONG_CORRECT_SHADER = SCENE_ASSETS.shader("src/shaders/frag_phong_correct.glsl");
+}
+
 CorrectOneBallScene::CorrectOneBallScene() {}
 
 void CorrectOneBallScene::init() {
-    std::string vertexSrc = loadShaderSrc("src/shaders/vertex.glsl");
-    std::string fragSrc   = loadShaderSrc("src/shaders/frag_phong_correct.glsl");
+    std::string vertexSrc = loadShaderSrc(VERTEX_SHADER);
+    std::string fragSrc   = loadShaderSrc(FRAG_PHONG_CORRECT_SHADER);
     shader = std::make_unique<Shader>(vertexSrc.c_str(), fragSrc.c_str());
 
     sphereModel = ModelFactory::CreateSphere();
@@ -40,4 +46,8 @@ void CorrectOneBallScene::attachToCamera(Camera* camera) {
 
 void CorrectOneBallScene::detachFromCamera(Camera* camera) {
     detachFromCameraImpl(camera);
+}
+
+void CorrectOneBallScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
 }
\ No newline at end of file
@@ -4,13 +4,21 @@
 #include <ctime>
 #include <string>
 
+namespace {
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/vertex.glsl");
+const std::string FRAG_GREEN_SHADER = SCENE_ASSETS.shader("src/shaders/frag_green.glsl");
+const std::string FRAG_TRIANGLE_SHADER = SCENE_ASSETS.shader("src/shaders/frag_triangle.glsl");
+const std::string FRAG_RECTANGLE_SHADER = SCENE_ASSETS.shader("src/shaders/frag_rectangle.glsl");
+}
+
 void ForestScene::init() {
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
 
-    std::string vertexSrc = loadShaderSrc("src/shaders/vertex.glsl");
-    std::string fragGreenSrc = loadShaderSrc("src/shaders/frag_green.glsl");
-    std::string fragTriangleSrc = loadShaderSrc("src/shaders/frag_triangle.glsl");
-    std::string fragRectangleSrc = loadShaderSrc("src/shaders/frag_rectangle.glsl");
+    std::string vertexSrc = loadShaderSrc(VERTEX_SHADER);
+    std::string fragGreenSrc = loadShaderSrc(FRAG_GREEN_SHADER);
+    std::string fragTriangleSrc = loadShaderSrc(FRAG_TRIANGLE_SHADER);
+    std::string fragRectangleSrc = loadShaderSrc(FRAG_RECTANGLE_SHADER);
     bushShader = std::make_unique<Shader>(vertexSrc.c_str(), fragGreenSrc.c_str());
     treeShader = std::make_unique<Shader>(vertexSrc.c_str(), fragRectangleSrc.c_str());
     plainShader = std::make_unique<Shader>(vertexSrc.c_str(), fragTriangleSrc.c_str());
@@ -19,35 +27,36 @@ void ForestScene::init() {
     treeModel = ModelFactory::CreateTree();
     plainModel = ModelFactory::CreatePlain();
 
-    auto plainTransform = std::make_shared<TransformComposite>();
-    plainTransform->add(std::make_shared<TransformTranslation>(glm::vec3(0.0f, -1.0f, 0.0f)));
-    plainTransform->add(std::make_shared<TransformScale>(glm::vec3(20.0f, 1.0f, 20.0f)));
+    auto plainTransform = std::make_shared<TransformTS>(
+        TransformTranslation(glm::vec3(0.0f, -1.0f, 0.0f)),
+        TransformScale(glm::vec3(20.0f, 1.0f, 20.0f))
+    );
     addObject(plainModel.get(), plainShader.get(), plainTransform);
 
     for (int i = 0; i < 50; ++i) {
-        auto bushTransform = std::make_shared<TransformComposite>();
         float x = ((rand() % 400) / 10.0f) - 20.0f;
         float z = ((rand() % 400) / 10.0f) - 20.0f;
-        bushTransform->add(std::make_shared<TransformTranslation>(glm::vec3(x, -1.0f, z)));
-        bushTransform->add(std::make_shared<TransformRotation>(
-            static_cast<float>(rand() % 360), glm::vec3(0.0f, 1.0f, 0.0f)
-        ));
+        float angle = static_cast<float>(rand() % 360);
         float scale = 0.3f + ((rand() % 50) / 100.0f);
-        bushTransform->add(std::make_shared<TransformScale>(glm::vec3(scale, scale, scale)));
+        auto bushTransform = std::make_shared<TransformTRS>(
+            TransformTranslation(glm::vec3(x, -1.0f, z)),
+            TransformRotation(angle, glm::vec3(0.0f, 1.0f, 0.0f)),
+            TransformScale(glm::vec3(scale, scale, scale))
+        );
         
         addObject(bushModel.get(), bushShader.get(), bushTransform);
     }
 
     for (int i = 0; i < 50; ++i) {
-        auto treeTransform = std::make_shared<TransformComposite>();
         float x = ((rand() % 400) / 10.0f) - 20.0f;
         float z = ((rand() % 400) / 10.0f) - 20.0f;
-        treeTransform->add(std::make_shared<TransformTranslation>(glm::vec3(x, -1.0f, z)));
-        treeTransform->add(std::make_shared<TransformRotation>(
-            static_cast<float>(rand() % 360), glm::vec3(0.0f, 1.0f, 0.0f)
-        ));
+        float angle = static_cast<float>(rand() % 360);
         float scale = 0.5f + ((rand() % 70) / 100.0f);
-        treeTransform->add(std::make_shared<TransformScale>(glm::vec3(scale, scale, scale)));
+        auto treeTransform = std::make_shared<TransformTRS>(
+            TransformTranslation(glm::vec3(x, -1.0f, z)),
+            TransformRotation(angle, glm::vec3(0.0f, 1.0f, 0.0f)),
+            TransformScale(glm::vec3(scale, scale, scale))
+        );
         
         addObject(treeModel.get(), treeShader.get(), treeTransform);
     }
@@ -63,4 +72,8 @@ void ForestScene::attachToCamera(Camera* camera) {
 
 void ForestScene::detachFromCamera(Camera* camera) {
     detachFromCameraImpl(camera);
+}
+
+void ForestScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
 }
\ No newline at end of file
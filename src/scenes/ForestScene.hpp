@@ -9,6 +9,7 @@ public:
     void draw() override;
     void attachToCamera(Camera* camera) override;
     void detachFromCamera(Camera* camera) override;
+    void declareAssets(AssetManifest& assets) const override;
 
 private:
     std::unique_ptr<Shader> bushShader;
@@ -5,23 +5,58 @@
 #include <string>
 #include <iostream>
 
+namespace {
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/vertex.glsl");
+const std::string VERTEX_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/vertex_textured.glsl");
+const std::string FRAG_RECTANGLE_SHADER = SCENE_ASSETS.shader("src/shaders/frag_rectangle.glsl");
+const std::string MULT_PHONG_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/mult_phong_textured.glsl");
+const std::string MULT_PHONG_MATERIAL_SHADER = SCENE_ASSETS.shader("src/shaders/mult_phong_material.glsl");
+const std::string MULT_PHONG_TEXTURED_MATERIAL_SHADER = SCENE_ASSETS.shader("src/shaders/mult_phong_textured_material.glsl");
+const std::string SKYBOX_VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/skybox_vertex.glsl");
+const std::string SKYBOX_FRAGMENT_SHADER = SCENE_ASSETS.shader("src/shaders/skybox_fragment.glsl");
+const std::string CUBE_VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/cube_vertex.glsl");
+const std::string CUBE_FRAGMENT_SHADER = SCENE_ASSETS.shader("src/shaders/cube_fragment.glsl");
+const std::string VERTEX_TAN_SHADER = SCENE_ASSETS.shader("src/shaders/vertex_tan.glsl");
+const std::string MULT_PHONG_T_M_NORMAL_SHADER = SCENE_ASSETS.shader("src/shaders/mult_phong_t_m_normal.glsl");
+const std::string GRUNGE_TEXTURE = SCENE_ASSETS.texture("src/images/grunge.jpg");
+const std::string MODEL_TEXTURE = SCENE_ASSETS.texture("src/images/model.png");
+const std::string GOLD_TEXTURE = SCENE_ASSETS.texture("src/images/gold.jpg");
+const std::string GRASS_TEXTURE = SCENE_ASSETS.texture("src/images/grass.png");
+const std::string ALBEDO2_TEXTURE = SCENE_ASSETS.texture("src/images/albedo2.png");
+const std::string NORMALMAP_TEXTURE = SCENE_ASSETS.texture("src/images/normalmap.png");
+const ModelFile LOGIN_MODEL = SCENE_ASSETS.model("src/objects/pytel.obj", ModelType::UV);
+const ModelFile HOUSE_MODEL = SCENE_ASSETS.model("src/objects/model.obj", ModelType::UV);
+const ModelFile FORMULA_MODEL = SCENE_ASSETS.model("src/objects/formula1.obj", ModelType::NORMAL);
+const ModelFile CUP_MODEL = SCENE_ASSETS.model("src/objects/cup.obj", ModelType::UV);
+const ModelFile BICYCLE_MODEL = SCENE_ASSETS.model("src/objects/bicycle.obj", ModelType::UV);
+const ModelFile GROUND_MODEL = SCENE_ASSETS.model("src/objects/teren.obj", ModelType::UV);
+const ModelFile BOX_MODEL = SCENE_ASSETS.model("src/objects/Nmodel.obj", ModelType::TAN);
+// only read when the indirect path is supported
+AssetManifest INDIRECT_ASSETS;
+const std::string VERTEX_INDIRECT_SHADER = INDIRECT_ASSETS.shader("src/shaders/vertex_indirect.glsl");
+const std::string FRAG_INDIRECT_SHADER = INDIRECT_ASSETS.shader("src/shaders/frag_indirect.glsl");
+const std::string CULL_COMPUTE_SHADER = INDIRECT_ASSETS.shader("src/shaders/cull_compute.glsl");
+const std::string HIZ_COMPUTE_SHADER = INDIRECT_ASSETS.shader("src/shaders/hiz_compute.glsl");
+}
+
 void ModelScene::init() {
     // VERTS
-    std::string vertexSrc = loadShaderSrc("src/shaders/vertex.glsl");
-    std::string vertexTexturedSrc = loadShaderSrc("src/shaders/vertex_textured.glsl");
+    std::string vertexSrc = loadShaderSrc(VERTEX_SHADER);
+    std::string vertexTexturedSrc = loadShaderSrc(VERTEX_TEXTURED_SHADER);
     // FRAGS
-    std::string fragSrc = loadShaderSrc("src/shaders/frag_rectangle.glsl");
-    std::string fragPhongTexturedSrc = loadShaderSrc("src/shaders/mult_phong_textured.glsl");
-    std::string fragPhongMaterialSrc = loadShaderSrc("src/shaders/mult_phong_material.glsl");
-    std::string fragPhongTexturedMaterialSrc = loadShaderSrc("src/shaders/mult_phong_textured_material.glsl");
+    std::string fragSrc = loadShaderSrc(FRAG_RECTANGLE_SHADER);
+    std::string fragPhongTexturedSrc = loadShaderSrc(MULT_PHONG_TEXTURED_SHADER);
+    std::string fragPhongMaterialSrc = loadShaderSrc(MULT_PHONG_MATERIAL_SHADER);
+    std::string fragPhongTexturedMaterialSrc = loadShaderSrc(MULT_PHONG_TEXTURED_MATERIAL_SHADER);
     // SKYBOX shaders
-    std::string skyboxVertexSrc = loadShaderSrc("src/shaders/skybox_vertex.glsl");
-    std::string skyboxFragmentSrc = loadShaderSrc("src/shaders/skybox_fragment.glsl");
-    std::string cubeVertexSrc = loadShaderSrc("src/shaders/cube_vertex.glsl");
-    std::string cubeFragmentSrc = loadShaderSrc("src/shaders/cube_fragment.glsl");
+    std::string skyboxVertexSrc = loadShaderSrc(SKYBOX_VERTEX_SHADER);
+    std::string skyboxFragmentSrc = loadShaderSrc(SKYBOX_FRAGMENT_SHADER);
+    std::string cubeVertexSrc = loadShaderSrc(CUBE_VERTEX_SHADER);
+    std::string cubeFragmentSrc = loadShaderSrc(CUBE_FRAGMENT_SHADER);
     // NORMAL MAP STUFF
-    std::string normalMapVertexSrc = loadShaderSrc("src/shaders/vertex_tan.glsl");
-    std::string normalMapFragmentSrc = loadShaderSrc("src/shaders/mult_phong_t_m_normal.glsl");
+    std::string normalMapVertexSrc = loadShaderSrc(VERTEX_TAN_SHADER);
+    std::string normalMapFragmentSrc = loadShaderSrc(MULT_PHONG_T_M_NORMAL_SHADER);
     
     modelShader = std::make_unique<Shader>(vertexSrc.c_str(), fragSrc.c_str());
     plainShader = std::make_unique<Shader>(vertexTexturedSrc.c_str(), fragPhongTexturedSrc.c_str());
@@ -34,22 +69,22 @@ void ModelScene::init() {
     //
     normalMapShader = std::make_unique<Shader>(normalMapVertexSrc.c_str(), normalMapFragmentSrc.c_str());
 
-    loginModel = ModelFactory::CreateLogin();
-    houseModel = ModelFactory::CreateHouse();
-    formulaModel = ModelFactory::CreateFormula();
-    cupModel = ModelFactory::CreateCup();
-    bicycleModel = ModelFactory::CreateBicycle();
-    plainModel = ModelFactory::CreateNPlain();
+    loginModel = Model::LoadFromFile(LOGIN_MODEL);
+    houseModel = Model::LoadFromFile(HOUSE_MODEL);
+    formulaModel = Model::LoadFromFile(FORMULA_MODEL);
+    cupModel = Model::LoadFromFile(CUP_MODEL);
+    bicycleModel = Model::LoadFromFile(BICYCLE_MODEL);
+    plainModel = Model::LoadFromFile(GROUND_MODEL);
     skyboxModel = ModelFactory::CreateCube();
-    boxModel = ModelFactory::CreateBox();
+    boxModel = Model::LoadFromFile(BOX_MODEL);
 
-    loginTexture = std::make_unique<Texture>("src/images/grunge.jpg");
-    houseTexture = std::make_unique<Texture>("src/images/model.png");
-    goldTexture = std::make_unique<Texture>("src/images/gold.jpg");
-    grassTexture = std::make_unique<Texture>("src/images/grass.png");
+    loginTexture = std::make_unique<Texture>(GRUNGE_TEXTURE);
+    houseTexture = std::make_unique<Texture>(MODEL_TEXTURE);
+    goldTexture = std::make_unique<Texture>(GOLD_TEXTURE);
+    grassTexture = std::make_unique<Texture>(GRASS_TEXTURE);
     //
-    boxAlbedoTexture = std::make_unique<Texture>("src/images/albedo2.png");
-    boxNormalTexture = std::make_unique<Texture>("src/images/normalmap.png");
+    boxAlbedoTexture = std::make_unique<Texture>(ALBEDO2_TEXTURE);
+    boxNormalTexture = std::make_unique<Texture>(NORMALMAP_TEXTURE);
     
     std::vector<std::string> skyboxFaces = {
         "src/images/skybox/right.png",
@@ -105,6 +140,12 @@ void ModelScene::init() {
     objTransform2->add(std::make_shared<TransformTranslation>(glm::vec3(8.0f, -1.0f, 4.0f)));
     objTransform2->add(std::make_shared<TransformScale>(glm::vec3(1.0f, 1.0f, 1.0f)));
     addObject(houseModel.get(), textureShader.get(), objTransform2, houseTexture.get(), Material::Plastic());
+    // the walls up to the eaves, shrunk a bit so the occluder never pokes out
+    const Aabb& houseBounds = houseModel->getBounds();
+    Aabb houseWalls;
+    houseWalls.expand(houseBounds.min + houseBounds.extent() * glm::vec3(0.15f, 0.0f, 0.15f));
+    houseWalls.expand(houseBounds.max - houseBounds.extent() * glm::vec3(0.15f, 1.0f, 0.15f));
+    occlusion.addOccluder(objects.size() - 1, OccluderMesh::Box(houseWalls));
     
     auto objTransform4 = std::make_shared<TransformComposite>();
     objTransform4->add(customWTransform);
@@ -137,6 +178,8 @@ void ModelScene::init() {
     };
 
     formulaBezierTrans = std::make_shared<TransformBezier>(bezierPoints, 0.0f);
+    formulaBezierTrans->setConstantSpeed(true);
+    followers.add(formulaBezierTrans, bezierAnimSpeed);
     auto formulaTransform = std::make_shared<TransformComposite>();
     formulaTransform->add(formulaBezierTrans);
     formulaTransform->add(customWTransform);
@@ -146,6 +189,23 @@ void ModelScene::init() {
     
     formulaObjIdx = objects.size();
     addObject(formulaModel.get(), modelShader2.get(), formulaTransform, nullptr, Material::Metal());
+
+    // everything except the normal mapped box fits the indirect path
+    if (IndirectRenderer::isSupported()) {
+        std::string indirectVertexSrc = loadShaderSrc(VERTEX_INDIRECT_SHADER);
+        std::string indirectFragmentSrc = loadShaderSrc(FRAG_INDIRECT_SHADER);
+        indirectShader = std::make_unique<Shader>(indirectVertexSrc.c_str(), indirectFragmentSrc.c_str());
+        indirectShader->addLight(lights[0].get());
+        lights[0]->attach(indirectShader.get());
+        indirectShader->updateAllLights();
+        if (indirect.build(objects.dense(), indirectShader.get()) && GLEW_VERSION_4_3) {
+            std::string cullSrc = loadShaderSrc(CULL_COMPUTE_SHADER);
+            std::string hizSrc = loadShaderSrc(HIZ_COMPUTE_SHADER);
+            cullShader = std::make_unique<Shader>(cullSrc.c_str());
+            hizShader = std::make_unique<Shader>(hizSrc.c_str());
+            indirect.enableGpuCulling(cullShader.get(), hizShader.get());
+        }
+    }
 }
 
 void ModelScene::drawSkybox() {
@@ -165,13 +225,26 @@ void ModelScene::drawSkybox() {
     glUseProgram(0);
 }
 
+void ModelScene::drawIndirect() {
+    if (attachedCamera) {
+        indirect.setViewProjection(attachedCamera->getProjMat() * attachedCamera->getViewMat());
+    }
+    indirect.update();
+    indirect.draw();
+
+    // leftovers (the normal mapped box) keep the per-object path
+    renderQueue.clear();
+    for (size_t i = 0; i < objects.size(); ++i) {
+        if (!indirect.covers(i)) renderQueue.submit(objects[i]);
+    }
+    renderQueue.sort();
+    renderQueue.execute();
+}
+
 void ModelScene::draw() {
     float time = static_cast<float>(glfwGetTime());
     
-    if (formulaBezierTrans) {
-        float t = fmod(time * bezierAnimSpeed, 1.0f);
-        formulaBezierTrans->setParam(t);
-    }
+    followers.update(time);
     
     textureShader->use();
     textureShader->SetUniform("useTexture", true);
@@ -187,8 +260,16 @@ void ModelScene::draw() {
     
     normalMapShader->use();
     normalMapShader->updateAllLights();
-    
-    drawImpl();
+
+    if (indirectMode) {
+        // the formula car is the only untextured object, its colour goes through the uniform
+        indirectShader->use();
+        indirectShader->SetUniform("objectColor", glm::vec3(r, g, b));
+        indirectShader->updateAllLights();
+        drawIndirect();
+    } else {
+        drawImpl();
+    }
     drawSkybox();
 }
 
@@ -198,6 +279,10 @@ void ModelScene::attachToCamera(Camera* camera) {
     if (camera && skyboxShader) {
         camera->attach(skyboxShader.get());
     }
+    if (camera && indirectShader) {
+        camera->attach(indirectShader.get());
+        camera->refreshObservers();
+    }
 }
 
 void ModelScene::detachFromCamera(Camera* camera) {
@@ -205,4 +290,12 @@ void ModelScene::detachFromCamera(Camera* camera) {
     if (camera && skyboxShader) {
         camera->detach(skyboxShader.get());
     }
+    if (camera && indirectShader) {
+        camera->detach(indirectShader.get());
+    }
+}
+
+void ModelScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
+    if (IndirectRenderer::isSupported()) assets.append(INDIRECT_ASSETS);
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "BaseScene.hpp"
 #include <vector>
 #include <memory>
+#include <iostream>
+#include "../renderers/IndirectRenderer.hpp"
 
 class ModelScene : public BaseScene {
 public:
@@ -9,6 +11,28 @@ public:
     void draw() override;
     void attachToCamera(Camera* camera) override;
     void detachFromCamera(Camera* camera) override;
+    void declareAssets(AssetManifest& assets) const override;
+
+    // render queue -> multi-draw indirect -> multi-draw indirect with GPU culling
+    void toggleIndirect() {
+        if (!indirect.isBuilt()) {
+            std::cout << "Indirect rendering unavailable" << std::endl;
+            return;
+        }
+        if (!indirectMode) {
+            indirectMode = true;
+            indirect.setGpuCulling(false);
+        } else if (!indirect.isGpuCulling() && indirect.hasGpuCulling()) {
+            indirect.setGpuCulling(true);
+        } else {
+            indirectMode = false;
+            indirect.setGpuCulling(false);
+        }
+        std::cout << "Model scene submission: "
+                  << (!indirectMode ? "render queue"
+                                    : indirect.isGpuCulling() ? "multi-draw indirect, GPU culled" : "multi-draw indirect")
+                  << std::endl;
+    }
 
 private:
     std::unique_ptr<Shader> modelShader;
@@ -18,6 +42,9 @@ private:
     std::unique_ptr<Shader> skyboxShader;
     std::unique_ptr<Shader> cubeShader;
     std::unique_ptr<Shader> normalMapShader;
+    std::unique_ptr<Shader> indirectShader;
+    std::unique_ptr<Shader> cullShader;
+    std::unique_ptr<Shader> hizShader;
     
     std::unique_ptr<Model> loginModel;
     std::unique_ptr<Model> houseModel;
@@ -39,8 +66,13 @@ private:
     std::vector<std::unique_ptr<Light>> lights;
 
     std::shared_ptr<TransformBezier> formulaBezierTrans;
+    BezierFollowers followers;
     int formulaObjIdx;
     float bezierAnimSpeed = 0.15f;
+
+    IndirectRenderer indirect;
+    bool indirectMode = false;
     //
     void drawSkybox();
+    void drawIndirect();
 };
\ No newline at end of file
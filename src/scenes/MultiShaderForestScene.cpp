@@ -1,20 +1,127 @@
 #include "MultiShaderForestScene.hpp"
+#include "../SceneSnapshot.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <ctime>
+#include <filesystem>
 #include <string>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+namespace {
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/vertex.glsl");
+const std::string VERTEX_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/vertex_textured.glsl");
+const std::string MULT_LAMBERT_SHADER = SCENE_ASSETS.shader("src/shaders/mult_lambert.glsl");
+const std::string MULT_PHONG_SHADER = SCENE_ASSETS.shader("src/shaders/mult_phong.glsl");
+const std::string MULT_BLINN_SHADER = SCENE_ASSETS.shader("src/shaders/mult_blinn.glsl");
+const std::string MULT_PHONG_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/mult_phong_textured.glsl");
+const std::string FRAG_TRIANGLE_SHADER = SCENE_ASSETS.shader("src/shaders/frag_triangle.glsl");
+const std::string IMPOSTOR_BAKE_VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/impostor_bake_vertex.glsl");
+const std::string IMPOSTOR_BAKE_FRAGMENT_SHADER = SCENE_ASSETS.shader("src/shaders/impostor_bake_fragment.glsl");
+const std::string IMPOSTOR_VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/impostor_vertex.glsl");
+const std::string IMPOSTOR_FRAGMENT_SHADER = SCENE_ASSETS.shader("src/shaders/impostor_fragment.glsl");
+const std::string VERTEX_SCATTER_SHADER = SCENE_ASSETS.shader("src/shaders/vertex_scatter.glsl");
+const std::string TERRAIN_VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/terrain_vertex.glsl");
+const std::string PARTICLES_UPDATE_SHADER = SCENE_ASSETS.shader("src/shaders/particles_update.glsl");
+const std::string PARTICLES_VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/particles_vertex.glsl");
+const std::string PARTICLES_FRAGMENT_SHADER = SCENE_ASSETS.shader("src/shaders/particles_fragment.glsl");
+const std::string SWAMP_TEXTURE = SCENE_ASSETS.texture("src/images/swamp.png");
+const std::string SHREK_TEXTURE = SCENE_ASSETS.texture("src/images/shrek.png");
+const std::string FIONA_TEXTURE = SCENE_ASSETS.texture("src/images/fiona.png");
+const std::string TOILET_TEXTURE = SCENE_ASSETS.texture("src/images/toiled.jpg");
+const std::string SHROOM_TEXTURE = SCENE_ASSETS.texture("src/images/hrib.jpg");
+const ModelFile SHREK_MODEL = SCENE_ASSETS.model("src/objects/shrek.obj", ModelType::UV);
+const ModelFile FIONA_MODEL = SCENE_ASSETS.model("src/objects/fiona.obj", ModelType::UV);
+const ModelFile TOILET_MODEL = SCENE_ASSETS.model("src/objects/toiled.obj", ModelType::UV);
+const ModelFile SHROOM_MODEL = SCENE_ASSETS.model("src/objects/mushromms.obj", ModelType::UV);
+
+// objectColor of the lambert, phong and blinn vegetation
+const glm::vec3 VEGETATION_COLORS[] = {
+    glm::vec3(0.05f, 0.25f, 0.05f),
+    glm::vec3(0.15f, 0.1f, 0.05f),
+    glm::vec3(0.02f, 0.2f, 0.35f)
+};
+// vegetation cells whose bounds are all farther than this become impostors
+const float IMPOSTOR_DISTANCE = 30.0f;
+const float VEGETATION_DISTANCE = 200.0f;
+const uint32_t VEGETATION_SEED = 1337;
+// the four lit ones included
+const size_t FIREFLY_COUNT = 20000;
+// the ground is a kilometre of heightmap, flat at -1 around the forest and
+// rising into hills past it
+const glm::vec2 TERRAIN_ORIGIN(-512.0f, -512.0f);
+const glm::vec2 TERRAIN_SIZE(1024.0f, 1024.0f);
+const int TERRAIN_SAMPLES = 513;
+const float TERRAIN_FLAT_RADIUS = 30.0f;
+const float TERRAIN_HILL_HEIGHT = 24.0f;
+
+// what the records of a forest snapshot stand for
+enum SnapshotTag : uint32_t {
+    SNAPSHOT_SHROOM = 1,
+    SNAPSHOT_SHREK_PATH = 2,
+    // blocks: the ground's heights, the vegetation instances and their cell ranges
+    SNAPSHOT_TERRAIN = 3,
+    SNAPSHOT_VEGETATION = 4,
+    SNAPSHOT_VEGETATION_CELLS = 5
+};
+
+uint32_t hashCell(int x, int z) {
+    uint32_t h = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(z) * 19349663u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+float valueNoise(float x, float z) {
+    int xi = static_cast<int>(std::floor(x));
+    int zi = static_cast<int>(std::floor(z));
+    float tx = x - xi;
+    float tz = z - zi;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+    auto corner = [](int cx, int cz) { return (hashCell(cx, cz) >> 8) * (1.0f / 16777216.0f); };
+    float top = corner(xi, zi) * (1.0f - tx) + corner(xi + 1, zi) * tx;
+    float bottom = corner(xi, zi + 1) * (1.0f - tx) + corner(xi + 1, zi + 1) * tx;
+    return top * (1.0f - tz) + bottom * tz;
+}
+
+float forestGround(float x, float z) {
+    float r = std::sqrt(x * x + z * z);
+    float ramp = std::clamp((r - TERRAIN_FLAT_RADIUS) / 60.0f, 0.0f, 1.0f);
+    ramp = ramp * ramp * (3.0f - 2.0f * ramp);
+    float hills = 0.0f;
+    float amplitude = 0.5f;
+    float frequency = 1.0f / 64.0f;
+    for (int octave = 0; octave < 5; ++octave) {
+        hills += amplitude * valueNoise(x * frequency, z * frequency);
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    return -1.0f + ramp * hills * TERRAIN_HILL_HEIGHT;
+}
+}
+
 void MultiShaderForestScene::init() {
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
 
-    std::string vertexSrc = loadShaderSrc("src/shaders/vertex.glsl");
-    std::string vertexTexturedSrc = loadShaderSrc("src/shaders/vertex_textured.glsl");
-    std::string fragLambertSrc = loadShaderSrc("src/shaders/mult_lambert.glsl");
-    std::string fragPhongSrc = loadShaderSrc("src/shaders/mult_phong.glsl");
-    std::string fragBlinnSrc = loadShaderSrc("src/shaders/mult_blinn.glsl");
-    std::string fragPhongTexturedSrc = loadShaderSrc("src/shaders/mult_phong_textured.glsl");
-    std::string fragTriangleSrc = loadShaderSrc("src/shaders/frag_triangle.glsl");
+    // a snapshot saved with F5 stands in for the generated ground and
+    // vegetation, and brings the user's edits back at the end
+    std::unique_ptr<SceneSnapshot> snapshot;
+    std::error_code error;
+    if (std::filesystem::exists(SNAPSHOT_PATH, error)) snapshot = SceneSnapshot::Open(SNAPSHOT_PATH);
+
+    std::string vertexSrc = loadShaderSrc(VERTEX_SHADER);
+    std::string vertexTexturedSrc = loadShaderSrc(VERTEX_TEXTURED_SHADER);
+    std::string fragLambertSrc = loadShaderSrc(MULT_LAMBERT_SHADER);
+    std::string fragPhongSrc = loadShaderSrc(MULT_PHONG_SHADER);
+    std::string fragBlinnSrc = loadShaderSrc(MULT_BLINN_SHADER);
+    std::string fragPhongTexturedSrc = loadShaderSrc(MULT_PHONG_TEXTURED_SHADER);
+    std::string fragTriangleSrc = loadShaderSrc(FRAG_TRIANGLE_SHADER);
 
     lambertShader = std::make_unique<Shader>(vertexSrc.c_str(), fragLambertSrc.c_str());
     phongShader = std::make_unique<Shader>(vertexSrc.c_str(), fragPhongSrc.c_str());
@@ -24,18 +131,16 @@ void MultiShaderForestScene::init() {
 
     bushModel = ModelFactory::CreateBush();
     treeModel = ModelFactory::CreateTree();
-    plainModel = ModelFactory::CreatePlain();
-    sphereModel = ModelFactory::CreatePlainSphere();
-    shrekModel = ModelFactory::CreateShrek();
-    fionaModel = ModelFactory::CreateFiona();
-    toiletModel = ModelFactory::CreateToilet();
-    shroomModel = ModelFactory::CreateShroom();
-    
-    grassTexture = std::make_unique<Texture>("src/images/swamp.png");
-    shrekTexture = std::make_unique<Texture>("src/images/shrek.png");
-    fionaTexture = std::make_unique<Texture>("src/images/fiona.png");
-    toiletTexture = std::make_unique<Texture>("src/images/toiled.jpg");
-    shroomTexture = std::make_unique<Texture>("src/images/hrib.jpg");
+    shrekModel = Model::LoadFromFile(SHREK_MODEL);
+    fionaModel = Model::LoadFromFile(FIONA_MODEL);
+    toiletModel = Model::LoadFromFile(TOILET_MODEL);
+    shroomModel = Model::LoadFromFile(SHROOM_MODEL);
+    
+    grassTexture = std::make_unique<Texture>(SWAMP_TEXTURE);
+    shrekTexture = std::make_unique<Texture>(SHREK_TEXTURE);
+    fionaTexture = std::make_unique<Texture>(FIONA_TEXTURE);
+    toiletTexture = std::make_unique<Texture>(TOILET_TEXTURE);
+    shroomTexture = std::make_unique<Texture>(SHROOM_TEXTURE);
 
     auto light1 = std::make_unique<Light>(
         glm::vec3(5.0f, 3.0f, 5.0f),
@@ -161,10 +266,67 @@ void MultiShaderForestScene::init() {
     blinnShader->updateAllLights();
     phongTexturedShader->updateAllLights();
 
-    auto plainTransform = std::make_shared<TransformComposite>();
-    plainTransform->add(std::make_shared<TransformTranslation>(glm::vec3(0.0f, -1.0f, 0.0f)));
-    plainTransform->add(std::make_shared<TransformScale>(glm::vec3(20.0f, 1.0f, 20.0f)));
-    addObject(plainModel.get(), phongTexturedShader.get(), plainTransform, grassTexture.get());
+    // far vegetation is drawn from octahedral views of the meshes, baked here once
+    std::string impostorBakeVertexSrc = loadShaderSrc(IMPOSTOR_BAKE_VERTEX_SHADER);
+    std::string impostorBakeFragmentSrc = loadShaderSrc(IMPOSTOR_BAKE_FRAGMENT_SHADER);
+    std::string impostorVertexSrc = loadShaderSrc(IMPOSTOR_VERTEX_SHADER);
+    std::string impostorFragmentSrc = loadShaderSrc(IMPOSTOR_FRAGMENT_SHADER);
+    impostorBakeShader = std::make_unique<Shader>(impostorBakeVertexSrc.c_str(), impostorBakeFragmentSrc.c_str());
+
+    std::vector<Light*> forestLights;
+    for (auto& light : lights) forestLights.push_back(light.get());
+    forestLights.push_back(directionalLight.get());
+    forestLights.push_back(flashlight.get());
+
+    // vegetation uses the same lighting, fed from instance data with wind on top
+    std::string vertexScatterSrc = loadShaderSrc(VERTEX_SCATTER_SHADER);
+    const std::string* scatterFragments[] = {&fragLambertSrc, &fragPhongSrc, &fragBlinnSrc};
+    for (const std::string* fragSrc : scatterFragments) {
+        scatterShaders.push_back(std::make_unique<Shader>(vertexScatterSrc.c_str(), fragSrc->c_str()));
+    }
+    scatterShaders.push_back(std::make_unique<Shader>(impostorVertexSrc.c_str(), impostorFragmentSrc.c_str()));
+    for (auto& shader : scatterShaders) {
+        for (Light* light : forestLights) {
+            shader->addLight(light);
+            light->attach(shader.get());
+        }
+        shader->use();
+        shader->SetUniform("shininess", 32.0f);
+        shader->updateAllLights();
+    }
+    impostorShader = scatterShaders.back().get();
+    glUseProgram(0);
+
+    // the ground uses the same lighting with heights and normals from textures
+    std::string terrainVertexSrc = loadShaderSrc(TERRAIN_VERTEX_SHADER);
+    terrainShader = std::make_unique<Shader>(terrainVertexSrc.c_str(), fragPhongTexturedSrc.c_str());
+    for (Light* light : forestLights) {
+        terrainShader->addLight(light);
+        light->attach(terrainShader.get());
+    }
+    terrainShader->use();
+    terrainShader->SetUniform("objectColor", glm::vec3(1.0f));
+    terrainShader->SetUniform("shininess", 32.0f);
+    terrainShader->updateAllLights();
+    glUseProgram(0);
+    const size_t terrainSamples = static_cast<size_t>(TERRAIN_SAMPLES) * TERRAIN_SAMPLES;
+    size_t heightBytes = 0;
+    const void* savedHeights = snapshot ? snapshot->block(SNAPSHOT_TERRAIN, heightBytes) : nullptr;
+    Heightmap heightmap;
+    if (savedHeights && heightBytes == terrainSamples * sizeof(float)) {
+        const float* heights = static_cast<const float*>(savedHeights);
+        heightmap = Heightmap(TERRAIN_SAMPLES, TERRAIN_SAMPLES, TERRAIN_ORIGIN, TERRAIN_SIZE,
+                              std::vector<float>(heights, heights + terrainSamples));
+    } else {
+        heightmap = Heightmap::FromFunction(TERRAIN_SAMPLES, TERRAIN_SAMPLES, TERRAIN_ORIGIN, TERRAIN_SIZE,
+                                            forestGround, workers);
+    }
+    terrain = std::make_unique<Terrain>(std::move(heightmap), Terrain::Settings());
+    // the grass repeats every 10 units
+    terrain->setSurface(grassTexture.get(), 0.1f);
+
+    // never moves after init, merged into static chunks at the end
+    std::vector<ObjectHandle> staticObjects;
 
     // FIREFLIES INIT HERE
     for (int i = 0; i < lights.size(); ++i) {
@@ -188,55 +350,105 @@ void MultiShaderForestScene::init() {
                 break;
         }
         
-        auto rotation = std::make_shared<TransformRotation>(0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-        fireflyRotations.push_back(rotation);
-        
-        auto sphereTransform = std::make_shared<TransformComposite>();
-        sphereTransform->add(rotation);
-        sphereTransform->add(std::make_shared<TransformTranslation>(glm::vec3(radius, height, 0.0f)));
-        sphereTransform->add(std::make_shared<TransformScale>(glm::vec3(0.1f)));
-        
-        lightSpheres.push_back({lights[i].get(), objects.size()});
-        addObject(sphereModel.get(), phongShader.get(), sphereTransform);
+        fireflyLights.push_back({lights[i].get(), radius, height});
     }
-    // NO LONGER FIREFLIES INIT
 
-    Shader* lightingShaders[] = {
-        lambertShader.get(),
-        phongShader.get(),
-        blinnShader.get()
-    };
-    int numShaders = 3;
-
-    for (int i = 0; i < 50; ++i) {
-        auto bushTransform = std::make_shared<TransformComposite>();
-        float x = ((rand() % 400) / 10.0f) - 20.0f;
-        float z = ((rand() % 400) / 10.0f) - 20.0f;
-        bushTransform->add(std::make_shared<TransformTranslation>(glm::vec3(x, -1.0f, z)));
-        bushTransform->add(std::make_shared<TransformRotation>(
-            static_cast<float>(rand() % 360), glm::vec3(0.0f, 1.0f, 0.0f)
-        ));
-        float scale = 0.3f + ((rand() % 50) / 100.0f);
-        bushTransform->add(std::make_shared<TransformScale>(glm::vec3(scale, scale, scale)));
-        
-        Shader* selectedShader = lightingShaders[rand() % numShaders];
-        addObject(bushModel.get(), selectedShader, bushTransform);
-    }
-
-    for (int i = 0; i < 50; ++i) {
-        auto treeTransform = std::make_shared<TransformComposite>();
-        float x = ((rand() % 400) / 10.0f) - 20.0f;
-        float z = ((rand() % 400) / 10.0f) - 20.0f;
-        treeTransform->add(std::make_shared<TransformTranslation>(glm::vec3(x, -1.0f, z)));
-        treeTransform->add(std::make_shared<TransformRotation>(
-            static_cast<float>(rand() % 360), glm::vec3(0.0f, 1.0f, 0.0f)
-        ));
-        float scale = 0.5f + ((rand() % 70) / 100.0f);
-        treeTransform->add(std::make_shared<TransformScale>(glm::vec3(scale, scale, scale)));
-        
-        Shader* selectedShader = lightingShaders[rand() % numShaders];
-        addObject(treeModel.get(), selectedShader, treeTransform);
+    // the lit fireflies turn at the same rate draw() moves their lights, the
+    // rest of the swarm drifts on slower orbits of its own
+    std::string particleUpdateSrc = loadShaderSrc(PARTICLES_UPDATE_SHADER);
+    std::string particleVertexSrc = loadShaderSrc(PARTICLES_VERTEX_SHADER);
+    std::string particleFragmentSrc = loadShaderSrc(PARTICLES_FRAGMENT_SHADER);
+    particleUpdateShader = std::make_unique<Shader>(particleUpdateSrc.c_str(), ParticleSystem::FEEDBACK_VARYINGS);
+    particleShader = std::make_unique<Shader>(particleVertexSrc.c_str(), particleFragmentSrc.c_str());
+
+    ParticleSystem::Settings fireflySettings;
+    fireflySettings.motion = ParticleSystem::Motion::ORBIT;
+    fireflySettings.capacity = FIREFLY_COUNT;
+    fireflySettings.color = glm::vec3(1.0f, 0.9f, 0.3f);
+    fireflySettings.size = 0.06f;
+    fireflies = std::make_unique<ParticleSystem>(fireflySettings);
+
+    std::vector<ParticleSystem::Particle> swarm;
+    swarm.reserve(FIREFLY_COUNT);
+    for (int i = 0; i < fireflyLights.size(); ++i) {
+        float speed = glm::radians((0.1f + i) * 50.0f);
+        swarm.push_back(ParticleSystem::Orbiter(0.0f, speed, fireflyLights[i].radius, fireflyLights[i].height,
+                                                0.0f, 0.0f, 3.0f));
+    }
+    while (swarm.size() < FIREFLY_COUNT) {
+        float phase = glm::radians(static_cast<float>(rand() % 360));
+        float speed = glm::radians(((rand() % 200) / 10.0f - 10.0f));
+        float radius = 3.0f + (rand() % 2200) / 100.0f;
+        float height = -0.5f + (rand() % 450) / 100.0f;
+        float seed = (rand() % 1000) / 1000.0f;
+        float size = 0.6f + (rand() % 80) / 100.0f;
+        swarm.push_back(ParticleSystem::Orbiter(phase, speed, radius, height, 1.0f, seed, size));
     }
+    fireflies->emit(swarm.data(), swarm.size());
+
+    // the ground is 40x40 around the origin; the clearing in the middle keeps
+    // the path, Fiona and the toilet free
+    glm::vec2 fieldOrigin(-20.0f, -20.0f);
+    glm::vec2 fieldSize(40.0f, 40.0f);
+    vegetation = std::make_unique<ScatterField>(fieldOrigin, fieldSize, 8.0f, VEGETATION_SEED);
+    vegetation->setWorkers(workers);
+    const Heightmap& ground = terrain->getHeightmap();
+    vegetation->setHeightFunction([&ground](float x, float z) { return ground.heightAt(x, z); });
+    DensityMap forestDensity = DensityMap::FromFunction(64, 64, fieldOrigin, fieldSize, [](float x, float z) {
+        float d = std::sqrt(x * x + z * z);
+        return std::clamp((d - 3.0f) / 6.0f, 0.0f, 1.0f);
+    });
+
+    auto bushAtlas = std::make_unique<ImpostorAtlas>();
+    auto treeAtlas = std::make_unique<ImpostorAtlas>();
+    bushAtlas->bake(bushModel.get(), impostorBakeShader.get());
+    treeAtlas->bake(treeModel.get(), impostorBakeShader.get());
+    int bushImpostor = vegetation->addImpostor(std::move(bushAtlas));
+    int treeImpostor = vegetation->addImpostor(std::move(treeAtlas));
+
+    // trees hide what stands behind them, a slim box around the trunk and the
+    // bottom of the crown stays inside the mesh from every side
+    const Aabb& treeBounds = treeModel->getBounds();
+    glm::vec3 treeCenter = treeBounds.center();
+    glm::vec3 treeExtent = treeBounds.extent();
+    Aabb treeCore;
+    treeCore.expand(glm::vec3(treeCenter.x - treeExtent.x * 0.2f, treeBounds.min.y, treeCenter.z - treeExtent.z * 0.2f));
+    treeCore.expand(glm::vec3(treeCenter.x + treeExtent.x * 0.2f, treeBounds.min.y + treeExtent.y * 1.4f,
+                              treeCenter.z + treeExtent.z * 0.2f));
+
+    // every model in each of the three lightings, like the hand placed forest had
+    for (int i = 0; i < 3; ++i) {
+        ScatterRule bushes;
+        bushes.model = bushModel.get();
+        bushes.shader = scatterShaders[i].get();
+        bushes.color = VEGETATION_COLORS[i];
+        bushes.density = 0.04f;
+        bushes.minScale = 0.3f;
+        bushes.maxScale = 0.8f;
+        bushes.densityMap = forestDensity;
+        bushes.impostor = bushImpostor;
+        vegetation->addRule(bushes);
+
+        ScatterRule trees = bushes;
+        trees.model = treeModel.get();
+        trees.density = 0.02f;
+        trees.minScale = 0.5f;
+        trees.maxScale = 1.2f;
+        trees.impostor = treeImpostor;
+        trees.occluder = OccluderMesh::Box(treeCore);
+        vegetation->addRule(trees);
+    }
+    size_t placedBytes = 0;
+    size_t rangeBytes = 0;
+    const void* placed = snapshot ? snapshot->block(SNAPSHOT_VEGETATION, placedBytes) : nullptr;
+    const void* ranges = snapshot ? snapshot->block(SNAPSHOT_VEGETATION_CELLS, rangeBytes) : nullptr;
+    if (!placed || !ranges ||
+        !vegetation->build(static_cast<const ScatterField::Instance*>(placed),
+                           placedBytes / sizeof(ScatterField::Instance), static_cast<const uint32_t*>(ranges),
+                           rangeBytes / sizeof(uint32_t))) {
+        vegetation->build();
+    }
+    vegetation->addOccluders(occlusion);
 
     std::vector<glm::vec3> bezierPoints = {
         glm::vec3(-3.0f, -1.0f, -2.0f),
@@ -246,18 +458,27 @@ void MultiShaderForestScene::init() {
     };
 
     shrekBezierTrans = std::make_shared<TransformBezier>(bezierPoints, 0.0f);
+    shrekBezierTrans->setConstantSpeed(true);
+    followers.add(shrekBezierTrans, bezierAnimSpeed);
     auto shrekTransform = std::make_shared<TransformComposite>();
     shrekTransform->add(shrekBezierTrans);
-    shrekObjectIndex = objects.size();
-    addObject(shrekModel.get(), phongTexturedShader.get(), shrekTransform, shrekTexture.get(), Material::Shrek());
+    shrekObject = addObject(shrekModel.get(), phongTexturedShader.get(), shrekTransform, shrekTexture.get(),
+                            Material::Shrek());
 
     auto fionaTransform = std::make_shared<TransformComposite>();
     fionaTransform->add(std::make_shared<TransformTranslation>(glm::vec3(0.0f, -1.0f, 0.0f)));
     auto toiletTransform = std::make_shared<TransformComposite>();
     toiletTransform->add(std::make_shared<TransformTranslation>(glm::vec3(-3.0f, -1.0f, -3.0f)));
-    addObject(fionaModel.get(), phongTexturedShader.get(), fionaTransform, fionaTexture.get(), Material::Fiona());
-    addObject(toiletModel.get(), phongTexturedShader.get(), toiletTransform, toiletTexture.get());
-    
+    staticObjects.push_back(addObject(fionaModel.get(), phongTexturedShader.get(), fionaTransform, fionaTexture.get(),
+                                      Material::Fiona()));
+    staticObjects.push_back(addObject(toiletModel.get(), phongTexturedShader.get(), toiletTransform,
+                                      toiletTexture.get()));
+
+    // shrek, the fireflies and the shrooms stay dynamic
+    batchStatic(staticObjects, 20.0f);
+
+    if (snapshot) applySnapshot(*snapshot);
+
     std::cout << "Initial mode is CREATION (Press M to switch modes)!" << std::endl;
 }
 
@@ -266,6 +487,19 @@ int MultiShaderForestScene::getShroomAtCursor(double xpos, double ypos, int W, i
     int y = H - static_cast<int>(ypos);
     
     if (x < 0 || x >= W || y < 0 || y >= H) return -1;
+
+    // the readback stalls the pipeline, skip it unless the cursor ray
+    // passes through some shroom's bounds
+    glm::vec3 origin, dir;
+    mouseRay(xpos, ypos, W, H, origin, dir);
+    bvh.queryRay(origin, dir, FAR_PLANE, rayHits);
+    bool nearShroom = false;
+    for (uint32_t hit : rayHits) {
+        for (const auto& shroom : shroomObjects) {
+            if (indexOf(shroom.object) == hit) nearShroom = true;
+        }
+    }
+    if (!nearShroom) return -1;
     
     GLubyte stencilValue;
     glReadPixels(x, y, 1, 1, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, &stencilValue);
@@ -285,44 +519,46 @@ void MultiShaderForestScene::addShroomAtPos(const glm::vec3& worldPos) {
     shroomTransform->add(std::make_shared<TransformTranslation>(glm::vec3(2.0f, 0.0f, 0.0f)));
     shroomTransform->add(std::make_shared<TransformTranslation>(worldPos));
     shroomTransform->add(std::make_shared<TransformScale>(glm::vec3(0.05f)));
-    
-    int objIndex = objects.size();
-    addObject(shroomModel.get(), phongTexturedShader.get(), shroomTransform, shroomTexture.get());
-    shroomObjects.push_back({objIndex, worldPos});
+    addShroom(shroomTransform, worldPos);
     
     std::cout << "Added shroom at (" << worldPos.x << ", " << worldPos.y << ", " << worldPos.z << ")" << std::endl;
 }
 
+void MultiShaderForestScene::addShroom(std::shared_ptr<Transform> transform, const glm::vec3& worldPos,
+                                       const Material& material) {
+    ObjectHandle shroom = addObject(shroomModel.get(), phongTexturedShader.get(), transform, shroomTexture.get(),
+                                    material);
+    setLayers(shroom, RenderLayer::PICKABLE);
+    getObject(shroom)->pickId = static_cast<uint8_t>(shroomObjects.size() + 1);
+    shroomObjects.push_back({shroom, worldPos});
+}
+
+void MultiShaderForestScene::clearShrooms() {
+    setHoveredShroom(-1);
+    for (const auto& shroom : shroomObjects) removeObject(shroom.object);
+    shroomObjects.clear();
+}
+
 void MultiShaderForestScene::deleteShroomAtCursor(double xpos, double ypos, int W, int H) {
     int shroomIndex = getShroomAtCursor(xpos, ypos, W, H);
     if (shroomIndex < 0) return;
-    int objIndex = shroomObjects[shroomIndex].objectIndex;
-
-    if (objIndex < objects.size()) {
-        objects.erase(objects.begin() + objIndex);
-        for (int i = 0; i < shroomObjects.size(); ++i) {
-            if (shroomObjects[i].objectIndex > objIndex) {
-                shroomObjects[i].objectIndex--;
-            }
-        }
-        
-        for (auto& ls : lightSpheres) {
-            if (ls.objectIndex > objIndex) {
-                ls.objectIndex--;
-            }
-        }
-        
-        if (shrekObjectIndex > objIndex) {
-            shrekObjectIndex--;
-        }
+    setHoveredShroom(-1);
+    removeObject(shroomObjects[shroomIndex].object);
+    shroomObjects[shroomIndex] = shroomObjects.back();
+    shroomObjects.pop_back();
+    // the moved shroom takes over the stencil ID of its new place
+    if (shroomIndex < static_cast<int>(shroomObjects.size())) {
+        getObject(shroomObjects[shroomIndex].object)->pickId = static_cast<uint8_t>(shroomIndex + 1);
     }
-    
-    shroomObjects.erase(shroomObjects.begin() + shroomIndex);
     std::cout << "Deleted shroom" << std::endl;
 }
 
-glm::vec3 MultiShaderForestScene::mouseToWorld(double xpos, double ypos, int W, int H) {
-    if (!attachedCamera) return glm::vec3(0.0f);
+void MultiShaderForestScene::mouseRay(double xpos, double ypos, int W, int H, glm::vec3& origin, glm::vec3& dir) {
+    if (!attachedCamera) {
+        origin = glm::vec3(0.0f);
+        dir = glm::vec3(0.0f, 0.0f, -1.0f);
+        return;
+    }
     float winX = static_cast<float>(xpos);
     float winY = static_cast<float>(H - ypos);
     glm::vec4 viewport(0, 0, W, H);
@@ -330,8 +566,18 @@ glm::vec3 MultiShaderForestScene::mouseToWorld(double xpos, double ypos, int W,
     glm::mat4 proj = attachedCamera->getProjMat();
     glm::vec3 nearP = glm::unProject({winX, winY, 0.0f}, view, proj, viewport);
     glm::vec3 farP  = glm::unProject({winX, winY, 1.0f}, view, proj, viewport);
-    
-    glm::vec3 dir = glm::normalize(farP - nearP);
+
+    origin = nearP;
+    dir = glm::normalize(farP - nearP);
+}
+
+glm::vec3 MultiShaderForestScene::mouseToWorld(double xpos, double ypos, int W, int H) {
+    if (!attachedCamera) return glm::vec3(0.0f);
+    glm::vec3 nearP, dir;
+    mouseRay(xpos, ypos, W, H, nearP, dir);
+    glm::vec3 hit;
+    if (terrain && terrain->getHeightmap().raycast(nearP, dir, FAR_PLANE, hit)) return hit;
+    // off the terrain, fall back to the forest floor's plane
     float t = (-1.0f - nearP.y) / dir.y;
 
     return nearP + dir * t;
@@ -356,16 +602,21 @@ void MultiShaderForestScene::handleMouseClick(double xpos, double ypos, int widt
 }
 
 void MultiShaderForestScene::updateMouseHover(double xpos, double ypos, int width, int height) {
-    hoveredShroomIndex = getShroomAtCursor(xpos, ypos, width, height);
+    setHoveredShroom(getShroomAtCursor(xpos, ypos, width, height));
 }
 
-void MultiShaderForestScene::drawShroomsWStencil() {
-    if (hoveredShroomIndex < 0 || hoveredShroomIndex >= static_cast<int>(shroomObjects.size())) {
-        return;
+void MultiShaderForestScene::setHoveredShroom(int shroomIndex) {
+    if (shroomIndex == hoveredShroomIndex) return;
+    if (hoveredShroomIndex >= 0 && hoveredShroomIndex < static_cast<int>(shroomObjects.size())) {
+        setLayers(shroomObjects[hoveredShroomIndex].object, RenderLayer::PICKABLE);
     }
-    
-    int objIndex = shroomObjects[hoveredShroomIndex].objectIndex;
-    auto& obj = objects[objIndex];
+    hoveredShroomIndex = shroomIndex;
+    if (hoveredShroomIndex >= 0) {
+        setLayers(shroomObjects[hoveredShroomIndex].object, RenderLayer::PICKABLE | RenderLayer::OUTLINED);
+    }
+}
+
+void MultiShaderForestScene::drawShroom(const DrawableObject& obj) {
     obj.shader->use();
     if (obj.texture) {
         obj.texture->bind(0);
@@ -378,27 +629,27 @@ void MultiShaderForestScene::drawShroomsWStencil() {
     if (obj.texture) {
         obj.texture->unbind();
     }
-    
+}
+
+void MultiShaderForestScene::drawShroomsWStencil() {
+    for (uint32_t idx : layerMembers(RenderLayer::OUTLINED)) {
+        if (isVisible(idx)) drawShroom(objects[idx]);
+    }
     glUseProgram(0);
 }
 
 void MultiShaderForestScene::draw() {
     float time = static_cast<float>(glfwGetTime());
-    if (shrekBezierTrans) {
-        float t = fmod(time * bezierAnimSpeed, 1.0f);
-        shrekBezierTrans->setParam(t);
-    }
+    followers.update(time);
     
-    for (int i = 0; i < fireflyRotations.size(); ++i) {
+    for (int i = 0; i < fireflyLights.size(); ++i) {
         float speed = 0.1f + i; 
-        float angle = time * speed * 50.0f;
+        float angle = glm::radians(time * speed * 50.0f);
         
-        fireflyRotations[i]->setAngle(angle);
-        
-        glm::mat4 transform = objects[lightSpheres[i].objectIndex].transform->getMatrix();
-        glm::vec3 pos = glm::vec3(transform[3]);
-        lights[i]->setPosition(pos);
+        const auto& fl = fireflyLights[i];
+        fl.light->setPosition(glm::vec3(fl.radius * cos(angle), fl.height, -fl.radius * sin(angle)));
     }
+    cullObjects();
     
     if (attachedCamera) {
         flashlight->setPosition(attachedCamera->getPosition());
@@ -414,16 +665,16 @@ void MultiShaderForestScene::draw() {
     }
     
     lambertShader->use();
-    lambertShader->SetUniform("objectColor", glm::vec3(0.05f, 0.25f, 0.05));
+    lambertShader->SetUniform("objectColor", VEGETATION_COLORS[0]);
     lambertShader->updateAllLights();
     
     phongShader->use();
-    phongShader->SetUniform("objectColor", glm::vec3(0.15f, 0.1f, 0.05f));
+    phongShader->SetUniform("objectColor", VEGETATION_COLORS[1]);
     phongShader->SetUniform("shininess", 32.0f);
     phongShader->updateAllLights();
     
     blinnShader->use();
-    blinnShader->SetUniform("objectColor", glm::vec3(0.02f, 0.2f, 0.35f));
+    blinnShader->SetUniform("objectColor", VEGETATION_COLORS[2]);
     blinnShader->SetUniform("shininess", 32.0f);
     blinnShader->updateAllLights();
     
@@ -435,95 +686,47 @@ void MultiShaderForestScene::draw() {
     
     glUseProgram(0);
     
-    glEnable(GL_STENCIL_TEST);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    glStencilFunc(GL_ALWAYS, 0, 0xFF);
-    glStencilMask(0xFF);
-    
-    // non-shroom objects stencil value 0
-    for (int i = 0; i < objects.size(); ++i) {
-        bool isLightSphere = false;
-        for (int j = 0; j < lightSpheres.size(); ++j) {
-            if (i == lightSpheres[j].objectIndex) {
-                isLightSphere = true;
-                break;
-            }
-        }
-        
-        bool isShroom = false;
-        for (int j = 0; j < shroomObjects.size(); ++j) {
-            if (i == shroomObjects[j].objectIndex) {
-                isShroom = true;
-                break;
-            }
-        }
-        
-        bool isHoveredShroom = false;
-        if (hoveredShroomIndex >= 0 && hoveredShroomIndex < static_cast<int>(shroomObjects.size())) {
-            if (i == shroomObjects[hoveredShroomIndex].objectIndex) {
-                isHoveredShroom = true;
-            }
-        }
-        
-        if (!isLightSphere && !isShroom && !isHoveredShroom) {
-            auto& obj = objects[i];
-            obj.shader->use();
-            
-            if (obj.texture) {
-                obj.texture->bind(0);
-                obj.shader->SetUniform("textureSampler", 0);
-            }
-            
-            glm::mat4 model = obj.transform->getMatrix();
-            obj.shader->SetUniform("model", model);
-            obj.model->draw(GL_TRIANGLES);
-            
-            if (obj.texture) {
-                obj.texture->unbind();
-            }
+    // shrooms are on their own layers, fireflies are particles
+    glm::vec3 viewPos = attachedCamera ? attachedCamera->getPosition() : glm::vec3(0.0f);
+    renderQueue.clear();
+    renderQueue.submit(objects.dense(), layerMembers(RenderLayer::OPAQUE), viewPos, 0, &visibility);
+    renderQueue.sort();
+    executeOpaque();
+
+    if (attachedCamera) {
+        glm::mat4 view = attachedCamera->getViewMat();
+        glm::mat4 projection = attachedCamera->getProjMat();
+        terrainShader->use();
+        terrainShader->updateAllLights();
+        terrain->draw(*terrainShader, view, projection, viewPos);
+
+        // cullObjects() has rendered the occluders for this frame already
+        vegetation->cull(projection * view, viewPos, IMPOSTOR_DISTANCE, VEGETATION_DISTANCE,
+                         cullingEnabled ? &occlusion : nullptr);
+        for (auto& shader : scatterShaders) {
+            shader->use();
+            shader->updateAllLights();
         }
+        vegetation->draw(view, projection, viewPos, time);
+        vegetation->drawImpostors(*impostorShader, view, projection, viewPos);
     }
     
-    for (int i = 0; i < shroomObjects.size(); i++) {
-        if (hoveredShroomIndex >= 0 && i == hoveredShroomIndex) continue;
-        
-        glStencilFunc(GL_ALWAYS, i + 1, 0xFF);
-        
-        auto& obj = objects[shroomObjects[i].objectIndex];
-        obj.shader->use();
-        
-        if (obj.texture) {
-            obj.texture->bind(0);
-            obj.shader->SetUniform("textureSampler", 0);
-        }
-        
-        glm::mat4 model = obj.transform->getMatrix();
-        obj.shader->SetUniform("model", model);
-        obj.model->draw(GL_TRIANGLES);
-        
-        if (obj.texture) {
-            obj.texture->unbind();
-        }
+    for (uint32_t idx : layerMembers(RenderLayer::PICKABLE)) {
+        if ((objects[idx].layers & RenderLayer::OUTLINED) || !isVisible(idx)) continue;
+        drawShroom(objects[idx]);
     }
     
-    glStencilMask(0x00);
-    glDisable(GL_STENCIL_TEST);
-    
     drawShroomsWStencil();
     
     // FIREFLIES HERE
-    phongShader->use();
-    phongShader->SetUniform("objectColor", glm::vec3(2.0f, 2.0f, 0.0f));
-    phongShader->SetUniform("shininess", 128.0f);
-    for (int i = 0; i < lightSpheres.size(); ++i) {
-        auto& obj = objects[lightSpheres[i].objectIndex];
-        glm::mat4 model = obj.transform->getMatrix();
-        phongShader->SetUniform("isFirefly", true);
-        phongShader->SetUniform("model", model);
-        obj.model->draw(GL_TRIANGLES);
-        phongShader->SetUniform("isFirefly", false);
+    fireflies->update(*particleUpdateShader, time, time - lastFrameTime);
+    lastFrameTime = time;
+    if (attachedCamera) {
+        fireflies->draw(*particleShader, attachedCamera->getViewMat(), attachedCamera->getProjMat(),
+                        static_cast<float>(attachedCamera->getResolution().y), time);
     }
-    glUseProgram(0);
+
+    writeStencilIds();
 }
 
 void MultiShaderForestScene::attachToCamera(Camera* camera) {
@@ -534,6 +737,10 @@ void MultiShaderForestScene::detachFromCamera(Camera* camera) {
     detachFromCameraImpl(camera);
 }
 
+void MultiShaderForestScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
+}
+
 void MultiShaderForestScene::addBezierPoint(const glm::vec3& worldPos) {
     bezierControlPoints.push_back(worldPos);
     std::cout << "Added Bezier point #" << bezierControlPoints.size() 
@@ -551,10 +758,77 @@ void MultiShaderForestScene::updateBezierPath() {
         return;
     }
 
-    shrekBezierTrans = std::make_shared<TransformBezier>(bezierControlPoints, 0.0f);
-    auto shrekTransform = std::make_shared<TransformComposite>();
-    shrekTransform->add(shrekBezierTrans);
-    objects[shrekObjectIndex].transform = shrekTransform;
+    // the object's composite already holds this curve, only the points change
+    shrekBezierTrans->setControlPoints(bezierControlPoints);
     
     std::cout << "Bezier path updated with pts..." << std::endl;
-}
\ No newline at end of file
+}
+
+bool MultiShaderForestScene::saveSnapshot(const std::string& path) {
+    SceneSnapshotWriter writer;
+    for (const auto& shroom : shroomObjects) {
+        const DrawableObject* obj = getObject(shroom.object);
+        if (!obj) continue;
+        writer.addObject(SNAPSHOT_SHROOM, SHROOM_MODEL.first, SHROOM_TEXTURE, obj->transform->getMatrix(),
+                         obj->material, RenderLayer::PICKABLE, obj->pickId);
+    }
+    for (const auto& light : lights) writer.addLight(*light);
+    writer.addLight(*directionalLight);
+    writer.addLight(*flashlight);
+    writer.addPath(SNAPSHOT_SHREK_PATH, shrekBezierTrans->getControlPoints());
+
+    const std::vector<float>& heights = terrain->getHeightmap().getHeights();
+    writer.addBlock(SNAPSHOT_TERRAIN, heights.data(), heights.size() * sizeof(float));
+    const std::vector<ScatterField::Instance>& placed = vegetation->getInstances();
+    writer.addBlock(SNAPSHOT_VEGETATION, placed.data(), placed.size() * sizeof(ScatterField::Instance));
+    std::vector<uint32_t> ranges = vegetation->getCellRanges();
+    writer.addBlock(SNAPSHOT_VEGETATION_CELLS, ranges.data(), ranges.size() * sizeof(uint32_t));
+
+    if (!writer.write(path)) return false;
+    std::cout << "Saved forest snapshot with " << shroomObjects.size() << " shrooms to " << path << std::endl;
+    return true;
+}
+
+bool MultiShaderForestScene::loadSnapshot(const std::string& path) {
+    std::unique_ptr<SceneSnapshot> snapshot = SceneSnapshot::Open(path);
+    if (!snapshot) return false;
+    applySnapshot(*snapshot);
+    std::cout << "Loaded forest snapshot with " << shroomObjects.size() << " shrooms from " << path << std::endl;
+    return true;
+}
+
+void MultiShaderForestScene::applySnapshot(const SceneSnapshot& snapshot) {
+    clearShrooms();
+    for (size_t i = 0; i < snapshot.objectCount(); ++i) {
+        const Snapshot::ObjectRecord& record = snapshot.objects()[i];
+        if (record.tag != SNAPSHOT_SHROOM) continue;
+        if (std::string(snapshot.string(record.model)) != SHROOM_MODEL.first) {
+            std::cerr << "Snapshot shroom uses unknown model " << snapshot.string(record.model) << "!!!" << std::endl;
+            continue;
+        }
+        glm::mat4 matrix = SceneSnapshot::Matrix(record);
+        addShroom(std::make_shared<TransformMatrix>(matrix), glm::vec3(matrix[3]) / matrix[3][3],
+                  SceneSnapshot::MaterialOf(record));
+    }
+
+    // lights are matched by order, a snapshot from a different setup leaves them alone
+    std::vector<Light*> sceneLights;
+    for (const auto& light : lights) sceneLights.push_back(light.get());
+    sceneLights.push_back(directionalLight.get());
+    sceneLights.push_back(flashlight.get());
+    if (snapshot.lightCount() == sceneLights.size()) {
+        for (size_t i = 0; i < sceneLights.size(); ++i) {
+            const Snapshot::LightRecord& record = snapshot.lights()[i];
+            if (record.type == static_cast<uint32_t>(sceneLights[i]->getType())) {
+                SceneSnapshot::Apply(record, *sceneLights[i]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < snapshot.pathCount(); ++i) {
+        const Snapshot::PathRecord& record = snapshot.paths()[i];
+        if (record.tag != SNAPSHOT_SHREK_PATH || record.count < 4) continue;
+        bezierControlPoints = snapshot.pathPoints(record);
+        updateBezierPath();
+    }
+}
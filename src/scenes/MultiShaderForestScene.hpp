@@ -1,8 +1,13 @@
 #pragma once
 #include "BaseScene.hpp"
+#include "../renderers/Particles.hpp"
+#include "../renderers/Scatter.hpp"
+#include "../world/Terrain.hpp"
 #include <memory>
 #include <vector>
 
+class SceneSnapshot;
+
 class MultiShaderForestScene : public BaseScene {
 public:
     enum class EditMode {
@@ -16,6 +21,7 @@ public:
     void draw() override;
     void attachToCamera(Camera* camera) override;
     void detachFromCamera(Camera* camera) override;
+    void declareAssets(AssetManifest& assets) const override;
     void toggleFlashlight() { flashlightEnabled = !flashlightEnabled; }
     void toggleEditMode() { 
         editMode = static_cast<EditMode>((static_cast<int>(editMode) + 1) % 3);
@@ -36,6 +42,13 @@ public:
     void handleMouseClick(double xpos, double ypos, int width, int height);
     void updateMouseHover(double xpos, double ypos, int width, int height);
     void resetBezierPath();
+    // where F5 saves and F9 loads; init() starts from it when it exists
+    static constexpr const char* SNAPSHOT_PATH = "world_cache/forest.snapshot";
+    // the user's shrooms, the edited path and the lights, plus the generated
+    // ground heights and vegetation placement that init() then maps instead
+    // of generating; loading at runtime only brings back the edits
+    bool saveSnapshot(const std::string& path);
+    bool loadSnapshot(const std::string& path);
 
 private:
     std::unique_ptr<Shader> lambertShader;
@@ -43,11 +56,18 @@ private:
     std::unique_ptr<Shader> blinnShader;
     std::unique_ptr<Shader> phongTexturedShader;
     std::unique_ptr<Shader> triangleShader;
+    std::unique_ptr<Shader> impostorBakeShader;
+    // terrain_vertex.glsl with the textured phong lighting
+    std::unique_ptr<Shader> terrainShader;
+    // particles_update.glsl with transform feedback, and the sprite program
+    std::unique_ptr<Shader> particleUpdateShader;
+    std::unique_ptr<Shader> particleShader;
+    // lambert, phong and blinn over vertex_scatter.glsl, then the impostor program
+    std::vector<std::unique_ptr<Shader>> scatterShaders;
+    Shader* impostorShader = nullptr;
 
     std::unique_ptr<Model> bushModel;
     std::unique_ptr<Model> treeModel;
-    std::unique_ptr<Model> plainModel;
-    std::unique_ptr<Model> sphereModel;
     std::unique_ptr<Model> shrekModel;
     std::unique_ptr<Model> fionaModel;
     std::unique_ptr<Model> toiletModel;
@@ -63,15 +83,19 @@ private:
     std::unique_ptr<Light> directionalLight;
     std::unique_ptr<Light> flashlight;
     
-    struct LightSphere {
+    struct FireflyLight {
         Light* light;
-        size_t objectIndex;
+        float radius;
+        float height;
     };
-    std::vector<LightSphere> lightSpheres;
-    std::vector<std::shared_ptr<TransformRotation>> fireflyRotations;
+    std::vector<FireflyLight> fireflyLights;
+    // the swarm lives on the GPU; its first particles sit exactly where the
+    // point lights are, so the lit ones glow like the rest
+    std::unique_ptr<ParticleSystem> fireflies;
+    float lastFrameTime = 0.0f;
     
     struct ShroomObject {
-        int objectIndex;
+        ObjectHandle object;
         glm::vec3 position;
     };
     std::vector<ShroomObject> shroomObjects;
@@ -81,15 +105,29 @@ private:
     int hoveredShroomIndex = -1;
     
     std::shared_ptr<TransformBezier> shrekBezierTrans;
-    int shrekObjectIndex;
+    BezierFollowers followers;
+    ObjectHandle shrekObject;
     float bezierAnimSpeed = 0.15f;
     std::vector<glm::vec3> bezierControlPoints;
     
+    std::vector<uint32_t> rayHits;
+
+    std::unique_ptr<ScatterField> vegetation;
+    std::unique_ptr<Terrain> terrain;
+
+    void mouseRay(double xpos, double ypos, int width, int height, glm::vec3& origin, glm::vec3& dir);
     glm::vec3 mouseToWorld(double xpos, double ypos, int width, int height);
     int getShroomAtCursor(double xpos, double ypos, int W, int H);
+    void setHoveredShroom(int shroomIndex);
+    void drawShroom(const DrawableObject& obj);
     void drawShroomsWStencil();
     void addShroomAtPos(const glm::vec3& worldPos);
+    void addShroom(std::shared_ptr<Transform> transform, const glm::vec3& worldPos,
+                   const Material& material = Material::Plastic());
+    void clearShrooms();
     void deleteShroomAtCursor(double xpos, double ypos, int W, int H);
     void addBezierPoint(const glm::vec3& worldPos);
     void updateBezierPath();
+    // shrooms, lights and the path
+    void applySnapshot(const SceneSnapshot& snapshot);
 };
\ No newline at end of file
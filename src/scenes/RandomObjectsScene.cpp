@@ -3,55 +3,69 @@
 #include <cstdlib>
 #include <ctime>
 #include <string>
+#include <GLFW/glfw3.h>
+
+namespace {
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/vertex.glsl");
+const std::string FRAG_TRIANGLE_SHADER = SCENE_ASSETS.shader("src/shaders/frag_triangle.glsl");
+const std::string FRAG_RECTANGLE_SHADER = SCENE_ASSETS.shader("src/shaders/frag_rectangle.glsl");
+const std::string FRAG_GREEN_SHADER = SCENE_ASSETS.shader("src/shaders/frag_green.glsl");
+const ModelFile PLANET_MODEL = SCENE_ASSETS.model("src/objects/planet.obj", ModelType::UV);
+// a cube and a sphere each
+const int OBJECT_PAIRS = 2000;
+}
 
 void RandomObjectsScene::init() {
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
 
-    std::string vertexSrc        = loadShaderSrc("src/shaders/vertex.glsl");
-    std::string fragTriangleSrc  = loadShaderSrc("src/shaders/frag_triangle.glsl");
-    std::string fragRectangleSrc = loadShaderSrc("src/shaders/frag_rectangle.glsl");
-    std::string fragGreenSrc     = loadShaderSrc("src/shaders/frag_green.glsl");
+    std::string vertexSrc        = loadShaderSrc(VERTEX_SHADER);
+    std::string fragTriangleSrc  = loadShaderSrc(FRAG_TRIANGLE_SHADER);
+    std::string fragRectangleSrc = loadShaderSrc(FRAG_RECTANGLE_SHADER);
+    std::string fragGreenSrc     = loadShaderSrc(FRAG_GREEN_SHADER);
 
     shader1 = std::make_unique<Shader>(vertexSrc.c_str(), fragTriangleSrc.c_str());
     shader2 = std::make_unique<Shader>(vertexSrc.c_str(), fragRectangleSrc.c_str());
     shader3 = std::make_unique<Shader>(vertexSrc.c_str(), fragGreenSrc.c_str());
 
     cubeModel = ModelFactory::CreateCube();
-    sphereModel = ModelFactory::CreatePlainSphere();
+    sphereModel = Model::LoadFromFile(PLANET_MODEL);
 
-    for (int i = 0; i < 10; ++i) {
-        auto cubeTransform = std::make_shared<TransformComposite>();
-        cubeTransform->add(std::make_shared<TransformTranslation>(
-            glm::vec3(
-                ((rand() % 200) / 50.0f) - 2.0f,
-                ((rand() % 200) / 50.0f) - 1.0f,
-                ((rand() % 200) / 50.0f) - 2.0f
-            )
-        ));
-        cubeTransform->add(std::make_shared<TransformRotation>(
-            static_cast<float>(rand() % 360), glm::vec3(0.0f, 1.0f, 0.0f)
-        ));
-        cubeTransform->add(std::make_shared<TransformScale>(glm::vec3(0.5f, 0.5f, 0.5f)));
-        Shader* chosenShader = (rand() % 2 == 0) ? shader2.get() : shader3.get();
-        addObject(cubeModel.get(), chosenShader, cubeTransform);
+    transformPool.reserve(OBJECT_PAIRS * 2);
+    transformPool.setWorkers(workers);
+    spins.reserve(OBJECT_PAIRS * 2);
+    for (int i = 0; i < OBJECT_PAIRS * 2; ++i) {
+        glm::vec3 position(
+            ((rand() % 4000) / 100.0f) - 20.0f,
+            ((rand() % 2000) / 100.0f) - 1.0f,
+            ((rand() % 4000) / 100.0f) - 20.0f
+        );
+        // cubes turn about y, spheres about x like before
+        glm::vec3 axis = (i % 2 == 0) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        float phase = glm::radians(static_cast<float>(rand() % 360));
+        float speed = glm::radians(static_cast<float>(rand() % 90) - 45.0f);
+        uint32_t poolIndex = transformPool.add(position, glm::angleAxis(phase, axis), glm::vec3(0.5f));
+        spins.push_back({axis, phase, speed});
 
-        auto sphereTransform = std::make_shared<TransformComposite>();
-        sphereTransform->add(std::make_shared<TransformTranslation>(
-            glm::vec3(
-                ((rand() % 200) / 50.0f) - 2.0f,
-                ((rand() % 200) / 50.0f) - 1.0f,
-                ((rand() % 200) / 50.0f) - 2.0f
-            )
-        ));
-        sphereTransform->add(std::make_shared<TransformRotation>(
-            static_cast<float>(rand() % 360), glm::vec3(1.0f, 0.0f, 0.0f)
-        ));
-        sphereTransform->add(std::make_shared<TransformScale>(glm::vec3(0.5f, 0.5f, 0.5f)));
-        addObject(sphereModel.get(), shader1.get(), sphereTransform);
+        if (i % 2 == 0) {
+            Shader* chosenShader = (rand() % 2 == 0) ? shader2.get() : shader3.get();
+            addObject(cubeModel.get(), chosenShader, transformPool.makeTransform(poolIndex));
+        } else {
+            addObject(sphereModel.get(), shader1.get(), transformPool.makeTransform(poolIndex));
+        }
     }
+    transformPool.update();
+
+    buildInstanceGroups();
 }
 
 void RandomObjectsScene::draw() {
+    float time = static_cast<float>(glfwGetTime());
+    for (uint32_t i = 0; i < spins.size(); ++i) {
+        const Spin& spin = spins[i];
+        transformPool.setRotation(i, glm::angleAxis(spin.phase + spin.speed * time, spin.axis));
+    }
+    transformPool.update();
     drawImpl();
 }
 
@@ -61,4 +75,8 @@ void RandomObjectsScene::attachToCamera(Camera* camera) {
 
 void RandomObjectsScene::detachFromCamera(Camera* camera) {
     detachFromCameraImpl(camera);
+}
+
+void RandomObjectsScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "BaseScene.hpp"
+#include "../trans/TransformPool.hpp"
 #include <memory>
+#include <vector>
 
 class RandomObjectsScene : public BaseScene {
 public:
@@ -9,9 +11,20 @@ public:
     void draw() override;
     void attachToCamera(Camera* camera) override;
     void detachFromCamera(Camera* camera) override;
+    void declareAssets(AssetManifest& assets) const override;
 
 private:
     std::unique_ptr<Model> cubeModel;
     std::unique_ptr<Model> sphereModel;
     std::unique_ptr<Shader> shader1, shader2, shader3;
+
+    // every object spins about its own axis, so all matrices are rebuilt
+    // each frame in one pass over the pool
+    TransformPool transformPool;
+    struct Spin {
+        glm::vec3 axis;
+        float phase;
+        float speed;
+    };
+    std::vector<Spin> spins;
 };
@@ -1,9 +1,15 @@
 #include "RotatingTriangleScene.hpp"
 #include <GLFW/glfw3.h>
 
+namespace {
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/vertex.glsl");
+const std::string FRAG_TRIANGLE_SHADER = SCENE_ASSETS.shader("src/shaders/frag_triangle.glsl");
+}
+
 void RotatingTriangleScene::init() {
-    std::string vertexSrc = loadShaderSrc("src/shaders/vertex.glsl");
-    std::string fragTriangleSrc = loadShaderSrc("src/shaders/frag_triangle.glsl");
+    std::string vertexSrc = loadShaderSrc(VERTEX_SHADER);
+    std::string fragTriangleSrc = loadShaderSrc(FRAG_TRIANGLE_SHADER);
     
     shader = std::make_unique<Shader>(vertexSrc.c_str(), fragTriangleSrc.c_str());
 
@@ -15,24 +21,13 @@ void RotatingTriangleScene::init() {
     
     triangle = ModelFactory::CreateTriangle();
     
-    transform = std::make_shared<TransformComposite>();
-    transform->add(std::make_shared<TransformIdentity>());
-    
-    addObject(triangle.get(), shader.get(), transform);
+    rotation = std::make_shared<TransformRotation>(0.0f, glm::vec3(0.0f, 0.0f, 1.0f));
+    addObject(triangle.get(), shader.get(), rotation);
 }
 
 void RotatingTriangleScene::draw() {
     float time = static_cast<float>(glfwGetTime());
-    auto rotation = std::make_shared<TransformRotation>(time * 50.0f, glm::vec3(0.0f, 0.0f, 1.0f));
-    
-    transform = std::make_shared<TransformComposite>();
-    transform->add(std::make_shared<TransformIdentity>());
-    transform->add(rotation);
-    
-    if (!objects.empty()) {
-        objects[0].transform = transform;
-    }
-    
+    rotation->setAngle(time * 50.0f);
     drawImpl();
 }
 
@@ -42,4 +37,8 @@ void RotatingTriangleScene::attachToCamera(Camera* camera) {
 
 void RotatingTriangleScene::detachFromCamera(Camera* camera) {
     detachFromCameraImpl(camera);
+}
+
+void RotatingTriangleScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
 }
\ No newline at end of file
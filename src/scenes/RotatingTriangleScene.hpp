@@ -9,9 +9,11 @@ public:
     void draw() override;
     void attachToCamera(Camera* camera) override;
     void detachFromCamera(Camera* camera) override;
+    void declareAssets(AssetManifest& assets) const override;
 
 private:
     std::unique_ptr<Shader> shader;
     std::unique_ptr<Model> triangle;
-    std::shared_ptr<TransformComposite> transform;
+    // updated in place every frame
+    std::shared_ptr<TransformRotation> rotation;
 };
\ No newline at end of file
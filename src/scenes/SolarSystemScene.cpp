@@ -4,29 +4,52 @@
 #include <GLFW/glfw3.h>
 #include <cmath>
 
+namespace {
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/vertex.glsl");
+const std::string VERTEX_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/vertex_textured.glsl");
+const std::string FRAG_LAMBERT_SHADER = SCENE_ASSETS.shader("src/shaders/frag_lambert.glsl");
+const std::string FRAG_RECTANGLE_SHADER = SCENE_ASSETS.shader("src/shaders/frag_rectangle.glsl");
+const std::string FRAG_LAMBERT_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/frag_lambert_textured.glsl");
+const std::string VERTEX_PROCEDURAL_SHADER = SCENE_ASSETS.shader("src/shaders/vertex_procedural.glsl");
+const std::string MERCURY_TEXTURE = SCENE_ASSETS.texture("src/images/mercury.jpg");
+const std::string VENUS_TEXTURE = SCENE_ASSETS.texture("src/images/venus.jpg");
+const std::string EARTH_TEXTURE = SCENE_ASSETS.texture("src/images/earth.jpg");
+const std::string MARS_TEXTURE = SCENE_ASSETS.texture("src/images/mars.jpg");
+const std::string JUPITER_TEXTURE = SCENE_ASSETS.texture("src/images/jupiter.jpg");
+const std::string SATURN_TEXTURE = SCENE_ASSETS.texture("src/images/saturn.jpg");
+const std::string URANUS_TEXTURE = SCENE_ASSETS.texture("src/images/uranus.jpg");
+const std::string NEPTUNE_TEXTURE = SCENE_ASSETS.texture("src/images/neptune.jpg");
+const std::string MOON_TEXTURE = SCENE_ASSETS.texture("src/images/moon.jpg");
+const std::string SUN_TEXTURE = SCENE_ASSETS.texture("src/images/sun.jpg");
+const ModelFile PLANET_MODEL = SCENE_ASSETS.model("src/objects/planet.obj", ModelType::UV);
+}
+
 void SolarSystemScene::init() {
-    std::string vertexSrc = loadShaderSrc("src/shaders/vertex.glsl");
-    std::string vertexTexturedSrc = loadShaderSrc("src/shaders/vertex_textured.glsl");
-    std::string fragSrc = loadShaderSrc("src/shaders/frag_lambert.glsl");
-    std::string fragSrc2 = loadShaderSrc("src/shaders/frag_rectangle.glsl");
-    std::string fragTexturedSrc = loadShaderSrc("src/shaders/frag_lambert_textured.glsl");
+    std::string vertexSrc = loadShaderSrc(VERTEX_SHADER);
+    std::string vertexTexturedSrc = loadShaderSrc(VERTEX_TEXTURED_SHADER);
+    std::string fragSrc = loadShaderSrc(FRAG_LAMBERT_SHADER);
+    std::string fragSrc2 = loadShaderSrc(FRAG_RECTANGLE_SHADER);
+    std::string fragTexturedSrc = loadShaderSrc(FRAG_LAMBERT_TEXTURED_SHADER);
+    std::string vertexProceduralSrc = loadShaderSrc(VERTEX_PROCEDURAL_SHADER);
 
     shader = std::make_unique<Shader>(vertexSrc.c_str(), fragSrc.c_str());
     shaderSun = std::make_unique<Shader>(vertexSrc.c_str(), fragSrc2.c_str());
     texturedShader = std::make_unique<Shader>(vertexTexturedSrc.c_str(), fragTexturedSrc.c_str());
+    proceduralShader = std::make_unique<Shader>(vertexProceduralSrc.c_str(), fragTexturedSrc.c_str());
 
-    sphereModel = ModelFactory::CreatePlainSphere();
+    sphereModel = Model::LoadFromFile(PLANET_MODEL);
 
-    mercuryTexture = std::make_unique<Texture>("src/images/mercury.jpg");
-    venusTexture = std::make_unique<Texture>("src/images/venus.jpg");
-    earthTexture = std::make_unique<Texture>("src/images/earth.jpg");
-    marsTexture = std::make_unique<Texture>("src/images/mars.jpg");
-    jupiterTexture = std::make_unique<Texture>("src/images/jupiter.jpg");
-    saturnTexture = std::make_unique<Texture>("src/images/saturn.jpg");
-    uranusTexture = std::make_unique<Texture>("src/images/uranus.jpg");
-    neptuneTexture = std::make_unique<Texture>("src/images/neptune.jpg");
-    moonTexture = std::make_unique<Texture>("src/images/moon.jpg");
-    sunTexture = std::make_unique<Texture>("src/images/sun.jpg");
+    mercuryTexture = std::make_unique<Texture>(MERCURY_TEXTURE);
+    venusTexture = std::make_unique<Texture>(VENUS_TEXTURE);
+    earthTexture = std::make_unique<Texture>(EARTH_TEXTURE);
+    marsTexture = std::make_unique<Texture>(MARS_TEXTURE);
+    jupiterTexture = std::make_unique<Texture>(JUPITER_TEXTURE);
+    saturnTexture = std::make_unique<Texture>(SATURN_TEXTURE);
+    uranusTexture = std::make_unique<Texture>(URANUS_TEXTURE);
+    neptuneTexture = std::make_unique<Texture>(NEPTUNE_TEXTURE);
+    moonTexture = std::make_unique<Texture>(MOON_TEXTURE);
+    sunTexture = std::make_unique<Texture>(SUN_TEXTURE);
 
     light = std::make_unique<Light>(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f));
     light->setAmbient(0.3f);
@@ -38,15 +61,23 @@ void SolarSystemScene::init() {
 
     shader->addLight(light.get());
     texturedShader->addLight(light.get());
+    proceduralShader->addLight(light.get());
     light->attach(shader.get());
     light->attach(texturedShader.get());
+    light->attach(proceduralShader.get());
     shader->updateAllLights();
     texturedShader->updateAllLights();
+    proceduralShader->updateAllLights();
 
     texturedShader->use();
     texturedShader->SetUniform("useTexture", true);
     texturedShader->SetUniform("shininess", 32.0f);
     texturedShader->SetUniform("isSun", false);
+    proceduralShader->use();
+    proceduralShader->SetUniform("useTexture", true);
+    proceduralShader->SetUniform("shininess", 32.0f);
+    proceduralShader->SetUniform("textureSampler", 0);
+    proceduralShader->SetUniform("animParams", 1);
     glUseProgram(0);
 
     sunRotationTransform = std::make_shared<TransformRotation>(0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -67,10 +98,11 @@ void SolarSystemScene::init() {
         {20.0f, 19.0f, 0.07f, 0.45f, 1.0f, 1.8f, 0.10f, 2.0f}// neptune
     };
 
-    Texture* planetTextures[] = {
+    planetTextureList = {
         mercuryTexture.get(), venusTexture.get(), earthTexture.get(), marsTexture.get(),
         jupiterTexture.get(), saturnTexture.get(), uranusTexture.get(), neptuneTexture.get()
     };
+    Texture** planetTextures = planetTextureList.data();
 
     for (int i = 0; i < planets.size(); i++) {
         auto& planet = planets[i];
@@ -85,6 +117,7 @@ void SolarSystemScene::init() {
         };
 
         planet.orbitBezier = std::make_shared<TransformBezier>(ellipsePoints, 0.0f);
+        orbits.add(planet.orbitBezier, planet.orbitalSpeed * 0.1f);
         planet.selfRotation = std::make_shared<TransformRotation>(0.0f, glm::vec3(0,1,0));
 
         auto planetTransform = std::make_shared<TransformComposite>();
@@ -113,19 +146,93 @@ void SolarSystemScene::init() {
             addObject(sphereModel.get(), texturedShader.get(), dummyTransform, nullptr);
         }
     }
+
+    // moons share model, shader and texture, so the CPU path draws them in one call
+    std::vector<size_t> moonObjects;
+    for (int i = 2; i < planets.size(); i++) {
+        moonObjects.push_back(2 + i * 2);
+    }
+    addInstanceGroup(moonObjects);
+
+    buildGpuAnimation();
+}
+
+void SolarSystemScene::buildGpuAnimation() {
+    // mirrors the transform composites built in init()
+    ProceduralAnimation::Body sun;
+    sun.spinSpeed = glm::radians(20.0f);
+    sun.scale = 1.5f;
+    sunBody = animation.addBody(sun);
+
+    firstPlanetBody = animation.getBodyCount();
+    for (auto& planet : planets) {
+        ProceduralAnimation::Body body;
+        body.curve = animation.addCurve(*planet.orbitBezier);
+        body.curveSpeed = planet.orbitalSpeed * 0.1f;
+        body.spinSpeed = glm::radians(planet.rotationSpeed * 50.0f);
+        body.scale = planet.scale;
+        animation.addBody(body);
+    }
+
+    // moons are contiguous so they go out in a single instanced draw
+    firstMoonBody = animation.getBodyCount();
+    for (int i = 2; i < planets.size(); i++) {
+        auto& planet = planets[i];
+        ProceduralAnimation::Body moon;
+        moon.parent = firstPlanetBody + i;
+        moon.orbitRadius = planet.moonOrbitRadius;
+        moon.orbitSpeed = planet.moonSpeed;
+        moon.spinSpeed = glm::radians(planet.moonSpeed * 20.0f);
+        moon.scale = planet.moonScale;
+        animation.addBody(moon);
+    }
+    moonCount = animation.getBodyCount() - firstMoonBody;
+
+    animation.upload();
+}
+
+void SolarSystemScene::drawGpuAnimated() {
+    proceduralShader->use();
+    proceduralShader->SetUniform("time", static_cast<float>(glfwGetTime()));
+    animation.bind(1);
+
+    sunTexture->bind(0);
+    proceduralShader->SetUniform("isSun", true);
+    proceduralShader->SetUniform("sunRadius", 3.0f);
+    proceduralShader->SetUniform("sunGlow", 2.0f);
+    proceduralShader->SetUniform("bodyOffset", sunBody);
+    sphereModel->draw(GL_TRIANGLES);
+    proceduralShader->SetUniform("isSun", false);
+
+    for (int i = 0; i < planets.size(); i++) {
+        planetTextureList[i]->bind(0);
+        proceduralShader->SetUniform("bodyOffset", firstPlanetBody + i);
+        sphereModel->draw(GL_TRIANGLES);
+    }
+
+    moonTexture->bind(0);
+    proceduralShader->SetUniform("bodyOffset", firstMoonBody);
+    sphereModel->drawInstanced(moonCount, GL_TRIANGLES);
+    moonTexture->unbind();
+
+    animation.unbind();
+    glUseProgram(0);
 }
 
 void SolarSystemScene::draw() {
+    if (gpuAnimation) {
+        drawGpuAnimated();
+        return;
+    }
+
     float time = static_cast<float>(glfwGetTime());
     float sunRotation = fmod(time * 20.0f, 360.0f);
     sunRotationTransform->setAngle(sunRotation);
 
+    orbits.update(time);
     for (int i = 0; i < planets.size(); i++) {
         auto& planet = planets[i];
         
-        float t = fmod(time * planet.orbitalSpeed * 0.1f, 1.0f);
-        planet.orbitBezier->setParam(t);
-        
         float planetRotation = fmod(time * planet.rotationSpeed * 50.0f, 360.0f);
         planet.selfRotation->setAngle(planetRotation);
         
@@ -177,33 +284,22 @@ void SolarSystemScene::draw() {
             objects[planetIdx].texture->unbind();
         }
         glUseProgram(0);
-        
-        int moonIdx = 2 + i * 2;
-        if (i > 1) {
-            objects[moonIdx].shader->use();
-            
-            if (objects[moonIdx].texture) {
-                objects[moonIdx].texture->bind(0);
-                objects[moonIdx].shader->SetUniform("textureSampler", 0);
-            }
-            
-            if (attachedCamera) objects[moonIdx].shader->SetUniform("viewPos", attachedCamera->getPosition());
-            model = objects[moonIdx].transform->getMatrix();
-            objects[moonIdx].shader->SetUniform("model", model);
-            objects[moonIdx].model->draw(GL_TRIANGLES);
-            
-            if (objects[moonIdx].texture) {
-                objects[moonIdx].texture->unbind();
-            }
-            glUseProgram(0);
-        }
     }
+
+    drawInstanceGroups();
 }
 
 void SolarSystemScene::attachToCamera(Camera* camera) {
+    // not referenced by any object, so the base attach would miss it
+    camera->attach(proceduralShader.get());
     attachToCameraImpl(camera);
 }
 
 void SolarSystemScene::detachFromCamera(Camera* camera) {
+    camera->detach(proceduralShader.get());
     detachFromCameraImpl(camera);
+}
+
+void SolarSystemScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "BaseScene.hpp"
+#include "../renderers/ProceduralAnimation.hpp"
 #include <memory>
 #include <string>
 #include <vector>
@@ -11,11 +12,17 @@ public:
     void draw() override;
     void attachToCamera(Camera* camera) override;
     void detachFromCamera(Camera* camera) override;
+    void declareAssets(AssetManifest& assets) const override;
+    void toggleGpuAnimation() {
+        gpuAnimation = !gpuAnimation;
+        std::cout << "Solar system animation: " << (gpuAnimation ? "GPU" : "CPU") << std::endl;
+    }
 
 private:
     std::unique_ptr<Shader> shader;
     std::unique_ptr<Shader> shaderSun;
     std::unique_ptr<Shader> texturedShader;
+    std::unique_ptr<Shader> proceduralShader;
 
     std::unique_ptr<Model> sphereModel;
     
@@ -58,4 +65,17 @@ private:
     };
     
     std::vector<PlanetData> planets;
+    BezierFollowers orbits;
+
+    // same motion evaluated in the vertex shader, nothing updated per frame
+    ProceduralAnimation animation;
+    bool gpuAnimation = false;
+    int sunBody = 0;
+    int firstPlanetBody = 0;
+    int firstMoonBody = 0;
+    int moonCount = 0;
+    std::vector<Texture*> planetTextureList;
+
+    void buildGpuAnimation();
+    void drawGpuAnimated();
 };
\ No newline at end of file
@@ -1,11 +1,17 @@
 #include "SymmetricalBallsScene.hpp"
 #include <string>
 
+namespace {
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/vertex.glsl");
+const std::string FRAG_PHONG_CORRECT_SHADER = SCENE_ASSETS.shader("src/shaders/frag_phong_correct.glsl");
+}
+
 SymmetricalBallsScene::SymmetricalBallsScene() {}
 
 void SymmetricalBallsScene::init() {
-    std::string vertexSrc = loadShaderSrc("src/shaders/vertex.glsl");
-    std::string fragSrc   = loadShaderSrc("src/shaders/frag_phong_correct.glsl");
+    std::string vertexSrc = loadShaderSrc(VERTEX_SHADER);
+    std::string fragSrc   = loadShaderSrc(FRAG_PHONG_CORRECT_SHADER);
     shader = std::make_unique<Shader>(vertexSrc.c_str(), fragSrc.c_str());
 
     sphereModel = ModelFactory::CreateSphere();
@@ -27,9 +33,10 @@ void SymmetricalBallsScene::init() {
     };
 
     for (int i = 0; i < 4; ++i) {
-        auto t = std::make_shared<TransformComposite>();
-        t->add(std::make_shared<TransformTranslation>(glm::vec3(positions[i][0], positions[i][1], 0.0f)));
-        t->add(std::make_shared<TransformScale>(glm::vec3(0.5f, 0.5f, 0.5f)));
+        auto t = std::make_shared<TransformTS>(
+            TransformTranslation(glm::vec3(positions[i][0], positions[i][1], 0.0f)),
+            TransformScale(glm::vec3(0.5f, 0.5f, 0.5f))
+        );
 
         addObject(sphereModel.get(), shader.get(), t);
     }
@@ -49,4 +56,8 @@ void SymmetricalBallsScene::attachToCamera(Camera* camera) {
 
 void SymmetricalBallsScene::detachFromCamera(Camera* camera) {
     detachFromCameraImpl(camera);
+}
+
+void SymmetricalBallsScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
 }
\ No newline at end of file
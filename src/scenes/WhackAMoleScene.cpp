@@ -3,6 +3,25 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 
+namespace {
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/vertex_textured.glsl");
+const std::string MULT_PHONG_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/mult_phong_textured.glsl");
+const std::string PARTICLES_UPDATE_SHADER = SCENE_ASSETS.shader("src/shaders/particles_update.glsl");
+const std::string PARTICLES_VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/particles_vertex.glsl");
+const std::string PARTICLES_FRAGMENT_SHADER = SCENE_ASSETS.shader("src/shaders/particles_fragment.glsl");
+const std::string SHREK_TEXTURE = SCENE_ASSETS.texture("src/images/shrek.png");
+const std::string FIONA_TEXTURE = SCENE_ASSETS.texture("src/images/fiona.png");
+const std::string SHROOM_TEXTURE = SCENE_ASSETS.texture("src/images/hrib.jpg");
+const std::string SWAMP_TEXTURE = SCENE_ASSETS.texture("src/images/swamp.png");
+const std::string HAMMER_TEXTURE = SCENE_ASSETS.texture("src/images/hammer.jpg");
+const ModelFile CUP_MODEL = SCENE_ASSETS.model("src/objects/cup.obj", ModelType::UV);
+const ModelFile SHREK_MODEL = SCENE_ASSETS.model("src/objects/shrek.obj", ModelType::UV);
+const ModelFile FIONA_MODEL = SCENE_ASSETS.model("src/objects/fiona.obj", ModelType::UV);
+const ModelFile SHROOM_MODEL = SCENE_ASSETS.model("src/objects/mushromms.obj", ModelType::UV);
+const ModelFile HAMMER_MODEL = SCENE_ASSETS.model("src/objects/hammer.obj", ModelType::UV);
+}
+
 WhackAMoleScene::WhackAMoleScene()
     : score(0),
       enemiesSpawned(0),
@@ -16,23 +35,35 @@ WhackAMoleScene::WhackAMoleScene()
       moveChanceDistrib(0.0f, 1.0f) {}
 
 void WhackAMoleScene::init() {
-    std::string vertexTexturedSrc = loadShaderSrc("src/shaders/vertex_textured.glsl");
-    std::string fragPhongTexturedSrc = loadShaderSrc("src/shaders/mult_phong_textured.glsl");
+    std::string vertexTexturedSrc = loadShaderSrc(VERTEX_TEXTURED_SHADER);
+    std::string fragPhongTexturedSrc = loadShaderSrc(MULT_PHONG_TEXTURED_SHADER);
 
     phongTexturedShader = std::make_unique<Shader>(vertexTexturedSrc.c_str(), fragPhongTexturedSrc.c_str());
 
-    cupModel = ModelFactory::CreateCup();
-    shrekModel = ModelFactory::CreateShrek();
-    fionaModel = ModelFactory::CreateFiona();
-    shroomModel = ModelFactory::CreateShroom();
-    hammerModel = ModelFactory::CreateHammer();
+    std::string particleUpdateSrc = loadShaderSrc(PARTICLES_UPDATE_SHADER);
+    std::string particleVertexSrc = loadShaderSrc(PARTICLES_VERTEX_SHADER);
+    std::string particleFragmentSrc = loadShaderSrc(PARTICLES_FRAGMENT_SHADER);
+    particleUpdateShader = std::make_unique<Shader>(particleUpdateSrc.c_str(), ParticleSystem::FEEDBACK_VARYINGS);
+    particleShader = std::make_unique<Shader>(particleVertexSrc.c_str(), particleFragmentSrc.c_str());
+
+    ParticleSystem::Settings sparkSettings;
+    sparkSettings.capacity = 4096;
+    sparkSettings.color = glm::vec3(1.0f, 0.55f, 0.15f);
+    sparkSettings.size = 0.08f;
+    sparks = std::make_unique<ParticleSystem>(sparkSettings);
+
+    cupModel = Model::LoadFromFile(CUP_MODEL);
+    shrekModel = Model::LoadFromFile(SHREK_MODEL);
+    fionaModel = Model::LoadFromFile(FIONA_MODEL);
+    shroomModel = Model::LoadFromFile(SHROOM_MODEL);
+    hammerModel = Model::LoadFromFile(HAMMER_MODEL);
     plainModel = ModelFactory::CreatePlain();
     
-    shrekTexture = std::make_unique<Texture>("src/images/shrek.png");
-    fionaTexture = std::make_unique<Texture>("src/images/fiona.png");
-    shroomTexture = std::make_unique<Texture>("src/images/hrib.jpg");
-    grassTexture = std::make_unique<Texture>("src/images/swamp.png");
-    hammerTexture = std::make_unique<Texture>("src/images/hammer.jpg");
+    shrekTexture = std::make_unique<Texture>(SHREK_TEXTURE);
+    fionaTexture = std::make_unique<Texture>(FIONA_TEXTURE);
+    shroomTexture = std::make_unique<Texture>(SHROOM_TEXTURE);
+    grassTexture = std::make_unique<Texture>(SWAMP_TEXTURE);
+    hammerTexture = std::make_unique<Texture>(HAMMER_TEXTURE);
 
     auto light1 = std::make_unique<Light>(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(1.0f), LightType::POINT);
     light1->setAmbient(0.3f);
@@ -57,15 +88,20 @@ void WhackAMoleScene::init() {
     phongTexturedShader->updateAllLights();
     glUseProgram(0);
 
-    auto plainTransform = std::make_shared<TransformComposite>();
-    plainTransform->add(std::make_shared<TransformTranslation>(glm::vec3(0.0f, -2.0f, 0.0f)));
-    plainTransform->add(std::make_shared<TransformScale>(glm::vec3(20.0f, 1.0f, 20.0f)));
-    addObject(plainModel.get(), phongTexturedShader.get(), plainTransform, grassTexture.get());
-
-    initializeHoles();
+    auto plainTransform = std::make_shared<TransformTS>(
+        TransformTranslation(glm::vec3(0.0f, -2.0f, 0.0f)),
+        TransformScale(glm::vec3(20.0f, 1.0f, 20.0f))
+    );
+    std::vector<ObjectHandle> staticObjects;
+    staticObjects.push_back(addObject(plainModel.get(), phongTexturedShader.get(), plainTransform, grassTexture.get()));
+
+    initializeHoles(staticObjects);
+    // the ground and the six cups never move, the cups end up in one draw
+    batchStatic(staticObjects);
+    initializePools();
 }
 
-void WhackAMoleScene::initializeHoles() {
+void WhackAMoleScene::initializeHoles(std::vector<ObjectHandle>& staticObjects) {
     const float startX = -6.0f;
     const float startZ = -3.0f;
     const float spacingX = 4.0f;
@@ -76,27 +112,67 @@ void WhackAMoleScene::initializeHoles() {
         for (int col = 0; col < 3; ++col) {
             glm::vec3 pos(startX + col * spacingX, yPos, startZ + row * spacingZ);
             
-            auto cupTransform = std::make_shared<TransformComposite>();
-            cupTransform->add(std::make_shared<TransformTranslation>(pos));
-            cupTransform->add(std::make_shared<TransformTranslation>(glm::vec3(3,0,1)));
-            cupTransform->add(std::make_shared<TransformRotation>(-90.0f, glm::vec3(1,0,0)));
-            cupTransform->add(std::make_shared<TransformRotation>(-180.0f, glm::vec3(0,1,0)));
-            cupTransform->add(std::make_shared<TransformScale>(glm::vec3(0.5f)));
+            auto cupTransform = std::make_shared<StaticComposite<TransformTranslation, TransformTranslation,
+                                                                 TransformRotation, TransformRotation, TransformScale>>(
+                TransformTranslation(pos),
+                TransformTranslation(glm::vec3(3,0,1)),
+                TransformRotation(-90.0f, glm::vec3(1,0,0)),
+                TransformRotation(-180.0f, glm::vec3(0,1,0)),
+                TransformScale(glm::vec3(0.5f))
+            );
+
+            staticObjects.push_back(addObject(cupModel.get(), phongTexturedShader.get(), cupTransform, nullptr));
+
+            holes.push_back({pos, -1});
+        }
+    }
+}
 
-            int cupIndex = objects.size();
-            addObject(cupModel.get(), phongTexturedShader.get(), cupTransform, nullptr);
+void WhackAMoleScene::initializePools() {
+    enemies.reserve(holes.size());
+    for (size_t i = 0; i < holes.size(); ++i) {
+        auto t = std::make_shared<EnemyTransform>(
+            TransformTranslation(glm::vec3(0.0f)),
+            TransformLinear(glm::vec3(0.0f), glm::vec3(0.0f)),
+            TransformScale(glm::vec3(1.0f))
+        );
+        ObjectHandle object = addObject(shroomModel.get(), phongTexturedShader.get(), t, shroomTexture.get());
+        setLayers(object, 0);
+        getObject(object)->pickId = static_cast<uint8_t>(i + 1);
+        enemies.push_back({EnemyType::MUSHROOM, object, glm::vec3(0.0f), 0.0f, false, false, 0.0f, false, false, t,
+                           0.0f, MOVE_DURATION});
+    }
 
-            holes.push_back({pos, cupIndex, -1});
-        }
+    hammers.reserve(HAMMER_POOL_SIZE);
+    for (int i = 0; i < HAMMER_POOL_SIZE; ++i) {
+        auto t = std::make_shared<HammerTransform>(
+            TransformTranslation(glm::vec3(0.0f)),
+            TransformTranslation(glm::vec3(1, 3.5f, -0.7f)),
+            TransformRotation(-45, glm::vec3(0, 0, 1)),
+            TransformScale(glm::vec3(0.2f))
+        );
+        ObjectHandle object = addObject(hammerModel.get(), phongTexturedShader.get(), t, hammerTexture.get());
+        setLayers(object, 0);
+        hammers.push_back({object, t, 0.0f, false});
     }
 }
 
 void WhackAMoleScene::spawnEnemy() {
     if (enemiesSpawned >= MAX_ENEMIES) return;
-    std::vector<int> freeHoles;
-    for (int i = 0; i < holes.size(); i++) if (holes[i].activeEnemyIdx == -1) freeHoles.push_back(i);
-    if (freeHoles.empty()) return;
-    int holeIdx = freeHoles[holeDistrib(rng) % freeHoles.size()];
+    int freeHoles[6];
+    int freeCount = 0;
+    for (int i = 0; i < holes.size() && freeCount < 6; i++) if (holes[i].activeEnemyIdx == -1) freeHoles[freeCount++] = i;
+    if (freeCount == 0) return;
+    int holeIdx = freeHoles[holeDistrib(rng) % freeCount];
+
+    int idx = -1;
+    for (int i = 0; i < enemies.size(); i++) {
+        if (!enemies[i].isAlive) {
+            idx = i;
+            break;
+        }
+    }
+    if (idx < 0) return;
 
     EnemyType type = static_cast<EnemyType>(enemyTypeDistrib(rng));
     Model* enemyModel = nullptr;
@@ -122,18 +198,28 @@ void WhackAMoleScene::spawnEnemy() {
     pos.x += 3.0f;
     pos.z += 1.0f;
 
-    auto t = std::make_shared<TransformComposite>();
-    if (type == EnemyType::MUSHROOM) t->add(std::make_shared<TransformTranslation>(glm::vec3(3,0,1)));
-    t->add(std::make_shared<TransformTranslation>(pos));
-    t->add(std::make_shared<TransformScale>(glm::vec3(scaleValue)));
-
-    int objIndex = objects.size();
-    addObject(enemyModel, phongTexturedShader.get(), t, enemyTexture);
-
-    int idx = enemies.size();
-    auto moveTransform = std::make_shared<TransformLinear>(pos, pos, 0.0f);
-    
-    enemies.push_back({type, objIndex, pos, gameTime, true, false, 0, false, false, moveTransform, 0, MOVE_DURATION});
+    Enemy& e = enemies[idx];
+    e.transform->get<0>().setOffset(type == EnemyType::MUSHROOM ? glm::vec3(3, 0, 1) : glm::vec3(0.0f));
+    e.transform->get<1>().setStartPoint(pos);
+    e.transform->get<1>().setEndPoint(pos);
+    e.transform->get<1>().setParam(0.0f);
+    e.transform->get<2>().setScale(glm::vec3(scaleValue));
+
+    DrawableObject* obj = getObject(e.object);
+    obj->model = enemyModel;
+    obj->texture = enemyTexture;
+    setLayers(e.object, RenderLayer::PICKABLE);
+
+    e.type = type;
+    e.position = pos;
+    e.spawnTime = gameTime;
+    e.isAlive = true;
+    e.isSquished = false;
+    e.squishTime = 0.0f;
+    e.hasMoved = false;
+    e.isMoving = false;
+    e.moveStartTime = 0.0f;
+    e.moveDuration = MOVE_DURATION;
     holes[holeIdx].activeEnemyIdx = idx;
     enemiesSpawned++;
 }
@@ -147,19 +233,20 @@ void WhackAMoleScene::tryMoveEnemy(int i) {
     for (int h = 0; h < holes.size(); h++) if (holes[h].activeEnemyIdx == i) fromHole = h;
     if (fromHole == -1) return;
 
-    std::vector<int> adjacentHoles;
     int row = fromHole / 3;
     int col = fromHole % 3;
-    
-    if (col > 0) adjacentHoles.push_back(fromHole - 1);
-    if (col < 2) adjacentHoles.push_back(fromHole + 1);
-    if (row > 0) adjacentHoles.push_back(fromHole - 3);
-    if (row < 1) adjacentHoles.push_back(fromHole + 3);
-
-    std::vector<int> freeAdjacent;
-    for (int adj : adjacentHoles) if (holes[adj].activeEnemyIdx == -1) freeAdjacent.push_back(adj);
-    if (freeAdjacent.empty()) return;
-    int toHole = freeAdjacent[std::uniform_int_distribution<>(0, freeAdjacent.size() - 1)(rng)];
+    int freeAdjacent[4];
+    int freeCount = 0;
+    auto consider = [&](int adj) {
+        if (holes[adj].activeEnemyIdx == -1) freeAdjacent[freeCount++] = adj;
+    };
+    if (col > 0) consider(fromHole - 1);
+    if (col < 2) consider(fromHole + 1);
+    if (row > 0) consider(fromHole - 3);
+    if (row < 1) consider(fromHole + 3);
+
+    if (freeCount == 0) return;
+    int toHole = freeAdjacent[std::uniform_int_distribution<>(0, freeCount - 1)(rng)];
     startEnemyMov(i, fromHole, toHole);
 }
 
@@ -177,9 +264,10 @@ void WhackAMoleScene::startEnemyMov(int idx, int fromHole, int toHole) {
     dest.x += 3.0f;
     dest.z += 1.0f;
     
-    e.moveTransform->setStartPoint(startPos);
-    e.moveTransform->setEndPoint(dest);
-    e.moveTransform->setParam(0.0f);
+    TransformLinear& path = e.transform->get<1>();
+    path.setStartPoint(startPos);
+    path.setEndPoint(dest);
+    path.setParam(0.0f);
 
     e.moveStartTime = gameTime;
 }
@@ -197,17 +285,9 @@ void WhackAMoleScene::updateEnemies(float dt) {
                 t = 1.0f;
                 e.isMoving = false;
             }
-            e.moveTransform->setParam(t);
-            e.position = e.moveTransform->getPosOnPath();
-
-            auto tr = std::make_shared<TransformComposite>();
-            if (e.type == EnemyType::MUSHROOM) tr->add(std::make_shared<TransformTranslation>(glm::vec3(3,0,1)));
-            tr->add(e.moveTransform);
-
-            float scale = (e.type == EnemyType::MUSHROOM ? 0.05f : 2.0f);
-            tr->add(std::make_shared<TransformScale>(glm::vec3(scale)));
-
-            objects[e.objectIndex].transform = tr;
+            TransformLinear& path = e.transform->get<1>();
+            path.setParam(t);
+            e.position = path.getPosOnPath();
             continue;
         }
 
@@ -216,20 +296,18 @@ void WhackAMoleScene::updateEnemies(float dt) {
             float p = (gameTime - e.squishTime) / SQUISH_DURATION;
             if (p >= 1.0f) {
                 e.isAlive = false;
+                setLayers(e.object, 0);
                 for (auto& h : holes)
                     if (h.activeEnemyIdx == i)
                         h.activeEnemyIdx = -1;
             } else {
                 float scale = (e.type == EnemyType::MUSHROOM ? 0.05f : 2.0f);
                 float ys = 1.0f - 0.8f * p;
-                auto tr = std::make_shared<TransformComposite>();
-                if (e.type == EnemyType::MUSHROOM) tr->add(std::make_shared<TransformTranslation>(glm::vec3(3,0,1)));
-                tr->add(std::make_shared<TransformTranslation>(e.position));
-                tr->add(std::make_shared<TransformScale>(glm::vec3(scale, scale * ys, scale)));
-                objects[e.objectIndex].transform = tr;
+                e.transform->get<2>().setScale(glm::vec3(scale, scale * ys, scale));
             }
         } else if (alive >= ENEMY_LIFETIME) {
             e.isAlive = false;
+            setLayers(e.object, 0);
             for (auto& h : holes)
                 if (h.activeEnemyIdx == i)
                     h.activeEnemyIdx = -1;
@@ -238,21 +316,11 @@ void WhackAMoleScene::updateEnemies(float dt) {
 }
 
 void WhackAMoleScene::updateHammers(float dt) {
-    for (auto it = activeHammers.begin(); it != activeHammers.end();) {
-        float age = gameTime - it->spawnTime;
-        if (age >= HAMMER_LIFETIME) {
-            int idx = it->objectIndex;
-            if (idx < objects.size()) {
-                objects.erase(objects.begin() + idx);
-                for (auto& e : enemies)
-                    if (e.objectIndex > idx) e.objectIndex--;
-                for (auto& h : holes)
-                    if (h.cupObjIdx > idx) h.cupObjIdx--;
-                for (auto& he : activeHammers)
-                    if (he.objectIndex > idx) he.objectIndex--;
-            }
-            it = activeHammers.erase(it);
-        } else ++it;
+    for (auto& hammer : hammers) {
+        if (hammer.active && gameTime - hammer.spawnTime >= HAMMER_LIFETIME) {
+            hammer.active = false;
+            setLayers(hammer.object, 0);
+        }
     }
 }
 
@@ -260,6 +328,7 @@ void WhackAMoleScene::update(float dt) {
     gameTime += dt;
     updateEnemies(dt);
     updateHammers(dt);
+    sparks->update(*particleUpdateShader, gameTime, dt);
 
     if (gameTime >= nextSpawnTime && enemiesSpawned < MAX_ENEMIES) {
         spawnEnemy();
@@ -308,17 +377,22 @@ void WhackAMoleScene::hitEnemy(int idx, const glm::vec3& hitPos) {
 
     score += pts;
     spawnHammer(hitPos);
+    sparks->emitBurst(hitPos, 64, 4.0f, 0.8f);
 }
 
 void WhackAMoleScene::spawnHammer(const glm::vec3& pos) {
-    auto t = std::make_shared<TransformComposite>();
-    t->add(std::make_shared<TransformTranslation>(pos));
-    t->add(std::make_shared<TransformTranslation>(glm::vec3(1,3.5f,-0.7f)));
-    t->add(std::make_shared<TransformRotation>(-45, glm::vec3(0,0,1)));
-    t->add(std::make_shared<TransformScale>(glm::vec3(0.2f)));
-    int idx = objects.size();
-    addObject(hammerModel.get(), phongTexturedShader.get(), t, hammerTexture.get());
-    activeHammers.push_back({idx, gameTime, pos});
+    HammerEffect* slot = &hammers[0];
+    for (auto& hammer : hammers) {
+        if (!hammer.active) {
+            slot = &hammer;
+            break;
+        }
+        if (hammer.spawnTime < slot->spawnTime) slot = &hammer;
+    }
+    slot->transform->get<0>().setOffset(pos);
+    slot->spawnTime = gameTime;
+    slot->active = true;
+    setLayers(slot->object, RenderLayer::OPAQUE);
 }
 
 void WhackAMoleScene::handleMouseClick(double xpos, double ypos, int W, int H) {
@@ -334,22 +408,7 @@ void WhackAMoleScene::updateMouseHover(double xpos, double ypos, int W, int H) {
 }
 
 void WhackAMoleScene::draw() {
-    glEnable(GL_STENCIL_TEST);// non-enemy objects stencil value 0
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    glStencilFunc(GL_ALWAYS, 0, 0xFF);
-    glStencilMask(0xFF);
-    
-    for (int i = 0; i < objects.size(); i++) {
-        bool skipObject = false;
-        for (auto& e : enemies) {
-            if (i == e.objectIndex) {
-                skipObject = true;
-                break;
-            }
-        }
-        if (skipObject) continue;
-
-        auto& obj = objects[i];
+    auto drawObject = [](const DrawableObject& obj) {
         obj.shader->use();
 
         if (obj.texture) {
@@ -363,33 +422,20 @@ void WhackAMoleScene::draw() {
         obj.model->draw(GL_TRIANGLES);
 
         if (obj.texture) obj.texture->unbind();
-    }
-    
-    for (int i = 0; i < enemies.size(); i++) {
-        auto& e = enemies[i];
-        if (!e.isAlive) continue;
-        
-        glStencilFunc(GL_ALWAYS, i + 1, 0xFF);
-        
-        auto& obj = objects[e.objectIndex];
-        obj.shader->use();
+    };
 
-        if (obj.texture) {
-            obj.texture->bind(0);
-            obj.shader->SetUniform("textureSampler", 0);
-            obj.shader->SetUniform("useTexture", true);
-        } else obj.shader->SetUniform("useTexture", false);
-
-        glm::mat4 model = obj.transform->getMatrix();
-        obj.shader->SetUniform("model", model);
-        obj.model->draw(GL_TRIANGLES);
-
-        if (obj.texture) obj.texture->unbind();
-    }
+    for (uint32_t idx : layerMembers(RenderLayer::OPAQUE)) drawObject(objects[idx]);
+    // live enemies, dead ones already gave their objects back
+    for (uint32_t idx : layerMembers(RenderLayer::PICKABLE)) drawObject(objects[idx]);
     
-    glStencilMask(0x00);
-    glDisable(GL_STENCIL_TEST);
     glUseProgram(0);
+
+    if (attachedCamera) {
+        sparks->draw(*particleShader, attachedCamera->getViewMat(), attachedCamera->getProjMat(),
+                     static_cast<float>(attachedCamera->getResolution().y), gameTime);
+    }
+
+    writeStencilIds();
 }
 
 void WhackAMoleScene::attachToCamera(Camera* camera) {
@@ -401,6 +447,10 @@ void WhackAMoleScene::detachFromCamera(Camera* camera) {
     detachFromCameraImpl(camera);
 }
 
+void WhackAMoleScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
+}
+
 void WhackAMoleScene::setupCamera() {
     if (!attachedCamera) return;
     attachedCamera->setPosition(glm::vec3(0,17,8));
@@ -1,5 +1,6 @@
 #pragma once
 #include "BaseScene.hpp"
+#include "../renderers/Particles.hpp"
 #include <memory>
 #include <vector>
 #include <random>
@@ -11,6 +12,7 @@ public:
     void draw() override;
     void attachToCamera(Camera* camera) override;
     void detachFromCamera(Camera* camera) override;
+    void declareAssets(AssetManifest& assets) const override;
     void setupCamera();
     void handleMouseClick(double xpos, double ypos, int width, int height);
     void updateMouseHover(double xpos, double ypos, int width, int height);
@@ -24,9 +26,15 @@ private:
         MUSHROOM
     };
 
+    // model pivot offset, path between holes and scale, all updated in place
+    using EnemyTransform = StaticComposite<TransformTranslation, TransformLinear, TransformScale>;
+    using HammerTransform = StaticComposite<TransformTranslation, TransformTranslation, TransformRotation, TransformScale>;
+
+    // one preallocated slot per hole, a dead enemy's object stays in the
+    // scene with no render layers until the slot is reused
     struct Enemy {
         EnemyType type;
-        int objectIndex;
+        ObjectHandle object;
         glm::vec3 position;
         float spawnTime;
         bool isAlive;
@@ -34,24 +42,28 @@ private:
         float squishTime;
         bool hasMoved;
         bool isMoving;
-        std::shared_ptr<TransformLinear> moveTransform;
+        std::shared_ptr<EnemyTransform> transform;
         float moveStartTime;
         float moveDuration;
     };
 
     struct HolePosition {
         glm::vec3 position;
-        int cupObjIdx;
         int activeEnemyIdx;
     };
 
     struct HammerEffect {
-        int objectIndex;
+        ObjectHandle object;
+        std::shared_ptr<HammerTransform> transform;
         float spawnTime;
-        glm::vec3 position;
+        bool active;
     };
 
     std::unique_ptr<Shader> phongTexturedShader;
+    std::unique_ptr<Shader> particleUpdateShader;
+    std::unique_ptr<Shader> particleShader;
+    // thrown off every hit, simulated on the GPU
+    std::unique_ptr<ParticleSystem> sparks;
 
     std::unique_ptr<Model> cupModel;
     std::unique_ptr<Model> shrekModel;
@@ -69,7 +81,7 @@ private:
     std::vector<std::unique_ptr<Light>> lights;
     std::vector<HolePosition> holes;
     std::vector<Enemy> enemies;
-    std::vector<HammerEffect> activeHammers;
+    std::vector<HammerEffect> hammers;
 
     int score;
     int enemiesSpawned;
@@ -86,10 +98,13 @@ private:
     const int MAX_ENEMIES = 20;
     const float ENEMY_LIFETIME = 3.0f;
     const float HAMMER_LIFETIME = 0.2f;
+    // hammers alive at once, the oldest one is reused when they run out
+    static constexpr int HAMMER_POOL_SIZE = 4;
     const float SQUISH_DURATION = 0.3f;
     const float MOVE_DURATION = 0.6f;
 
-    void initializeHoles();
+    void initializeHoles(std::vector<ObjectHandle>& staticObjects);
+    void initializePools();
     void spawnEnemy();
     void updateEnemies(float deltaTime);
     void updateHammers(float deltaTime);
@@ -0,0 +1,137 @@
+#include "WorldScene.hpp"
+#include "../world/WorldBuilder.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace {
+const char* WORLD_DIRECTORY = "world_cache/terrain";
+AssetManifest SCENE_ASSETS;
+const std::string VERTEX_SHADER = SCENE_ASSETS.shader("src/shaders/vertex.glsl");
+const std::string VERTEX_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/vertex_textured.glsl");
+const std::string MULT_LAMBERT_SHADER = SCENE_ASSETS.shader("src/shaders/mult_lambert.glsl");
+const std::string MULT_PHONG_TEXTURED_SHADER = SCENE_ASSETS.shader("src/shaders/mult_phong_textured.glsl");
+const std::string GRASS_TEXTURE = SCENE_ASSETS.texture("src/images/swamp.png");
+// only read when the world cache has to be built first
+AssetManifest BUILD_ASSETS;
+const ModelFile TERRAIN_MODEL = BUILD_ASSETS.model("src/objects/teren.obj", ModelType::UV);
+// the terrain mesh is laid out TERRAIN_TILES x TERRAIN_TILES times, every
+// other tile mirrored so the edges meet
+const int TERRAIN_TILES = 8;
+const float TILE_SIZE = 64.0f;
+const float CHUNK_SIZE = 32.0f;
+const uint32_t WORLD_SEED = 4242;
+const glm::vec3 BUSH_COLOR(0.05f, 0.25f, 0.05f);
+const glm::vec3 TREE_COLOR(0.15f, 0.1f, 0.05f);
+}
+
+void WorldScene::init() {
+    std::string vertexSrc = loadShaderSrc(VERTEX_SHADER);
+    std::string vertexTexturedSrc = loadShaderSrc(VERTEX_TEXTURED_SHADER);
+    std::string fragLambertSrc = loadShaderSrc(MULT_LAMBERT_SHADER);
+    std::string fragPhongTexturedSrc = loadShaderSrc(MULT_PHONG_TEXTURED_SHADER);
+    terrainShader = std::make_unique<Shader>(vertexTexturedSrc.c_str(), fragPhongTexturedSrc.c_str());
+    propShader = std::make_unique<Shader>(vertexSrc.c_str(), fragLambertSrc.c_str());
+
+    bushModel = ModelFactory::CreateBush();
+    treeModel = ModelFactory::CreateTree();
+    grassTexture = std::make_unique<Texture>(GRASS_TEXTURE);
+
+    sun = std::make_unique<Light>(glm::vec3(-0.3f, -1.0f, -0.2f), glm::vec3(1.0f), LightType::DIRECTIONAL);
+    sun->setAmbient(0.25f);
+    sun->setDiffuse(0.8f);
+    sun->setSpecular(0.1f);
+    for (Shader* shader : {terrainShader.get(), propShader.get()}) {
+        shader->addLight(sun.get());
+        sun->attach(shader);
+        shader->use();
+        shader->updateAllLights();
+    }
+    glUseProgram(0);
+
+    WorldInfo existing;
+    if (!ChunkFile::readInfo(WORLD_DIRECTORY, existing) && !buildWorld(WORLD_DIRECTORY)) {
+        std::cerr << "World scene has nothing to stream!!!" << std::endl;
+    }
+
+    WorldStreamer::Settings settings;
+    streamer = std::make_unique<WorldStreamer>(WORLD_DIRECTORY, settings);
+    streamer->setTerrain(terrainShader.get(), grassTexture.get());
+    streamer->addPaletteEntry(bushModel.get(), propShader.get(), BUSH_COLOR);
+    streamer->addPaletteEntry(treeModel.get(), propShader.get(), TREE_COLOR);
+}
+
+bool WorldScene::buildWorld(const std::string& directory) {
+    std::vector<float> triangles;
+    int stride = 0;
+    auto mesh = AssetCache::instance().takeMesh(TERRAIN_MODEL.first, TERRAIN_MODEL.second);
+    if (mesh) {
+        triangles = std::move(mesh->vertices);
+        stride = mesh->stride;
+    } else if (!Model::ReadMeshFile(TERRAIN_MODEL.first, TERRAIN_MODEL.second, triangles, stride)) {
+        return false;
+    }
+
+    Aabb bounds;
+    for (size_t i = 0; i + 2 < triangles.size(); i += stride) {
+        bounds.expand(glm::vec3(triangles[i], triangles[i + 1], triangles[i + 2]));
+    }
+    glm::vec3 extent = bounds.max - bounds.min;
+    float scale = TILE_SIZE / std::max(std::max(extent.x, extent.z), 1e-3f);
+
+    WorldBuilder builder(CHUNK_SIZE);
+    for (int tz = 0; tz < TERRAIN_TILES; ++tz) {
+        for (int tx = 0; tx < TERRAIN_TILES; ++tx) {
+            glm::vec3 tileCenter((tx - TERRAIN_TILES / 2 + 0.5f) * TILE_SIZE, 0.0f,
+                                 (tz - TERRAIN_TILES / 2 + 0.5f) * TILE_SIZE);
+            glm::vec3 mirror(tx % 2 ? -1.0f : 1.0f, 1.0f, tz % 2 ? -1.0f : 1.0f);
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), tileCenter) *
+                                  glm::scale(glm::mat4(1.0f), mirror * scale) *
+                                  glm::translate(glm::mat4(1.0f), -glm::vec3(bounds.center().x, bounds.min.y,
+                                                                             bounds.center().z));
+            builder.addTerrain(triangles, stride, transform);
+        }
+    }
+    builder.addScatter(0, 0.01f, 0.3f, 0.8f, WORLD_SEED);
+    builder.addScatter(1, 0.005f, 0.5f, 1.2f, WORLD_SEED + 1);
+
+    std::cout << "Building streamed world into " << directory << " (" << builder.getChunkCount() << " chunks)"
+              << std::endl;
+    return builder.write(directory, workers);
+}
+
+void WorldScene::update(float deltaTime) {
+    if (!streamer || !attachedCamera) return;
+    streamer->update(attachedCamera->getPosition(), attachedCamera->getFront(), deltaTime);
+}
+
+void WorldScene::printStats() const {
+    BaseScene::printStats();
+    if (!streamer) return;
+    std::cout << "World chunks resident: " << streamer->getResidentCount() << ", "
+              << streamer->getResidentBytes() / 1024 << " KiB" << std::endl;
+}
+
+void WorldScene::draw() {
+    if (!streamer || !attachedCamera) return;
+    streamer->draw(Frustum(attachedCamera->getProjMat() * attachedCamera->getViewMat()));
+}
+
+void WorldScene::attachToCamera(Camera* camera) {
+    camera->attach(terrainShader.get());
+    camera->attach(propShader.get());
+    attachToCameraImpl(camera);
+}
+
+void WorldScene::detachFromCamera(Camera* camera) {
+    camera->detach(terrainShader.get());
+    camera->detach(propShader.get());
+    detachFromCameraImpl(camera);
+}
+
+void WorldScene::declareAssets(AssetManifest& assets) const {
+    assets = SCENE_ASSETS;
+    WorldInfo existing;
+    if (!ChunkFile::readInfo(WORLD_DIRECTORY, existing)) assets.append(BUILD_ASSETS);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "BaseScene.hpp"
+#include "../world/WorldStreamer.hpp"
+#include <memory>
+#include <vector>
+
+// a terrain much bigger than the camera ever sees at once, streamed in
+// chunks from a world built into world_cache/ on first use
+class WorldScene : public BaseScene {
+public:
+    void init() override;
+    void draw() override;
+    void attachToCamera(Camera* camera) override;
+    void detachFromCamera(Camera* camera) override;
+    void declareAssets(AssetManifest& assets) const override;
+    void update(float deltaTime);
+    void printStats() const override;
+
+private:
+    std::unique_ptr<Shader> terrainShader;
+    std::unique_ptr<Shader> propShader;
+
+    std::unique_ptr<Model> bushModel;
+    std::unique_ptr<Model> treeModel;
+
+    std::unique_ptr<Texture> grassTexture;
+    std::unique_ptr<Light> sun;
+
+    std::unique_ptr<WorldStreamer> streamer;
+
+    bool buildWorld(const std::string& directory);
+};
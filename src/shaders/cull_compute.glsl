@@ -0,0 +1,117 @@
+#version 430 core
+layout(local_size_x = 64) in;
+
+struct DrawData {
+    mat4 model;
+    mat4 normal;
+    vec4 material;
+    ivec4 info;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+struct Bounds {
+    vec4 minCorner;
+    vec4 maxCorner;
+};
+
+layout(std430, binding = 0) readonly buffer DrawTable {
+    DrawData draws[];
+};
+layout(std430, binding = 1) readonly buffer BoundsTable {
+    Bounds bounds[];
+};
+// 1 for draws that ended up visible last frame
+layout(std430, binding = 2) buffer Visibility {
+    uint visible[];
+};
+layout(std430, binding = 3) readonly buffer SourceCommands {
+    DrawCommand commands[];
+};
+layout(std430, binding = 4) writeonly buffer CulledCommands {
+    DrawCommand culled[];
+};
+
+uniform uint drawCount;
+uniform int phase;
+uniform mat4 viewProj;
+uniform vec4 frustumPlanes[6];
+uniform sampler2D hiz;
+uniform vec2 hizSize;
+uniform int hizLevels;
+
+bool insideFrustum(vec3 lo, vec3 hi) {
+    vec3 c = (lo + hi) * 0.5;
+    vec3 e = (hi - lo) * 0.5;
+    for (int i = 0; i < 6; ++i) {
+        vec4 p = frustumPlanes[i];
+        if (dot(p.xyz, c) + dot(abs(p.xyz), e) + p.w < 0.0) return false;
+    }
+    return true;
+}
+
+bool occluded(vec3 lo, vec3 hi) {
+    vec2 rectMin = vec2(1.0);
+    vec2 rectMax = vec2(0.0);
+    float nearest = 1.0;
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = vec3((i & 1) != 0 ? hi.x : lo.x, (i & 2) != 0 ? hi.y : lo.y, (i & 4) != 0 ? hi.z : lo.z);
+        vec4 clip = viewProj * vec4(corner, 1.0);
+        if (clip.w <= 0.0) return false;
+        vec3 ndc = clip.xyz / clip.w;
+        rectMin = min(rectMin, ndc.xy * 0.5 + 0.5);
+        rectMax = max(rectMax, ndc.xy * 0.5 + 0.5);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+    rectMin = clamp(rectMin, 0.0, 1.0);
+    rectMax = clamp(rectMax, 0.0, 1.0);
+
+    // the level where the rectangle spans at most two texels each way
+    vec2 pixels = (rectMax - rectMin) * hizSize;
+    float lod = clamp(ceil(log2(max(max(pixels.x, pixels.y), 1.0))), 0.0, float(hizLevels - 1));
+    float farthest = max(max(textureLod(hiz, rectMin, lod).r, textureLod(hiz, vec2(rectMax.x, rectMin.y), lod).r),
+                         max(textureLod(hiz, vec2(rectMin.x, rectMax.y), lod).r, textureLod(hiz, rectMax, lod).r));
+    return nearest > farthest;
+}
+
+void main() {
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= drawCount) return;
+
+    DrawCommand cmd = commands[id];
+    uint drawIndex = cmd.baseInstance;
+    mat4 model = draws[drawIndex].model;
+
+    // world bounds, positions divided by w like the vertex shaders do
+    vec3 lo = vec3(1e30);
+    vec3 hi = vec3(-1e30);
+    Bounds b = bounds[drawIndex];
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = vec3((i & 1) != 0 ? b.maxCorner.x : b.minCorner.x,
+                           (i & 2) != 0 ? b.maxCorner.y : b.minCorner.y,
+                           (i & 4) != 0 ? b.maxCorner.z : b.minCorner.z);
+        vec4 p = model * vec4(corner, 1.0);
+        lo = min(lo, p.xyz / p.w);
+        hi = max(hi, p.xyz / p.w);
+    }
+
+    bool inFrustum = insideFrustum(lo, hi);
+    bool wasVisible = visible[drawIndex] != 0u;
+
+    if (phase == 0) {
+        // last frame's survivors, they build the depth the pyramid comes from
+        cmd.instanceCount = (wasVisible && inFrustum) ? 1u : 0u;
+    } else {
+        bool nowVisible = inFrustum && !occluded(lo, hi);
+        visible[drawIndex] = nowVisible ? 1u : 0u;
+        // whatever phase 0 already drew is skipped
+        cmd.instanceCount = (nowVisible && !(wasVisible && inFrustum)) ? 1u : 0u;
+    }
+    culled[id] = cmd;
+}
@@ -0,0 +1,43 @@
+#version 430 core
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// level 0 copies the depth buffer, every other level keeps the farthest
+// depth of the 2x2 (up to 3x3 for odd sizes) texels above it
+uniform int level;
+uniform sampler2D depthSource;
+uniform ivec2 srcSize;
+uniform ivec2 dstSize;
+
+layout(r32f, binding = 0) uniform readonly image2D srcLevel;
+layout(r32f, binding = 1) uniform writeonly image2D dstLevel;
+
+float farthest(ivec2 p) {
+    return imageLoad(srcLevel, min(p, srcSize - 1)).r;
+}
+
+void main() {
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, dstSize))) return;
+
+    float d;
+    if (level == 0) {
+        d = texelFetch(depthSource, p, 0).r;
+    } else {
+        ivec2 s = p * 2;
+        d = max(max(farthest(s), farthest(s + ivec2(1, 0))),
+                max(farthest(s + ivec2(0, 1)), farthest(s + ivec2(1, 1))));
+
+        bool extraX = (srcSize.x & 1) != 0 && p.x == dstSize.x - 1;
+        bool extraY = (srcSize.y & 1) != 0 && p.y == dstSize.y - 1;
+        if (extraX) {
+            d = max(d, max(farthest(s + ivec2(2, 0)), farthest(s + ivec2(2, 1))));
+        }
+        if (extraY) {
+            d = max(d, max(farthest(s + ivec2(0, 2)), farthest(s + ivec2(1, 2))));
+        }
+        if (extraX && extraY) {
+            d = max(d, farthest(s + ivec2(2, 2)));
+        }
+    }
+    imageStore(dstLevel, p, vec4(d));
+}
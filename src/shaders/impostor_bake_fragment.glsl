@@ -0,0 +1,19 @@
+#version 330 core
+uniform sampler2D textureSampler;
+uniform bool useTexture;
+uniform float radius;
+uniform float centerDepth;
+
+in vec3 Normal;
+in vec2 TexCoords;
+in float ViewDepth;
+
+layout(location = 0) out vec4 albedo;
+layout(location = 1) out vec4 normalDepth;
+
+void main() {
+    albedo = vec4(useTexture ? texture(textureSampler, TexCoords).rgb : vec3(1.0), 1.0);
+    // how far the surface stands out of the plane through the center, in radii
+    float depth = (ViewDepth - centerDepth) / radius;
+    normalDepth = vec4(normalize(Normal) * 0.5 + 0.5, clamp(depth * 0.5 + 0.5, 0.0, 1.0));
+}
@@ -0,0 +1,20 @@
+#version 330 core
+layout(location = 0) in vec3 vertPos;
+layout(location = 1) in vec3 vertNormal;
+layout(location = 2) in vec2 vertTexCoords;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 Normal;
+out vec2 TexCoords;
+out float ViewDepth;
+
+void main() {
+    vec4 viewPos = view * vec4(vertPos, 1.0);
+    // object space, the runtime turns it with the instance
+    Normal = vertNormal;
+    TexCoords = vertTexCoords;
+    ViewDepth = viewPos.z;
+    gl_Position = projection * viewPos;
+}
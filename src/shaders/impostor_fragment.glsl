@@ -0,0 +1,121 @@
+#version 330 core
+
+struct Light {
+    vec3 position;
+    vec3 direction;
+    vec3 color;
+    float ambient;
+    float diffuse;
+    int type; // 0: POINT, 1: DIRECTIONAL, 2: REFLECTOR
+    float cutOff;
+    float outerCutOff;
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+#define MAX_LIGHTS 10
+uniform Light lights[MAX_LIGHTS];
+uniform int numLights;
+
+uniform sampler2D albedoAtlas;
+uniform sampler2D normalDepthAtlas;
+uniform int frames;
+uniform mat4 view;
+uniform mat4 projection;
+
+in vec3 FragPos;
+in vec2 QuadUV;
+flat in vec3 ToCamera;
+flat in vec3 Color;
+flat in float Yaw;
+flat in float Radius;
+flat in vec4 FramesA;
+flat in vec4 FramesB;
+flat in vec4 Weights;
+
+out vec4 fragColor;
+
+// lambert like the vegetation meshes, at the surface point the depth atlas
+// puts behind the quad
+vec3 SurfacePos;
+
+vec3 calcPointLight(Light light, vec3 norm) {
+    vec3 lightDir = normalize(light.position - SurfacePos);
+    float distance = length(light.position - SurfacePos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    
+    float diff = max(dot(norm, lightDir), 0.0);
+    
+    vec3 ambient = light.ambient * light.color;
+    vec3 diffuse = light.diffuse * diff * light.color;
+    
+    return (ambient + diffuse) * attenuation;
+}
+
+vec3 calcDirectionalLight(Light light, vec3 norm) {
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(norm, lightDir), 0.0);
+    
+    vec3 ambient = light.ambient * light.color;
+    vec3 diffuse = light.diffuse * diff * light.color;
+    
+    return ambient + diffuse;
+}
+
+vec3 calcReflLight(Light light, vec3 norm) {
+    vec3 lightDir = normalize(light.position - SurfacePos);
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    
+    float distance = length(light.position - SurfacePos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    
+    float diff = max(dot(norm, lightDir), 0.0);
+    
+    vec3 ambient = light.ambient * light.color;
+    vec3 diffuse = light.diffuse * diff * light.color;
+    
+    return (ambient + diffuse) * attenuation * intensity;
+}
+
+void main() {
+    vec2 frame[4] = vec2[4](FramesA.xy, FramesA.zw, FramesB.xy, FramesB.zw);
+    vec4 albedo = vec4(0.0);
+    vec4 normalDepth = vec4(0.0);
+    for (int i = 0; i < 4; i++) {
+        vec2 uv = (frame[i] + QuadUV) / float(frames);
+        vec4 a = texture(albedoAtlas, uv);
+        // empty texels of a view don't drag the others' normals and depth
+        albedo += Weights[i] * a;
+        normalDepth += Weights[i] * a.a * texture(normalDepthAtlas, uv);
+    }
+    if (albedo.a < 0.5) discard;
+    normalDepth /= albedo.a;
+
+    vec3 n = normalDepth.rgb * 2.0 - 1.0;
+    float c = cos(Yaw);
+    float s = sin(Yaw);
+    vec3 norm = normalize(vec3(c * n.x + s * n.z, n.y, -s * n.x + c * n.z));
+
+    SurfacePos = FragPos + ToCamera * (normalDepth.a * 2.0 - 1.0) * Radius;
+    vec4 clip = projection * view * vec4(SurfacePos, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    vec3 result = vec3(0.0);
+    if (numLights == 0) {
+        result = vec3(0.3);
+    }
+    for (int i = 0; i < numLights && i < MAX_LIGHTS; i++) {
+        if (lights[i].type == 0) {
+            result += calcPointLight(lights[i], norm);
+        } else if (lights[i].type == 1) {
+            result += calcDirectionalLight(lights[i], norm);
+        } else if (lights[i].type == 2) {
+            result += calcReflLight(lights[i], norm);
+        }
+    }
+
+    fragColor = vec4(result * Color * albedo.rgb / albedo.a, 1.0);
+}
@@ -0,0 +1,56 @@
+#version 330 core
+layout(location = 0) in vec2 corner;
+// world space bounding sphere of the instance
+layout(location = 1) in vec4 instanceSphere;
+// color and yaw in radians
+layout(location = 2) in vec4 instanceColorYaw;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+uniform int frames;
+
+out vec3 FragPos;
+out vec2 QuadUV;
+flat out vec3 ToCamera;
+flat out vec3 Color;
+flat out float Yaw;
+flat out float Radius;
+// the four nearest views, two per vector, and their weights
+flat out vec4 FramesA;
+flat out vec4 FramesB;
+flat out vec4 Weights;
+
+void main() {
+    vec3 center = instanceSphere.xyz;
+    float radius = instanceSphere.w;
+    float yaw = instanceColorYaw.w;
+
+    vec3 toCamera = normalize(viewPos - center);
+    // into the model's frame, the views were baked unrotated and from above
+    float c = cos(yaw);
+    float s = sin(yaw);
+    vec3 local = vec3(c * toCamera.x - s * toCamera.z, max(toCamera.y, 0.0), s * toCamera.x + c * toCamera.z);
+    local /= abs(local.x) + abs(local.y) + abs(local.z);
+    vec2 grid = vec2(local.x + local.z, local.x - local.z) * 0.5 + 0.5;
+
+    vec2 g = grid * float(frames - 1);
+    vec2 f0 = min(floor(g), vec2(frames - 2));
+    vec2 w = g - f0;
+    FramesA = vec4(f0, f0 + vec2(1.0, 0.0));
+    FramesB = vec4(f0 + vec2(0.0, 1.0), f0 + vec2(1.0));
+    Weights = vec4((1.0 - w.x) * (1.0 - w.y), w.x * (1.0 - w.y), (1.0 - w.x) * w.y, w.x * w.y);
+
+    // same basis the views were baked with
+    vec3 up = abs(toCamera.y) > 0.999 ? vec3(0.0, 0.0, -1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up, toCamera));
+    up = cross(toCamera, right);
+
+    FragPos = center + (corner.x * right + corner.y * up) * radius;
+    QuadUV = corner * 0.5 + 0.5;
+    ToCamera = toCamera;
+    Color = instanceColorYaw.rgb;
+    Yaw = yaw;
+    Radius = radius;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 330 core
+uniform vec3 particleColor;
+
+in float alpha;
+
+out vec4 fragColor;
+
+void main() {
+    // round sprite, brightest in the middle
+    float d = length(gl_PointCoord * 2.0 - 1.0);
+    if (d > 1.0) discard;
+    float falloff = 1.0 - d * d;
+    fragColor = vec4(particleColor * (1.0 + falloff), alpha * falloff);
+}
@@ -0,0 +1,65 @@
+#version 330 core
+// one particle per vertex, written back through transform feedback
+layout(location = 0) in vec4 positionAge;
+layout(location = 1) in vec4 velocityLifetime;
+layout(location = 2) in vec4 orbit;
+layout(location = 3) in vec4 extra;
+
+// 0 orbit, 1 ballistic
+uniform int motion;
+uniform float time;
+uniform float deltaTime;
+uniform vec3 center;
+uniform vec3 gravity;
+
+out vec4 outPositionAge;
+out vec4 outVelocityLifetime;
+out vec4 outOrbit;
+out vec4 outExtra;
+
+// smooth, divergence-ish drift, cheap enough for tens of thousands per frame
+vec3 drift(vec3 p, float seed) {
+    float t = time * 0.3 + seed * 17.0;
+    return vec3(sin(p.y * 1.3 + t * 1.7) + sin(p.z * 0.7 - t),
+                sin(p.z * 1.1 + t * 1.3) * 0.5,
+                sin(p.x * 1.5 - t * 1.1) + sin(p.y * 0.9 + t * 0.6));
+}
+
+void main() {
+    vec3 position = positionAge.xyz;
+    float age = positionAge.w;
+    vec3 velocity = velocityLifetime.xyz;
+    float lifetime = velocityLifetime.w;
+
+    outOrbit = orbit;
+    outExtra = extra;
+
+    // dead particles are carried over until a new one is emitted in their place
+    if (lifetime >= 0.0 && age > lifetime) {
+        outPositionAge = positionAge;
+        outVelocityLifetime = velocityLifetime;
+        return;
+    }
+
+    if (motion == 0) {
+        float angle = orbit.x + orbit.y * time;
+        vec3 anchor = center + vec3(orbit.z * cos(angle), orbit.w, -orbit.z * sin(angle));
+        if (extra.x <= 0.0) {
+            // without drift it sits exactly on the orbit, where the CPU puts its light
+            position = anchor;
+            velocity = vec3(0.0);
+        } else {
+            vec3 pull = (anchor - position) * 2.0;
+            velocity += (drift(position, extra.y) * extra.x + pull) * deltaTime;
+            velocity *= exp(-1.5 * deltaTime);
+            position += velocity * deltaTime;
+        }
+    } else {
+        velocity += gravity * deltaTime;
+        velocity *= exp(-0.8 * deltaTime);
+        position += velocity * deltaTime;
+    }
+
+    outPositionAge = vec4(position, age + deltaTime);
+    outVelocityLifetime = vec4(velocity, lifetime);
+}
@@ -0,0 +1,37 @@
+#version 330 core
+layout(location = 0) in vec4 positionAge;
+layout(location = 1) in vec4 velocityLifetime;
+layout(location = 3) in vec4 extra;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float viewportHeight;
+// world size of a sprite
+uniform float pointSize;
+// 0 orbit, 1 ballistic
+uniform int motion;
+uniform float time;
+
+out float alpha;
+
+void main() {
+    vec4 viewPos = view * vec4(positionAge.xyz, 1.0);
+    gl_Position = projection * viewPos;
+
+    float age = positionAge.w;
+    float lifetime = velocityLifetime.w;
+    if (lifetime >= 0.0 && age > lifetime) {
+        alpha = 0.0;
+    } else if (motion == 0) {
+        // fireflies blink, each on its own beat
+        alpha = 0.55 + 0.45 * sin(time * 3.0 + extra.y * 40.0);
+    } else {
+        alpha = lifetime > 0.0 ? clamp(1.0 - age / lifetime, 0.0, 1.0) : 0.0;
+    }
+
+    // world size to pixels at this depth
+    gl_PointSize = pointSize * extra.z * projection[1][1] * 0.5 * viewportHeight / max(-viewPos.z, 0.01);
+    // a point size of zero is clamped up to the minimum, so dead particles
+    // are moved out of the clip volume instead
+    if (alpha <= 0.0) gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+}
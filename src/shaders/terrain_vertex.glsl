@@ -0,0 +1,53 @@
+#version 330 core
+// grid patch vertex, x and z in [0, 1]
+layout(location = 0) in vec3 vertPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+
+uniform sampler2D heightMap;
+uniform sampler2D normalMap;
+uniform vec2 terrainOrigin;
+uniform vec2 terrainSize;
+uniform vec2 heightMapSize;
+
+uniform vec2 patchOffset;
+uniform vec2 patchSize;
+uniform float gridResolution;
+// distances over which the patch morphs onto the next coarser grid
+uniform vec2 morphRange;
+uniform float textureTiling;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+// samples sit on texel centers, sample 0 at the origin and the last one at origin + size
+vec2 heightMapUV(vec2 xz) {
+    vec2 t = (xz - terrainOrigin) / terrainSize;
+    return (t * (heightMapSize - 1.0) + 0.5) / heightMapSize;
+}
+
+float heightAt(vec2 xz) {
+    return textureLod(heightMap, heightMapUV(xz), 0.0).r;
+}
+
+void main() {
+    vec2 grid = vertPos.xz * gridResolution;
+    vec2 xz = patchOffset + vertPos.xz * patchSize;
+
+    // odd grid vertices slide onto their even neighbours, which leaves exactly
+    // the coarser level's grid once the morph is complete
+    float distance = length(vec3(xz.x, heightAt(xz), xz.y) - viewPos);
+    float morph = clamp((distance - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+    grid -= fract(grid * 0.5) * 2.0 * morph;
+    xz = patchOffset + grid / gridResolution * patchSize;
+
+    vec3 worldPos = vec3(xz.x, heightAt(xz), xz.y);
+    FragPos = worldPos;
+    Normal = normalize(textureLod(normalMap, heightMapUV(xz), 0.0).xyz * 2.0 - 1.0);
+    TexCoords = xz * textureTiling;
+
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+layout(location = 0) in vec3 vertPos;
+// per-instance data, only fed when drawn through an InstanceGroup
+layout(location = 4) in mat4 instanceModel;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform bool useInstancing;
+
+// same expression as the lighting vertex shaders, so GL_EQUAL passes there
+invariant gl_Position;
+
+void main() {
+    float w = 500.0;
+
+    mat4 M = useInstancing ? instanceModel : model;
+
+    gl_Position = projection * view * M * vec4(vertPos * w, w);
+}
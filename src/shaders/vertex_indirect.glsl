@@ -0,0 +1,41 @@
+#version 430 core
+layout(location = 0) in vec3 vertPos;
+layout(location = 1) in vec3 vertNormal;
+layout(location = 2) in vec2 vertTexCoords;
+// per draw, the command's base instance selects the entry
+layout(location = 11) in uint drawIndex;
+
+struct DrawData {
+    mat4 model;
+    mat4 normal;
+    vec4 material; // shininess, ambient, diffuse, specular
+    ivec4 info;    // texture layer or -1
+};
+
+layout(std430, binding = 0) readonly buffer DrawTable {
+    DrawData draws[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out vec4 MaterialParams;
+flat out int TextureLayer;
+
+void main() {
+    float w = 500.0;
+    DrawData d = draws[drawIndex];
+
+    vec4 worldPos = d.model * vec4(vertPos, 1.0);
+    FragPos = worldPos.xyz / worldPos.w;
+
+    Normal = mat3(d.normal) * vertNormal;
+    TexCoords = vertTexCoords;
+    MaterialParams = d.material;
+    TextureLayer = d.info.x;
+
+    gl_Position = projection * view * d.model * vec4(vertPos * w, w);
+}
@@ -0,0 +1,92 @@
+#version 330 core
+layout(location = 0) in vec3 vertPos;
+layout(location = 1) in vec3 vertNormal;
+layout(location = 2) in vec2 vertTexCoords;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// per body: texel 0 = (parent, curve start, curve segments, scale)
+//           texel 1 = (curve speed, orbit radius, orbit speed, spin speed)
+// curves are 4 texels per segment holding the power form coefficients
+uniform samplerBuffer animParams;
+uniform int bodyOffset;
+uniform float time;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+const float TWO_PI = 6.28318530718;
+
+mat4 rotateY(float angle) {
+    float c = cos(angle);
+    float s = sin(angle);
+    return mat4(
+        vec4(c, 0.0, -s, 0.0),
+        vec4(0.0, 1.0, 0.0, 0.0),
+        vec4(s, 0.0, c, 0.0),
+        vec4(0.0, 0.0, 0.0, 1.0)
+    );
+}
+
+// same frame TransformBezier builds on the CPU
+mat4 curveFrame(int start, int segCount, float t) {
+    float globalT = t * float(segCount);
+    int seg = min(int(globalT), segCount - 1);
+    float localT = globalT - float(seg);
+
+    int base = start + seg * 4;
+    vec3 a = texelFetch(animParams, base).xyz;
+    vec3 b = texelFetch(animParams, base + 1).xyz;
+    vec3 c = texelFetch(animParams, base + 2).xyz;
+    vec3 d = texelFetch(animParams, base + 3).xyz;
+
+    vec3 pos = ((a * localT + b) * localT + c) * localT + d;
+    vec3 forward = normalize((a * (3.0 * localT) + b * 2.0) * localT + c);
+    vec3 right = normalize(cross(vec3(0.0, 1.0, 0.0), forward));
+    vec3 up = normalize(cross(forward, right));
+
+    return mat4(vec4(right, 0.0), vec4(up, 0.0), vec4(forward, 0.0), vec4(pos, 1.0));
+}
+
+mat4 bodyMatrix(int body) {
+    vec4 p0 = texelFetch(animParams, body * 2);
+    vec4 p1 = texelFetch(animParams, body * 2 + 1);
+
+    // moons ride on their parent's curve
+    int parent = int(p0.x);
+    vec4 curve = vec4(p0.yz, p1.x, 0.0);
+    if (parent >= 0) {
+        curve.xy = texelFetch(animParams, parent * 2).yz;
+        curve.z = texelFetch(animParams, parent * 2 + 1).x;
+    }
+
+    mat4 frame = mat4(1.0);
+    if (curve.y > 0.0) {
+        frame = curveFrame(int(curve.x), int(curve.y), fract(time * curve.z));
+    }
+
+    mat4 orbit = rotateY(mod(time * p1.z, TWO_PI));
+    orbit[3] = orbit * vec4(p1.y, 0.0, 0.0, 1.0);
+
+    mat4 spin = rotateY(mod(time * p1.w, TWO_PI));
+    spin[0] *= p0.w;
+    spin[1] *= p0.w;
+    spin[2] *= p0.w;
+
+    return frame * orbit * spin;
+}
+
+void main() {
+    float w = 500.0;
+    mat4 model = bodyMatrix(bodyOffset + gl_InstanceID);
+
+    vec4 worldPos = model * vec4(vertPos, 1.0);
+    FragPos = worldPos.xyz / worldPos.w;
+
+    Normal = mat3(transpose(inverse(model))) * vertNormal;
+    TexCoords = vertTexCoords;
+
+    gl_Position = projection * view * model * vec4(vertPos * w, w);
+}
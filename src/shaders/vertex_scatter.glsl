@@ -0,0 +1,40 @@
+#version 330 core
+layout(location = 0) in vec3 vertPos;
+layout(location = 1) in vec3 vertNormal;
+// per-instance ground position, yaw over a full turn and scale over maxScale
+layout(location = 4) in vec3 instancePos;
+layout(location = 5) in vec2 instanceYawScale;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float maxScale;
+uniform float modelBase;
+uniform float modelHeight;
+uniform float time;
+uniform vec2 windDirection;
+uniform float windStrength;
+
+out vec3 FragPos;
+out vec3 Normal;
+
+void main() {
+    float yaw = instanceYawScale.x * 6.2831853;
+    float scale = instanceYawScale.y * maxScale;
+    float c = cos(yaw);
+    float s = sin(yaw);
+
+    vec3 p = vertPos * scale;
+    p = vec3(c * p.x + s * p.z, p.y, -s * p.x + c * p.z);
+    Normal = vec3(c * vertNormal.x + s * vertNormal.z, vertNormal.y, -s * vertNormal.x + c * vertNormal.z);
+
+    // the base stays planted, the sway grows with height; every instance
+    // gets its own phase from where it stands
+    float bend = clamp((vertPos.y - modelBase) / modelHeight, 0.0, 1.0);
+    bend *= bend;
+    float phase = dot(instancePos.xz, vec2(0.37, 0.23));
+    float gust = sin(time * 1.7 + phase) + 0.3 * sin(time * 4.1 + phase * 1.3);
+    p.xz += windDirection * gust * windStrength * bend * scale * modelHeight;
+
+    FragPos = instancePos + p;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -8,6 +8,9 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// must match vertex_depth.glsl bit for bit, the depth pre-pass tests with GL_EQUAL
+invariant gl_Position;
+
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
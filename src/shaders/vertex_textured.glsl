@@ -2,10 +2,17 @@
 layout(location = 0) in vec3 vertPos;
 layout(location = 1) in vec3 vertNormal;
 layout(location = 2) in vec2 vertTexCoords;
+// per-instance data, only fed when drawn through an InstanceGroup
+layout(location = 4) in mat4 instanceModel;
+layout(location = 8) in mat3 instanceNormal;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform bool useInstancing;
+
+// must match vertex_depth.glsl bit for bit, the depth pre-pass tests with GL_EQUAL
+invariant gl_Position;
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -14,11 +21,13 @@ out vec2 TexCoords;
 void main() {
     float w = 500.0;
 
-    vec4 worldPos = model * vec4(vertPos, 1.0);
+    mat4 M = useInstancing ? instanceModel : model;
+
+    vec4 worldPos = M * vec4(vertPos, 1.0);
     FragPos = worldPos.xyz / worldPos.w;
     
-    Normal = mat3(transpose(inverse(model))) * vertNormal;
+    Normal = (useInstancing ? instanceNormal : mat3(transpose(inverse(model)))) * vertNormal;
     TexCoords = vertTexCoords;
     
-    gl_Position = projection * view * model * vec4(vertPos * w, w);
+    gl_Position = projection * view * M * vec4(vertPos * w, w);
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define BOUNDS_SSE 1
+#endif
+
+struct Aabb {
+    glm::vec3 min = glm::vec3(1e30f);
+    glm::vec3 max = glm::vec3(-1e30f);
+
+    bool isEmpty() const { return min.x > max.x; }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extent() const { return (max - min) * 0.5f; }
+
+    void expand(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void expand(const Aabb& b) {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+
+    // stands in for bounds that can't be computed, always passes the tests
+    static Aabb Everything() {
+        return {glm::vec3(-1e30f), glm::vec3(1e30f)};
+    }
+
+    // slab test, tEnter is clamped to 0 when the origin is inside
+    bool intersectRay(const glm::vec3& origin, const glm::vec3& invDir, float maxDist, float& tEnter) const {
+        glm::vec3 t0 = (min - origin) * invDir;
+        glm::vec3 t1 = (max - origin) * invDir;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDist));
+        tEnter = enter;
+        return enter <= exit;
+    }
+};
+
+// world bounds of local bounds under m; the scenes put a uniform scale in
+// m[3][3], so positions are divided by w like the shaders do
+inline Aabb TransformBounds(const Aabb& local, const glm::mat4& m) {
+    if (local.isEmpty()) return local;
+
+    if (m[0][3] == 0.0f && m[1][3] == 0.0f && m[2][3] == 0.0f && m[3][3] > 0.0f) {
+        float invW = 1.0f / m[3][3];
+        glm::mat3 linear(m);
+        glm::mat3 absLinear(glm::abs(linear[0]), glm::abs(linear[1]), glm::abs(linear[2]));
+        glm::vec3 c = (linear * local.center() + glm::vec3(m[3])) * invW;
+        glm::vec3 e = absLinear * local.extent() * invW;
+        return {c - e, c + e};
+    }
+
+    // projective matrix, go through the corners
+    Aabb out;
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner((i & 1) ? local.max.x : local.min.x,
+                         (i & 2) ? local.max.y : local.min.y,
+                         (i & 4) ? local.max.z : local.min.z);
+        glm::vec4 p = m * glm::vec4(corner, 1.0f);
+        if (p.w <= 0.0f) return Aabb::Everything();
+        out.expand(glm::vec3(p) / p.w);
+    }
+    return out;
+}
+
+// six planes of a view-projection matrix, stored plane-major in lanes of four
+// so a box is tested against four planes per SSE step; lanes 6 and 7 repeat
+// the left plane
+struct Frustum {
+    enum class Result {
+        OUTSIDE,
+        INTERSECT,
+        INSIDE
+    };
+
+    alignas(16) float nx[8];
+    alignas(16) float ny[8];
+    alignas(16) float nz[8];
+    alignas(16) float d[8];
+
+    Frustum() = default;
+
+    explicit Frustum(const glm::mat4& viewProj) {
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i) {
+            rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+        }
+        glm::vec4 planes[6] = {
+            rows[3] + rows[0], rows[3] - rows[0],
+            rows[3] + rows[1], rows[3] - rows[1],
+            rows[3] + rows[2], rows[3] - rows[2]
+        };
+        for (int i = 0; i < 8; ++i) {
+            glm::vec4 p = planes[i < 6 ? i : 0];
+            float len = glm::length(glm::vec3(p));
+            if (len > 0.0f) p = p / len;
+            nx[i] = p.x;
+            ny[i] = p.y;
+            nz[i] = p.z;
+            d[i] = p.w;
+        }
+    }
+
+    // plane i as (normal, distance), 0..5 are left, right, bottom, top, near, far
+    glm::vec4 getPlane(int i) const {
+        return glm::vec4(nx[i], ny[i], nz[i], d[i]);
+    }
+
+    Result test(const Aabb& box) const {
+        glm::vec3 c = box.center();
+        glm::vec3 e = box.extent();
+#ifdef BOUNDS_SSE
+        // distance of the box center to each plane against the box radius
+        // projected on the plane normal
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+        const __m128 ex = _mm_set1_ps(e.x), ey = _mm_set1_ps(e.y), ez = _mm_set1_ps(e.z);
+        int outside = 0;
+        int straddle = 0;
+        for (int i = 0; i < 8; i += 4) {
+            __m128 px = _mm_load_ps(nx + i), py = _mm_load_ps(ny + i), pz = _mm_load_ps(nz + i);
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)),
+                                     _mm_add_ps(_mm_mul_ps(pz, cz), _mm_load_ps(d + i)));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, px), ex),
+                                                  _mm_mul_ps(_mm_andnot_ps(signMask, py), ey)),
+                                       _mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+            outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+            straddle |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, radius), _mm_setzero_ps()));
+        }
+        if (outside) return Result::OUTSIDE;
+        return straddle ? Result::INTERSECT : Result::INSIDE;
+#else
+        bool straddle = false;
+        for (int i = 0; i < 6; ++i) {
+            float dist = nx[i] * c.x + ny[i] * c.y + nz[i] * c.z + d[i];
+            float radius = std::abs(nx[i]) * e.x + std::abs(ny[i]) * e.y + std::abs(nz[i]) * e.z;
+            if (dist + radius < 0.0f) return Result::OUTSIDE;
+            if (dist - radius < 0.0f) straddle = true;
+        }
+        return straddle ? Result::INTERSECT : Result::INSIDE;
+#endif
+    }
+};
@@ -0,0 +1,230 @@
+#include "Bvh.hpp"
+#include <algorithm>
+
+namespace {
+
+const uint64_t UNSEEN = UINT64_MAX;
+
+Aabb localBounds(const DrawableObject& obj) {
+    return obj.model ? obj.model->getBounds() : Aabb::Everything();
+}
+
+}
+
+void Bvh::Tree::build(const std::vector<Aabb>& bounds, std::vector<uint32_t> objectIndices) {
+    items = std::move(objectIndices);
+    nodes.clear();
+    if (items.empty()) return;
+    nodes.reserve(2 * (items.size() / LEAF_SIZE + 1));
+    buildNode(bounds, 0, static_cast<uint32_t>(items.size()));
+}
+
+uint32_t Bvh::Tree::buildNode(const std::vector<Aabb>& bounds, uint32_t first, uint32_t count) {
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    Aabb box;
+    Aabb centers;
+    for (uint32_t i = first; i < first + count; ++i) {
+        box.expand(bounds[items[i]]);
+        centers.expand(bounds[items[i]].center());
+    }
+    nodes[index].bounds = box;
+
+    if (count <= LEAF_SIZE) {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        return index;
+    }
+
+    // median split along the widest spread of centers
+    glm::vec3 spread = centers.max - centers.min;
+    int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+    uint32_t mid = first + count / 2;
+    std::nth_element(items.begin() + first, items.begin() + mid, items.begin() + first + count,
+                     [&](uint32_t a, uint32_t b) { return bounds[a].center()[axis] < bounds[b].center()[axis]; });
+
+    buildNode(bounds, first, mid - first);
+    uint32_t right = buildNode(bounds, mid, first + count - mid);
+    nodes[index].right = right;
+    return index;
+}
+
+void Bvh::Tree::refit(const std::vector<Aabb>& bounds) {
+    // children always come after their parent, so one reverse pass is enough
+    for (size_t n = nodes.size(); n-- > 0;) {
+        Node& node = nodes[n];
+        Aabb box;
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) box.expand(bounds[items[i]]);
+        } else {
+            box.expand(nodes[n + 1].bounds);
+            box.expand(nodes[node.right].bounds);
+        }
+        node.bounds = box;
+    }
+}
+
+bool Bvh::refreshBounds(const DrawableObject& obj, size_t index) {
+    uint64_t version = obj.transform->getVersion();
+    if (version == versions[index] && transforms[index] == obj.transform.get()) return false;
+    versions[index] = version;
+    transforms[index] = obj.transform.get();
+    worldBounds[index] = TransformBounds(localBounds(obj), obj.transform->getMatrix());
+    return true;
+}
+
+void Bvh::rebuild(const std::vector<DrawableObject>& objects) {
+    size_t n = objects.size();
+    worldBounds.assign(n, Aabb());
+    versions.assign(n, UNSEEN);
+    transforms.assign(n, nullptr);
+    movedFrame.assign(n, 0);
+    for (size_t i = 0; i < n; ++i) refreshBounds(objects[i], i);
+    frame = SETTLE_FRAMES;
+    rebuildStatic();
+}
+
+void Bvh::rebuildStatic() {
+    std::vector<uint32_t> staticItems;
+    dynamicItems.clear();
+    dynamicFlags.assign(worldBounds.size(), 0);
+    for (uint32_t i = 0; i < worldBounds.size(); ++i) {
+        if (frame - movedFrame[i] < SETTLE_FRAMES) {
+            dynamicFlags[i] = 1;
+            dynamicItems.push_back(i);
+        } else {
+            staticItems.push_back(i);
+        }
+    }
+    staticTree.build(worldBounds, std::move(staticItems));
+    dynamicTree.build(worldBounds, dynamicItems);
+}
+
+void Bvh::update(const std::vector<DrawableObject>& objects) {
+    size_t n = objects.size();
+    // removals shift every later index, start over
+    if (n < worldBounds.size()) {
+        rebuild(objects);
+        return;
+    }
+
+    ++frame;
+    worldBounds.resize(n);
+    versions.resize(n, UNSEEN);
+    transforms.resize(n, nullptr);
+    movedFrame.resize(n, 0);
+    dynamicFlags.resize(n, 0);
+
+    bool moved = false;
+    bool joined = false;
+    for (size_t i = 0; i < n; ++i) {
+        if (!refreshBounds(objects[i], i)) continue;
+        moved = true;
+        movedFrame[i] = frame;
+        if (!dynamicFlags[i]) {
+            dynamicFlags[i] = 1;
+            dynamicItems.push_back(static_cast<uint32_t>(i));
+            joined = true;
+        }
+    }
+
+    if (dynamicItems.size() > 64 && dynamicItems.size() * 4 > n) {
+        rebuildStatic();
+    } else if (joined) {
+        dynamicTree.build(worldBounds, dynamicItems);
+    } else if (moved) {
+        dynamicTree.refit(worldBounds);
+    }
+}
+
+void Bvh::queryFrustum(const Frustum& frustum, std::vector<uint8_t>& visible) const {
+    visible.assign(worldBounds.size(), 0);
+
+    auto query = [&](const Tree& tree, bool skipDynamic) {
+        if (tree.nodes.empty()) return;
+        // (node, whole subtree already known to be inside)
+        uint32_t stack[64];
+        bool inside[64];
+        int top = 0;
+        stack[top] = 0;
+        inside[top++] = false;
+
+        while (top > 0) {
+            --top;
+            const Node& node = tree.nodes[stack[top]];
+            bool contained = inside[top];
+            if (!contained) {
+                Frustum::Result r = frustum.test(node.bounds);
+                if (r == Frustum::Result::OUTSIDE) continue;
+                contained = r == Frustum::Result::INSIDE;
+            }
+
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    uint32_t obj = tree.items[i];
+                    if (skipDynamic && dynamicFlags[obj]) continue;
+                    if (contained || frustum.test(worldBounds[obj]) != Frustum::Result::OUTSIDE) visible[obj] = 1;
+                }
+                continue;
+            }
+            uint32_t index = static_cast<uint32_t>(&node - tree.nodes.data());
+            stack[top] = node.right;
+            inside[top++] = contained;
+            stack[top] = index + 1;
+            inside[top++] = contained;
+        }
+    };
+
+    query(staticTree, true);
+    query(dynamicTree, false);
+}
+
+template <typename Visit>
+void Bvh::traverseRay(const Tree& tree, const glm::vec3& origin, const glm::vec3& invDir, float& maxDist,
+                      Visit visit) const {
+    if (tree.nodes.empty()) return;
+    uint32_t stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = tree.nodes[stack[--top]];
+        float t;
+        if (!node.bounds.intersectRay(origin, invDir, maxDist, t)) continue;
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                uint32_t obj = tree.items[i];
+                if (&tree == &staticTree && dynamicFlags[obj]) continue;
+                if (worldBounds[obj].intersectRay(origin, invDir, maxDist, t)) visit(obj, t, maxDist);
+            }
+            continue;
+        }
+        uint32_t index = static_cast<uint32_t>(&node - tree.nodes.data());
+        stack[top++] = node.right;
+        stack[top++] = index + 1;
+    }
+}
+
+int Bvh::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist, float* hitDist) const {
+    glm::vec3 invDir = 1.0f / dir;
+    int best = -1;
+    // shrinking maxDist prunes nodes behind the nearest hit so far
+    auto nearest = [&](uint32_t obj, float t, float& limit) {
+        best = static_cast<int>(obj);
+        limit = t;
+    };
+    traverseRay(staticTree, origin, invDir, maxDist, nearest);
+    traverseRay(dynamicTree, origin, invDir, maxDist, nearest);
+    if (best >= 0 && hitDist) *hitDist = maxDist;
+    return best;
+}
+
+void Bvh::queryRay(const glm::vec3& origin, const glm::vec3& dir, float maxDist, std::vector<uint32_t>& hits) const {
+    hits.clear();
+    glm::vec3 invDir = 1.0f / dir;
+    auto collect = [&](uint32_t obj, float, float&) { hits.push_back(obj); };
+    traverseRay(staticTree, origin, invDir, maxDist, collect);
+    traverseRay(dynamicTree, origin, invDir, maxDist, collect);
+}
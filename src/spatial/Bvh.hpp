@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Bounds.hpp"
+#include "../DrawableObject.hpp"
+
+// bounding volume hierarchy over the world bounds of a scene's objects
+//
+// objects start in the static tree; once an object's transform version moves
+// it goes to the dynamic tree, which is refit every update and rebuilt when
+// its membership changes. the static tree is rebuilt only when objects are
+// removed or too many of them turned dynamic
+class Bvh {
+public:
+    void rebuild(const std::vector<DrawableObject>& objects);
+    void update(const std::vector<DrawableObject>& objects);
+
+    // visible[i] is 1 for objects whose bounds touch the frustum
+    void queryFrustum(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+    // nearest object whose bounds the ray enters, -1 when nothing is hit
+    int raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDist, float* hitDist = nullptr) const;
+    // every object whose bounds the ray passes through
+    void queryRay(const glm::vec3& origin, const glm::vec3& dir, float maxDist, std::vector<uint32_t>& hits) const;
+
+    size_t size() const { return worldBounds.size(); }
+    const Aabb& getWorldBounds(size_t objectIndex) const { return worldBounds[objectIndex]; }
+    size_t getDynamicCount() const { return dynamicItems.size(); }
+
+private:
+    struct Node {
+        Aabb bounds;
+        // leaves hold items[first, first + count), inner nodes have their
+        // left child right after them and the right child at index right
+        uint32_t first = 0;
+        uint32_t count = 0;
+        uint32_t right = 0;
+    };
+
+    struct Tree {
+        std::vector<Node> nodes;
+        std::vector<uint32_t> items;
+
+        void build(const std::vector<Aabb>& bounds, std::vector<uint32_t> objectIndices);
+        void refit(const std::vector<Aabb>& bounds);
+        uint32_t buildNode(const std::vector<Aabb>& bounds, uint32_t first, uint32_t count);
+    };
+
+    static constexpr uint32_t LEAF_SIZE = 4;
+    // objects that moved within this many updates stay dynamic across a rebuild
+    static constexpr uint64_t SETTLE_FRAMES = 60;
+
+    Tree staticTree;
+    Tree dynamicTree;
+    std::vector<Aabb> worldBounds;
+    std::vector<uint64_t> versions;
+    std::vector<const Transform*> transforms;
+    std::vector<uint64_t> movedFrame;
+    std::vector<uint8_t> dynamicFlags;
+    std::vector<uint32_t> dynamicItems;
+    uint64_t frame = 0;
+
+    void rebuildStatic();
+    bool refreshBounds(const DrawableObject& obj, size_t index);
+    template <typename Visit>
+    void traverseRay(const Tree& tree, const glm::vec3& origin, const glm::vec3& invDir, float& maxDist,
+                     Visit visit) const;
+};
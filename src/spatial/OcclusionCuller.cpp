@@ -0,0 +1,280 @@
+#include "OcclusionCuller.hpp"
+#include "Bvh.hpp"
+#include "../ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define OCCLUSION_SSE 1
+#endif
+
+namespace {
+const int ROWS_PER_BAND = 8;
+const int MIN_TRIANGLES_FOR_WORKERS = 64;
+}
+
+OccluderMesh OccluderMesh::Box(const Aabb& box) {
+    OccluderMesh mesh;
+    for (int i = 0; i < 8; ++i) {
+        mesh.positions.emplace_back((i & 1) ? box.max.x : box.min.x,
+                                    (i & 2) ? box.max.y : box.min.y,
+                                    (i & 4) ? box.max.z : box.min.z);
+    }
+    mesh.indices = {
+        0, 2, 1, 1, 2, 3,  // -z
+        4, 5, 6, 5, 7, 6,  // +z
+        0, 1, 4, 1, 5, 4,  // -y
+        2, 6, 3, 3, 6, 7,  // +y
+        0, 4, 2, 2, 4, 6,  // -x
+        1, 3, 5, 3, 7, 5   // +x
+    };
+    return mesh;
+}
+
+OcclusionCuller::OcclusionCuller() : depth(WIDTH * HEIGHT, 1.0f) {}
+
+void OcclusionCuller::addOccluder(size_t objectIndex, OccluderMesh mesh) {
+    occluders.push_back({objectIndex, std::move(mesh)});
+    if (isOccluder.size() <= objectIndex) isOccluder.resize(objectIndex + 1, 0);
+    isOccluder[objectIndex] = 1;
+}
+
+void OcclusionCuller::addStaticOccluder(OccluderMesh worldMesh) {
+    staticOccluders.push_back(std::move(worldMesh));
+}
+
+const OccluderMesh* OcclusionCuller::findOccluder(size_t objectIndex) const {
+    if (objectIndex >= isOccluder.size() || !isOccluder[objectIndex]) return nullptr;
+    for (const auto& o : occluders) {
+        if (o.objectIndex == objectIndex) return &o.mesh;
+    }
+    return nullptr;
+}
+
+void OcclusionCuller::clearOccluders() {
+    occluders.clear();
+    staticOccluders.clear();
+    isOccluder.clear();
+}
+
+void OcclusionCuller::removeObject(size_t objectIndex, size_t movedFrom) {
+    for (size_t i = 0; i < occluders.size();) {
+        if (occluders[i].objectIndex == objectIndex) {
+            occluders[i] = std::move(occluders.back());
+            occluders.pop_back();
+            continue;
+        }
+        if (occluders[i].objectIndex == movedFrom) occluders[i].objectIndex = objectIndex;
+        ++i;
+    }
+    if (objectIndex < isOccluder.size()) {
+        isOccluder[objectIndex] = movedFrom < isOccluder.size() ? isOccluder[movedFrom] : 0;
+    }
+    if (movedFrom < isOccluder.size()) isOccluder[movedFrom] = 0;
+}
+
+void OcclusionCuller::addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+    // clip against the near plane (z >= -w), leaves at most a quad
+    const glm::vec4 in[3] = {a, b, c};
+    glm::vec4 poly[4];
+    int count = 0;
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec4& p = in[i];
+        const glm::vec4& q = in[(i + 1) % 3];
+        float dp = p.z + p.w;
+        float dq = q.z + q.w;
+        if (dp >= 0.0f) poly[count++] = p;
+        if ((dp >= 0.0f) != (dq >= 0.0f)) poly[count++] = p + (q - p) * (dp / (dp - dq));
+    }
+    if (count < 3) return;
+
+    glm::vec3 screen[4];
+    for (int i = 0; i < count; ++i) {
+        if (poly[i].w <= 1e-6f) return;
+        glm::vec3 ndc = glm::vec3(poly[i]) / poly[i].w;
+        screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * WIDTH, (ndc.y * 0.5f + 0.5f) * HEIGHT, ndc.z * 0.5f + 0.5f);
+    }
+
+    for (int i = 1; i + 1 < count; ++i) {
+        glm::vec3 v[3] = {screen[0], screen[i], screen[i + 1]};
+        float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+        if (std::abs(area) < 1e-6f) continue;
+        if (area < 0.0f) std::swap(v[1], v[2]);
+
+        float minX = std::min(v[0].x, std::min(v[1].x, v[2].x));
+        float maxX = std::max(v[0].x, std::max(v[1].x, v[2].x));
+        float minY = std::min(v[0].y, std::min(v[1].y, v[2].y));
+        float maxY = std::max(v[0].y, std::max(v[1].y, v[2].y));
+        if (maxX < 0.0f || minX >= WIDTH || maxY < 0.0f || minY >= HEIGHT) continue;
+
+        Triangle t;
+        for (int k = 0; k < 3; ++k) {
+            t.x[k] = v[k].x;
+            t.y[k] = v[k].y;
+            t.z[k] = v[k].z;
+        }
+        t.minY = std::max(0, static_cast<int>(std::floor(minY)));
+        t.maxY = std::min(HEIGHT - 1, static_cast<int>(std::ceil(maxY)));
+        triangles.push_back(t);
+    }
+}
+
+void OcclusionCuller::rasterizeRows(int rowBegin, int rowEnd) {
+    std::fill(depth.begin() + rowBegin * WIDTH, depth.begin() + rowEnd * WIDTH, 1.0f);
+
+    for (const Triangle& t : triangles) {
+        int y0 = std::max(t.minY, rowBegin);
+        int y1 = std::min(t.maxY, rowEnd - 1);
+        if (y0 > y1) continue;
+
+        float minX = std::min(t.x[0], std::min(t.x[1], t.x[2]));
+        float maxX = std::max(t.x[0], std::max(t.x[1], t.x[2]));
+        // blocks of four pixels, WIDTH is a multiple of four so none runs past the row
+        int x0 = std::max(0, static_cast<int>(std::floor(minX))) & ~3;
+        int x1 = std::min(WIDTH - 1, static_cast<int>(std::ceil(maxX)));
+
+        // edge functions are positive inside a counter-clockwise triangle
+        float ea[3], eb[3], ec[3];
+        for (int i = 0; i < 3; ++i) {
+            int j = (i + 1) % 3;
+            ea[i] = t.y[i] - t.y[j];
+            eb[i] = t.x[j] - t.x[i];
+            ec[i] = -(ea[i] * t.x[i] + eb[i] * t.y[i]);
+        }
+        float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+        float dzdx = ((t.z[1] - t.z[0]) * (t.y[2] - t.y[0]) - (t.z[2] - t.z[0]) * (t.y[1] - t.y[0])) / area;
+        float dzdy = ((t.z[2] - t.z[0]) * (t.x[1] - t.x[0]) - (t.z[1] - t.z[0]) * (t.x[2] - t.x[0])) / area;
+        float zc = t.z[0] - dzdx * t.x[0] - dzdy * t.y[0];
+
+        for (int y = y0; y <= y1; ++y) {
+            float py = y + 0.5f;
+            float* row = depth.data() + y * WIDTH;
+#ifdef OCCLUSION_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+            __m128 a0 = _mm_set1_ps(ea[0]), a1 = _mm_set1_ps(ea[1]), a2 = _mm_set1_ps(ea[2]);
+            __m128 r0 = _mm_set1_ps(eb[0] * py + ec[0]);
+            __m128 r1 = _mm_set1_ps(eb[1] * py + ec[1]);
+            __m128 r2 = _mm_set1_ps(eb[2] * py + ec[2]);
+            __m128 dz = _mm_set1_ps(dzdx);
+            __m128 zr = _mm_set1_ps(dzdy * py + zc);
+            for (int x = x0; x <= x1; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+                __m128 inside = _mm_and_ps(
+                    _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), r0), zero),
+                               _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), r1), zero)),
+                    _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), r2), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+                __m128 z = _mm_add_ps(_mm_mul_ps(dz, px), zr);
+                __m128 old = _mm_loadu_ps(row + x);
+                __m128 nearer = _mm_min_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+#else
+            for (int x = x0; x <= x1; ++x) {
+                float px = x + 0.5f;
+                if (ea[0] * px + eb[0] * py + ec[0] < 0.0f) continue;
+                if (ea[1] * px + eb[1] * py + ec[1] < 0.0f) continue;
+                if (ea[2] * px + eb[2] * py + ec[2] < 0.0f) continue;
+                row[x] = std::min(row[x], dzdx * px + dzdy * py + zc);
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionCuller::addMesh(const OccluderMesh& mesh, const glm::mat4& m) {
+    clipScratch.resize(mesh.positions.size());
+    for (size_t i = 0; i < clipScratch.size(); ++i) {
+        clipScratch[i] = m * glm::vec4(mesh.positions[i], 1.0f);
+    }
+    const auto& ind = mesh.indices;
+    for (size_t i = 0; i + 2 < ind.size(); i += 3) {
+        addTriangle(clipScratch[ind[i]], clipScratch[ind[i + 1]], clipScratch[ind[i + 2]]);
+    }
+}
+
+void OcclusionCuller::render(const std::vector<DrawableObject>& objects, const glm::mat4& vp,
+                             const std::vector<uint8_t>* visible) {
+    viewProj = vp;
+    triangles.clear();
+
+    for (const auto& occluder : occluders) {
+        size_t idx = occluder.objectIndex;
+        if (idx >= objects.size()) continue;
+        if (visible && idx < visible->size() && !(*visible)[idx]) continue;
+
+        // the w of the object matrix only scales clip space, so no divide is needed here
+        addMesh(occluder.mesh, viewProj * objects[idx].transform->getMatrix());
+    }
+    for (const auto& mesh : staticOccluders) addMesh(mesh, viewProj);
+
+    const int bands = HEIGHT / ROWS_PER_BAND;
+    if (workers && triangles.size() >= MIN_TRIANGLES_FOR_WORKERS) {
+        workers->parallelFor(bands, 1, [this](int begin, int end) {
+            rasterizeRows(begin * ROWS_PER_BAND, end * ROWS_PER_BAND);
+        });
+    } else {
+        rasterizeRows(0, HEIGHT);
+    }
+}
+
+bool OcclusionCuller::isOccluded(const Aabb& bounds) const {
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+    float minZ = 1e30f;
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner((i & 1) ? bounds.max.x : bounds.min.x,
+                         (i & 2) ? bounds.max.y : bounds.min.y,
+                         (i & 4) ? bounds.max.z : bounds.min.z);
+        glm::vec4 p = viewProj * glm::vec4(corner, 1.0f);
+        // crossing the near plane, it covers too much of the screen to bother
+        if (p.w <= 1e-6f || p.z < -p.w) return false;
+        float invW = 1.0f / p.w;
+        float sx = (p.x * invW * 0.5f + 0.5f) * WIDTH;
+        float sy = (p.y * invW * 0.5f + 0.5f) * HEIGHT;
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        minZ = std::min(minZ, p.z * invW * 0.5f + 0.5f);
+    }
+
+    int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+    int x1 = std::min(WIDTH - 1, static_cast<int>(std::floor(maxX)));
+    int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+    int y1 = std::min(HEIGHT - 1, static_cast<int>(std::floor(maxY)));
+    if (x0 > x1 || y0 > y1) return false;
+
+    // hidden only if every covered pixel has an occluder in front of the nearest corner
+    for (int y = y0; y <= y1; ++y) {
+        const float* row = depth.data() + y * WIDTH;
+        int x = x0;
+#ifdef OCCLUSION_SSE
+        __m128 z = _mm_set1_ps(minZ);
+        for (; x + 3 <= x1; x += 4) {
+            if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), z))) return false;
+        }
+#endif
+        for (; x <= x1; ++x) {
+            if (row[x] >= minZ) return false;
+        }
+    }
+    return true;
+}
+
+void OcclusionCuller::cull(const std::vector<DrawableObject>& objects, const Bvh& bvh, const glm::mat4& vp,
+                           std::vector<uint8_t>& visible) {
+    render(objects, vp, &visible);
+
+    occludedCount = 0;
+    size_t n = std::min(visible.size(), bvh.size());
+    for (size_t i = 0; i < n; ++i) {
+        if (!visible[i]) continue;
+        if (i < isOccluder.size() && isOccluder[i]) continue;
+        if (isOccluded(bvh.getWorldBounds(i))) {
+            visible[i] = 0;
+            ++occludedCount;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "Bounds.hpp"
+#include "../DrawableObject.hpp"
+
+class Bvh;
+class ThreadPool;
+
+// simplified occluder geometry in object space, it has to stay inside the
+// real mesh or it hides things that are visible
+struct OccluderMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+
+    static OccluderMesh Box(const Aabb& box);
+};
+
+// rasterizes the occluders of a frame into a small CPU depth buffer and drops
+// objects whose screen rectangle lies entirely behind it; needs no GL at all
+class OcclusionCuller {
+public:
+    static constexpr int WIDTH = 256;
+    static constexpr int HEIGHT = 128;
+
+    OcclusionCuller();
+
+    void setWorkers(ThreadPool* pool) { workers = pool; }
+
+    // the mesh follows the object's transform
+    void addOccluder(size_t objectIndex, OccluderMesh mesh);
+    // world space geometry that belongs to no object and never moves, e.g.
+    // scattered tree trunks
+    void addStaticOccluder(OccluderMesh worldMesh);
+    void clearOccluders();
+    // the scene dropped objectIndex and moved object movedFrom into its place
+    void removeObject(size_t objectIndex, size_t movedFrom);
+    bool hasOccluders() const { return !occluders.empty() || !staticOccluders.empty(); }
+    // object space mesh of the object's occluder, nullptr when it has none
+    const OccluderMesh* findOccluder(size_t objectIndex) const;
+
+    // draws the visible occluders, then clears visible[i] for every other
+    // object the depth buffer hides
+    void cull(const std::vector<DrawableObject>& objects, const Bvh& bvh, const glm::mat4& viewProj,
+              std::vector<uint8_t>& visible);
+
+    void render(const std::vector<DrawableObject>& objects, const glm::mat4& viewProj,
+                const std::vector<uint8_t>* visible = nullptr);
+    bool isOccluded(const Aabb& worldBounds) const;
+
+    // depth in [0, 1] per pixel, row 0 at the bottom, 1 where nothing was drawn
+    const std::vector<float>& getDepth() const { return depth; }
+    int getTriangleCount() const { return static_cast<int>(triangles.size()); }
+    int getOccludedCount() const { return occludedCount; }
+
+private:
+    struct Occluder {
+        size_t objectIndex;
+        OccluderMesh mesh;
+    };
+
+    // screen space, counter-clockwise
+    struct Triangle {
+        float x[3], y[3], z[3];
+        int minY, maxY;
+    };
+
+    std::vector<Occluder> occluders;
+    std::vector<OccluderMesh> staticOccluders;
+    std::vector<uint8_t> isOccluder;
+    std::vector<Triangle> triangles;
+    std::vector<glm::vec4> clipScratch;
+    std::vector<float> depth;
+    glm::mat4 viewProj = glm::mat4(1.0f);
+    ThreadPool* workers = nullptr;
+    int occludedCount = 0;
+
+    void addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+    void addMesh(const OccluderMesh& mesh, const glm::mat4& m);
+    void rasterizeRows(int rowBegin, int rowEnd);
+};
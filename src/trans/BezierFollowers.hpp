@@ -0,0 +1,43 @@
+#pragma once
+#include "TransformBezier.hpp"
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// advances every registered curve in one pass from a single time value,
+// so scenes don't have to keep their own fmod(time * speed) loops
+class BezierFollowers {
+public:
+    size_t add(const std::shared_ptr<TransformBezier>& curve, float speed, float offset = 0.0f) {
+        followers.push_back({curve, speed, offset});
+        return followers.size() - 1;
+    }
+
+    void setSpeed(size_t idx, float speed) {
+        followers[idx].speed = speed;
+    }
+
+    void clear() {
+        followers.clear();
+    }
+
+    size_t size() const {
+        return followers.size();
+    }
+
+    void update(float time) {
+        for (auto& f : followers) {
+            float t = std::fmod(time * f.speed + f.offset, 1.0f);
+            if (t < 0.0f) t += 1.0f;
+            f.curve->setParam(t);
+        }
+    }
+
+private:
+    struct Follower {
+        std::shared_ptr<TransformBezier> curve;
+        float speed;
+        float offset;
+    };
+    std::vector<Follower> followers;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <tuple>
+#include <utility>
+#include "Transform.hpp"
+#include "TransformTranslation.hpp"
+#include "TransformRotation.hpp"
+#include "TransformScale.hpp"
+
+// post-multiplies m by a part in closed form; glm's translate/rotate/scale
+// taking a matrix only touch the columns that actually change
+namespace StaticCompose {
+inline void apply(glm::mat4& m, const TransformTranslation& t) {
+    m = glm::translate(m, t.getOffset());
+}
+
+inline void apply(glm::mat4& m, const TransformRotation& r) {
+    m = glm::rotate(m, glm::radians(r.getAngle()), r.getAxis());
+}
+
+inline void apply(glm::mat4& m, const TransformScale& s) {
+    m = glm::scale(m, s.getScale());
+}
+
+// anything else falls back to its cached matrix
+inline void apply(glm::mat4& m, const Transform& t) {
+    m = m * t.getMatrix();
+}
+}
+
+// fixed-shape composite with its parts stored inline, so one object costs a
+// single allocation and the chain is resolved without virtual calls
+template <typename... Parts>
+class StaticComposite : public Transform {
+public:
+    explicit StaticComposite(Parts... p) : parts(std::move(p)...) {
+        std::apply([this](Parts&... part) { (part.addParent(this), ...); }, parts);
+    }
+
+    StaticComposite(const StaticComposite&) = delete;
+    StaticComposite& operator=(const StaticComposite&) = delete;
+
+    template <size_t I>
+    auto& get() {
+        return std::get<I>(parts);
+    }
+
+    template <size_t I>
+    const auto& get() const {
+        return std::get<I>(parts);
+    }
+
+protected:
+    glm::mat4 computeMatrix() const override {
+        glm::mat4 result(1.0f);
+        std::apply([&result](const Parts&... part) {
+            (StaticCompose::apply(result, part), ...);
+            (Transform::acknowledge(part), ...);
+        }, parts);
+        return result;
+    }
+
+private:
+    std::tuple<Parts...> parts;
+};
+
+using TransformTS = StaticComposite<TransformTranslation, TransformScale>;
+using TransformTRS = StaticComposite<TransformTranslation, TransformRotation, TransformScale>;
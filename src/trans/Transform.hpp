@@ -1,9 +1,68 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
 
+// every node caches its matrix; setters mark the node dirty and the change walks
+// up to the composites that contain it, so unchanged subtrees and nodes shared
+// by several composites are only evaluated once per change
 class Transform {
 public:
+    Transform() = default;
+    Transform(const Transform&) {}
+    Transform& operator=(const Transform&) {
+        markDirty();
+        return *this;
+    }
     virtual ~Transform() = default;
-    virtual glm::mat4 getMatrix() const = 0;
-};
\ No newline at end of file
+
+    const glm::mat4& getMatrix() const {
+        if (dirty) {
+            cached = computeMatrix();
+            dirty = false;
+            notified = false;
+        }
+        return cached;
+    }
+
+    // bumped whenever the matrix may have changed since it was last read
+    uint64_t getVersion() const { return version; }
+
+    void addParent(Transform* parent) {
+        parents.push_back(parent);
+    }
+
+    void removeParent(Transform* parent) {
+        auto it = std::find(parents.begin(), parents.end(), parent);
+        if (it != parents.end()) parents.erase(it);
+    }
+
+protected:
+    virtual glm::mat4 computeMatrix() const = 0;
+
+    void markDirty() {
+        ++version;
+        dirty = true;
+        // parents haven't read this node since they were last told, stop here
+        if (notified) return;
+        notified = true;
+        for (auto* parent : parents) {
+            parent->markDirty();
+        }
+    }
+
+    // for composites that read a child's parameters directly instead of its
+    // matrix, so the child's next change still reaches them
+    static void acknowledge(const Transform& child) {
+        child.notified = false;
+    }
+
+private:
+    mutable glm::mat4 cached = glm::mat4(1.0f);
+    mutable bool dirty = true;
+    mutable bool notified = false;
+    uint64_t version = 0;
+    std::vector<Transform*> parents;
+};
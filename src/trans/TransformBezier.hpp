@@ -1,123 +1,172 @@
 #pragma once
 #include "Transform.hpp"
+#include <algorithm>
 #include <vector>
 
 class TransformBezier : public Transform {
 public:
+    // one cubic segment in power form: pos(t) = ((a*t + b)*t + c)*t + d
+    struct Segment {
+        glm::vec3 a, b, c, d;
+    };
+
     TransformBezier(const std::vector<glm::vec3>& points, float t = 0.0f)
-        : controlPoints(points), param(t) {
-        basisMatrix = glm::mat4(
-            glm::vec4(-1.0,  3.0, -3.0, 1.0),
-            glm::vec4( 3.0, -6.0,  3.0, 0.0),
-            glm::vec4(-3.0,  3.0,  0.0, 0.0),
-            glm::vec4( 1.0,  0.0,  0.0, 0.0)
-        );
+        : param(glm::clamp(t, 0.0f, 1.0f)) {
+        setControlPoints(points);
     }
 
     void setParam(float t) {
         param = glm::clamp(t, 0.0f, 1.0f);
+        markDirty();
+    }
+
+    float getParam() const {
+        return param;
+    }
+
+    // with constant speed on, param is the travelled fraction of the curve length
+    void setConstantSpeed(bool enabled) {
+        constantSpeed = enabled;
+        markDirty();
+    }
+
+    bool isConstantSpeed() const {
+        return constantSpeed;
+    }
+
+    void setControlPoints(const std::vector<glm::vec3>& points) {
+        controlPoints = points;
+        rebuildSegments();
+        rebuildArcLength();
+        markDirty();
+    }
+
+    const std::vector<glm::vec3>& getControlPoints() const {
+        return controlPoints;
+    }
+
+    const std::vector<Segment>& getSegments() const {
+        return segments;
+    }
+
+    float getLength() const {
+        return arcLength.empty() ? 0.0f : arcLength.back();
+    }
+
+    // curve position and tangent at t, honouring the constant speed setting
+    void evaluate(float t, glm::vec3& position, glm::vec3& tangent) const {
+        if (segments.empty()) {
+            position = glm::vec3(0);
+            tangent = glm::vec3(0, 0, 1);
+            return;
+        }
+
+        if (constantSpeed) t = distanceToParam(t * getLength());
+
+        int segIdx;
+        float localT;
+        getSegInfo(t, segIdx, localT);
+
+        const Segment& s = segments[segIdx];
+        position = ((s.a * localT + s.b) * localT + s.c) * localT + s.d;
+        tangent = (s.a * (3.0f * localT) + s.b * 2.0f) * localT + s.c;
     }
 
-    glm::mat4 getMatrix() const override {
-        glm::vec3 position = calcPos();
-        glm::vec3 tangent = calcTan();
-        
+protected:
+    glm::mat4 computeMatrix() const override {
+        glm::vec3 position, tangent;
+        evaluate(param, position, tangent);
+
         glm::vec3 forward = glm::normalize(tangent);
         glm::vec3 right = glm::normalize(glm::cross(glm::vec3(0, 1, 0), forward));
         glm::vec3 up = glm::normalize(glm::cross(forward, right));
-        
+
         glm::mat4 transform = glm::mat4(1.0f);
         transform[0] = glm::vec4(right, 0);
         transform[1] = glm::vec4(up, 0);
         transform[2] = glm::vec4(forward, 0);
         transform[3] = glm::vec4(position, 1);
-        
+
         return transform;
     }
 
 private:
+    static constexpr int ARC_SAMPLES_PER_SEGMENT = 32;
+
     std::vector<glm::vec3> controlPoints;
+    std::vector<Segment> segments;
+    // cumulative length at uniformly spaced global params, arcLength[0] == 0
+    std::vector<float> arcLength;
     float param;
-    glm::mat4 basisMatrix;
-    
-    glm::vec3 calcPos() const {
-        if (controlPoints.size() < 4) return glm::vec3(0);
-        
-        int segIdx;
-        float localT;
-        getSegInfo(segIdx, localT);
-        
-        int baseIdx = segIdx * 3;
-        glm::mat3x4 P = glm::mat3x4(
-            controlPoints[baseIdx].x, controlPoints[baseIdx+1].x, 
-            controlPoints[baseIdx+2].x, controlPoints[baseIdx+3].x,
-            
-            controlPoints[baseIdx].y, controlPoints[baseIdx+1].y,
-            controlPoints[baseIdx+2].y, controlPoints[baseIdx+3].y,
-            
-            controlPoints[baseIdx].z, controlPoints[baseIdx+1].z,
-            controlPoints[baseIdx+2].z, controlPoints[baseIdx+3].z 
-        );
-        
-        glm::vec4 T = glm::vec4(
-            localT * localT * localT,
-            localT * localT,
-            localT,
-            1.0f
-        );
-        
-        return T * basisMatrix * P;
+    bool constantSpeed = false;
+
+    void rebuildSegments() {
+        segments.clear();
+        if (controlPoints.size() < 4) return;
+
+        // trailing points that do not make up a full segment are ignored
+        int numSegs = (controlPoints.size() - 1) / 3;
+        segments.reserve(numSegs);
+        for (int i = 0; i < numSegs; ++i) {
+            const glm::vec3& p0 = controlPoints[i * 3];
+            const glm::vec3& p1 = controlPoints[i * 3 + 1];
+            const glm::vec3& p2 = controlPoints[i * 3 + 2];
+            const glm::vec3& p3 = controlPoints[i * 3 + 3];
+
+            Segment s;
+            s.a = -p0 + p1 * 3.0f - p2 * 3.0f + p3;
+            s.b = p0 * 3.0f - p1 * 6.0f + p2 * 3.0f;
+            s.c = (p1 - p0) * 3.0f;
+            s.d = p0;
+            segments.push_back(s);
+        }
     }
-    
-    glm::vec3 calcTan() const {
-        if (controlPoints.size() < 4) return glm::vec3(0, 0, 1);
-        
-        int segIdx;
-        float localT;
-        getSegInfo(segIdx, localT);
-        
-        int baseIdx = segIdx * 3;
-        glm::mat3x4 P = glm::mat3x4(
-            controlPoints[baseIdx].x, controlPoints[baseIdx+1].x, 
-            controlPoints[baseIdx+2].x, controlPoints[baseIdx+3].x,
-            
-            controlPoints[baseIdx].y, controlPoints[baseIdx+1].y,
-            controlPoints[baseIdx+2].y, controlPoints[baseIdx+3].y,
-            
-            controlPoints[baseIdx].z, controlPoints[baseIdx+1].z,
-            controlPoints[baseIdx+2].z, controlPoints[baseIdx+3].z 
-        );
-        
-        glm::vec4 T_derivative = glm::vec4(
-            3.0f * localT * localT,
-            2.0f * localT,
-            1.0f,
-            0.0f 
-        );
-        
-        glm::vec3 tangent = T_derivative * basisMatrix * P;
-        return tangent;
+
+    void rebuildArcLength() {
+        arcLength.clear();
+        if (segments.empty()) return;
+
+        int samples = static_cast<int>(segments.size()) * ARC_SAMPLES_PER_SEGMENT;
+        arcLength.reserve(samples + 1);
+        arcLength.push_back(0.0f);
+
+        glm::vec3 prev = segments[0].d;
+        for (int i = 1; i <= samples; ++i) {
+            int segIdx;
+            float localT;
+            getSegInfo(static_cast<float>(i) / samples, segIdx, localT);
+            const Segment& s = segments[segIdx];
+            glm::vec3 pos = ((s.a * localT + s.b) * localT + s.c) * localT + s.d;
+            arcLength.push_back(arcLength.back() + glm::length(pos - prev));
+            prev = pos;
+        }
     }
-    
+
+    float distanceToParam(float distance) const {
+        if (arcLength.size() < 2 || arcLength.back() <= 0.0f) return 0.0f;
+
+        auto it = std::lower_bound(arcLength.begin(), arcLength.end(), distance);
+        if (it == arcLength.begin()) return 0.0f;
+        if (it == arcLength.end()) return 1.0f;
+
+        int hi = static_cast<int>(it - arcLength.begin());
+        float span = arcLength[hi] - arcLength[hi - 1];
+        float frac = span > 0.0f ? (distance - arcLength[hi - 1]) / span : 0.0f;
+        return (hi - 1 + frac) / (arcLength.size() - 1);
+    }
+
     // which curve segment and local t parameter
-    void getSegInfo(int& segIdx, float& localT) const {
-        int numSeggs = (controlPoints.size() - 1) / 3;
-        if (numSeggs < 1) numSeggs = 1;
-        
-        float globalT = param * numSeggs;
+    void getSegInfo(float t, int& segIdx, float& localT) const {
+        int numSegs = static_cast<int>(segments.size());
+
+        float globalT = t * numSegs;
         segIdx = static_cast<int>(globalT);
-        
-        if (segIdx >= numSeggs) {
-            segIdx = numSeggs - 1;
+
+        if (segIdx >= numSegs) {
+            segIdx = numSegs - 1;
             localT = 1.0f;
         } else {
             localT = globalT - segIdx;
         }
-        
-        int baseIdx = segIdx * 3;
-        if (baseIdx + 3 >= static_cast<int>(controlPoints.size())) {
-            baseIdx = controlPoints.size() - 4;
-            segIdx = baseIdx / 3;
-        }
     }
-};
\ No newline at end of file
+};
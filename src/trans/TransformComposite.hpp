@@ -5,11 +5,24 @@
 
 class TransformComposite : public Transform {
 public:
+    TransformComposite() = default;
+    TransformComposite(const TransformComposite&) = delete;
+    TransformComposite& operator=(const TransformComposite&) = delete;
+
+    ~TransformComposite() override {
+        for (auto& t : transforms) {
+            t->removeParent(this);
+        }
+    }
+
     void add(std::shared_ptr<Transform> t) {
+        t->addParent(this);
         transforms.push_back(t);
+        markDirty();
     }
 
-    glm::mat4 getMatrix() const override {
+protected:
+    glm::mat4 computeMatrix() const override {
         glm::mat4 result(1.0f);
         for (auto& t : transforms) {
             result = result * t->getMatrix();
@@ -19,4 +32,4 @@ public:
 
 private:
     std::vector<std::shared_ptr<Transform>> transforms;
-};
\ No newline at end of file
+};
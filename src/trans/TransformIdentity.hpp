@@ -2,8 +2,8 @@
 #include "Transform.hpp"
 
 class TransformIdentity : public Transform {
-public:
-    glm::mat4 getMatrix() const override {
+protected:
+    glm::mat4 computeMatrix() const override {
         return glm::mat4(1.0f);
     }
 };
\ No newline at end of file
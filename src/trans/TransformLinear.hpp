@@ -9,6 +9,7 @@ public:
 
     void setParam(float t) {
         param = glm::clamp(t, 0.0f, 1.0f);
+        markDirty();
     }
 
     float getParam() const {
@@ -17,10 +18,12 @@ public:
 
     void setStartPoint(const glm::vec3& point) {
         start = point;
+        markDirty();
     }
 
     void setEndPoint(const glm::vec3& point) {
         end = point;
+        markDirty();
     }
 
     glm::vec3 getStartPoint() const {
@@ -35,7 +38,8 @@ public:
         return glm::mix(start, end, param);
     }
 
-    glm::mat4 getMatrix() const override {
+protected:
+    glm::mat4 computeMatrix() const override {
         glm::vec3 position = getPosOnPath();
         return glm::translate(glm::mat4(1.0f), position);
     }
@@ -4,7 +4,8 @@
 class TransformMatrix : public Transform {
 public:
     TransformMatrix(const glm::mat4& m) : matrix(m) {}
-    glm::mat4 getMatrix() const override {
+protected:
+    glm::mat4 computeMatrix() const override {
         return matrix;
     }
 
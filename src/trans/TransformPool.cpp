@@ -0,0 +1,253 @@
+#include "TransformPool.hpp"
+#include "../ThreadPool.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRANSFORM_POOL_X86 1
+#endif
+
+namespace {
+
+struct SoAView {
+    const float *tx, *ty, *tz;
+    const float *qx, *qy, *qz, *qw;
+    const float *sx, *sy, *sz;
+    float* out;
+};
+
+using Kernel = void (*)(const SoAView&, size_t, size_t);
+
+void composeScalar(const SoAView& v, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        float x = v.qx[i], y = v.qy[i], z = v.qz[i], w = v.qw[i];
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z;
+        float wx = w * x, wy = w * y, wz = w * z;
+        float* m = v.out + i * 16;
+
+        m[0] = (1.0f - 2.0f * (yy + zz)) * v.sx[i];
+        m[1] = 2.0f * (xy + wz) * v.sx[i];
+        m[2] = 2.0f * (xz - wy) * v.sx[i];
+        m[3] = 0.0f;
+        m[4] = 2.0f * (xy - wz) * v.sy[i];
+        m[5] = (1.0f - 2.0f * (xx + zz)) * v.sy[i];
+        m[6] = 2.0f * (yz + wx) * v.sy[i];
+        m[7] = 0.0f;
+        m[8] = 2.0f * (xz + wy) * v.sz[i];
+        m[9] = 2.0f * (yz - wx) * v.sz[i];
+        m[10] = (1.0f - 2.0f * (xx + yy)) * v.sz[i];
+        m[11] = 0.0f;
+        m[12] = v.tx[i];
+        m[13] = v.ty[i];
+        m[14] = v.tz[i];
+        m[15] = 1.0f;
+    }
+}
+
+#ifdef TRANSFORM_POOL_X86
+// c0..c3 hold one matrix column for four objects, lane by lane
+inline void storeColumns(float* out, __m128 c0, __m128 c1, __m128 c2, __m128 c3, int column) {
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(out + 0 * 16 + column * 4, c0);
+    _mm_storeu_ps(out + 1 * 16 + column * 4, c1);
+    _mm_storeu_ps(out + 2 * 16 + column * 4, c2);
+    _mm_storeu_ps(out + 3 * 16 + column * 4, c3);
+}
+
+void composeSSE(const SoAView& v, size_t begin, size_t end) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (size_t i = begin; i < end; i += 4) {
+        __m128 x = _mm_loadu_ps(v.qx + i), y = _mm_loadu_ps(v.qy + i);
+        __m128 z = _mm_loadu_ps(v.qz + i), w = _mm_loadu_ps(v.qw + i);
+        __m128 sx = _mm_loadu_ps(v.sx + i), sy = _mm_loadu_ps(v.sy + i), sz = _mm_loadu_ps(v.sz + i);
+
+        __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+        __m128 m0 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        __m128 m1 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        __m128 m2 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+        __m128 m4 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        __m128 m5 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        __m128 m6 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+        __m128 m8 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        __m128 m9 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        __m128 m10 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+
+        float* out = v.out + i * 16;
+        storeColumns(out, m0, m1, m2, zero, 0);
+        storeColumns(out, m4, m5, m6, zero, 1);
+        storeColumns(out, m8, m9, m10, zero, 2);
+        storeColumns(out, _mm_loadu_ps(v.tx + i), _mm_loadu_ps(v.ty + i), _mm_loadu_ps(v.tz + i), one, 3);
+    }
+}
+
+__attribute__((target("avx2")))
+void composeAVX2(const SoAView& v, size_t begin, size_t end) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (size_t i = begin; i < end; i += 8) {
+        __m256 x = _mm256_loadu_ps(v.qx + i), y = _mm256_loadu_ps(v.qy + i);
+        __m256 z = _mm256_loadu_ps(v.qz + i), w = _mm256_loadu_ps(v.qw + i);
+        __m256 sx = _mm256_loadu_ps(v.sx + i), sy = _mm256_loadu_ps(v.sy + i), sz = _mm256_loadu_ps(v.sz + i);
+
+        __m256 x2 = _mm256_mul_ps(two, x), y2 = _mm256_mul_ps(two, y), z2 = _mm256_mul_ps(two, z);
+        __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+        __m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+        __m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+        __m256 cols[16] = {
+            _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+            _mm256_mul_ps(_mm256_add_ps(xy, wz), sx),
+            _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx),
+            zero,
+            _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+            _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+            _mm256_mul_ps(_mm256_add_ps(yz, wx), sy),
+            zero,
+            _mm256_mul_ps(_mm256_add_ps(xz, wy), sz),
+            _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+            _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+            zero,
+            _mm256_loadu_ps(v.tx + i),
+            _mm256_loadu_ps(v.ty + i),
+            _mm256_loadu_ps(v.tz + i),
+            one
+        };
+
+        // the lower and upper halves are two independent groups of four objects
+        float* out = v.out + i * 16;
+        for (int c = 0; c < 4; ++c) {
+            storeColumns(out, _mm256_castps256_ps128(cols[c * 4 + 0]), _mm256_castps256_ps128(cols[c * 4 + 1]),
+                         _mm256_castps256_ps128(cols[c * 4 + 2]), _mm256_castps256_ps128(cols[c * 4 + 3]), c);
+            storeColumns(out + 4 * 16, _mm256_extractf128_ps(cols[c * 4 + 0], 1), _mm256_extractf128_ps(cols[c * 4 + 1], 1),
+                         _mm256_extractf128_ps(cols[c * 4 + 2], 1), _mm256_extractf128_ps(cols[c * 4 + 3], 1), c);
+        }
+    }
+}
+#endif
+
+Kernel selectKernel() {
+#ifdef TRANSFORM_POOL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return composeAVX2;
+    return composeSSE;
+#else
+    return composeScalar;
+#endif
+}
+
+Kernel activeKernel() {
+    static Kernel kernel = selectKernel();
+    return kernel;
+}
+
+}
+
+TransformPool::~TransformPool() {
+    for (auto* ref : refs) {
+        if (ref) ref->detach();
+    }
+}
+
+void TransformPool::reserve(size_t n) {
+    size_t padded = (n + 7) & ~size_t(7);
+    for (auto* arr : {&tx, &ty, &tz, &qx, &qy, &qz, &qw, &sx, &sy, &sz}) {
+        arr->reserve(padded);
+    }
+    world.reserve(padded);
+    changed.reserve(n);
+    refs.reserve(n);
+}
+
+uint32_t TransformPool::add(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+    uint32_t idx = static_cast<uint32_t>(count++);
+    if (tx.size() < count) {
+        // grow by a whole block of identity transforms
+        size_t padded = tx.size() + 8;
+        for (auto* arr : {&tx, &ty, &tz, &qx, &qy, &qz, &sx, &sy, &sz}) {
+            arr->resize(padded, 0.0f);
+        }
+        qw.resize(padded, 1.0f);
+        world.resize(padded, glm::mat4(1.0f));
+    }
+    changed.push_back(0);
+    refs.push_back(nullptr);
+
+    setTranslation(idx, translation);
+    setRotation(idx, rotation);
+    setScale(idx, scale);
+    return idx;
+}
+
+void TransformPool::setTranslation(uint32_t idx, const glm::vec3& t) {
+    tx[idx] = t.x;
+    ty[idx] = t.y;
+    tz[idx] = t.z;
+    markChanged(idx);
+}
+
+void TransformPool::setRotation(uint32_t idx, const glm::quat& q) {
+    qx[idx] = q.x;
+    qy[idx] = q.y;
+    qz[idx] = q.z;
+    qw[idx] = q.w;
+    markChanged(idx);
+}
+
+void TransformPool::setScale(uint32_t idx, const glm::vec3& s) {
+    sx[idx] = s.x;
+    sy[idx] = s.y;
+    sz[idx] = s.z;
+    markChanged(idx);
+}
+
+void TransformPool::update() {
+    if (!anyChanged) return;
+
+    SoAView view{
+        tx.data(), ty.data(), tz.data(),
+        qx.data(), qy.data(), qz.data(), qw.data(),
+        sx.data(), sy.data(), sz.data(),
+        reinterpret_cast<float*>(world.data())
+    };
+    Kernel kernel = activeKernel();
+    int blocks = static_cast<int>(tx.size() / 8);
+
+    // recomputing everything in one sweep is cheaper than branching per object
+    if (workers && blocks * 8 >= minObjectsPerTask * 2) {
+        workers->parallelFor(blocks, minObjectsPerTask / 8, [&](int begin, int end) {
+            kernel(view, static_cast<size_t>(begin) * 8, static_cast<size_t>(end) * 8);
+        });
+    } else {
+        kernel(view, 0, tx.size());
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!changed[i]) continue;
+        changed[i] = 0;
+        if (refs[i]) refs[i]->invalidate();
+    }
+    anyChanged = false;
+}
+
+std::shared_ptr<Transform> TransformPool::makeTransform(uint32_t idx) {
+    auto ref = std::make_shared<TransformPoolRef>(this, idx);
+    refs[idx] = ref.get();
+    return ref;
+}
+
+const char* TransformPool::getKernelName() {
+    Kernel kernel = activeKernel();
+#ifdef TRANSFORM_POOL_X86
+    if (kernel == composeAVX2) return "AVX2";
+    if (kernel == composeSSE) return "SSE";
+#endif
+    return kernel == composeScalar ? "scalar" : "unknown";
+}
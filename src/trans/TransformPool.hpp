@@ -0,0 +1,88 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Transform.hpp"
+
+class ThreadPool;
+class TransformPoolRef;
+
+// translation, rotation and scale of many objects kept as separate float arrays;
+// update() turns all of them into world matrices in one pass with SSE or AVX2
+// kernels picked at runtime, optionally split over a thread pool
+class TransformPool {
+public:
+    TransformPool() = default;
+    ~TransformPool();
+    TransformPool(const TransformPool&) = delete;
+    TransformPool& operator=(const TransformPool&) = delete;
+
+    uint32_t add(const glm::vec3& translation, const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                 const glm::vec3& scale = glm::vec3(1.0f));
+    void reserve(size_t count);
+    size_t size() const { return count; }
+
+    void setTranslation(uint32_t idx, const glm::vec3& t);
+    void setRotation(uint32_t idx, const glm::quat& q);
+    void setScale(uint32_t idx, const glm::vec3& s);
+    glm::vec3 getTranslation(uint32_t idx) const { return glm::vec3(tx[idx], ty[idx], tz[idx]); }
+
+    void setWorkers(ThreadPool* pool, int minPerTask = 512) {
+        workers = pool;
+        minObjectsPerTask = minPerTask;
+    }
+
+    void update();
+    const glm::mat4& getWorld(uint32_t idx) const { return world[idx]; }
+    const glm::mat4* getWorldData() const { return world.data(); }
+
+    // adapter so pooled objects can go wherever a Transform is expected
+    std::shared_ptr<Transform> makeTransform(uint32_t idx);
+
+    // which kernel update() uses on this machine
+    static const char* getKernelName();
+
+private:
+    friend class TransformPoolRef;
+
+    size_t count = 0;
+    // padded to a multiple of 8 so kernels never need a scalar tail
+    std::vector<float> tx, ty, tz;
+    std::vector<float> qx, qy, qz, qw;
+    std::vector<float> sx, sy, sz;
+    std::vector<glm::mat4> world;
+    std::vector<uint8_t> changed;
+    std::vector<TransformPoolRef*> refs;
+    bool anyChanged = false;
+
+    ThreadPool* workers = nullptr;
+    int minObjectsPerTask = 512;
+
+    void markChanged(uint32_t idx) {
+        changed[idx] = 1;
+        anyChanged = true;
+    }
+};
+
+class TransformPoolRef : public Transform {
+public:
+    TransformPoolRef(TransformPool* pool, uint32_t idx) : pool(pool), idx(idx) {}
+    ~TransformPoolRef() override {
+        if (pool) pool->refs[idx] = nullptr;
+    }
+
+    uint32_t getIndex() const { return idx; }
+    void invalidate() { markDirty(); }
+    void detach() { pool = nullptr; }
+
+protected:
+    glm::mat4 computeMatrix() const override {
+        return pool ? pool->getWorld(idx) : glm::mat4(1.0f);
+    }
+
+private:
+    TransformPool* pool;
+    uint32_t idx;
+};
@@ -8,6 +8,7 @@ public:
     
     void setAngle(float angleDeg) {
         angle = angleDeg;
+        markDirty();
     }
     
     float getAngle() const {
@@ -16,13 +17,15 @@ public:
     
     void setAxis(const glm::vec3& newAxis) {
         axis = newAxis;
+        markDirty();
     }
     
     glm::vec3 getAxis() const {
         return axis;
     }
     
-    glm::mat4 getMatrix() const override {
+protected:
+    glm::mat4 computeMatrix() const override {
         return glm::rotate(glm::mat4(1.0f), glm::radians(angle), axis);
     }
 
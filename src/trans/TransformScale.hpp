@@ -5,7 +5,18 @@ class TransformScale : public Transform {
 public:
     TransformScale(const glm::vec3& scale) : scaleVec(scale) {}
     TransformScale(float uniformScale) : scaleVec(uniformScale, uniformScale, uniformScale) {}
-    glm::mat4 getMatrix() const override {
+
+    void setScale(const glm::vec3& scale) {
+        scaleVec = scale;
+        markDirty();
+    }
+
+    glm::vec3 getScale() const {
+        return scaleVec;
+    }
+
+protected:
+    glm::mat4 computeMatrix() const override {
         return glm::scale(glm::mat4(1.0f), scaleVec);
     }
 
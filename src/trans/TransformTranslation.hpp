@@ -5,18 +5,20 @@ class TransformTranslation : public Transform {
 public:
     TransformTranslation(const glm::vec3& offset) : offset(offset) {}
     
-    glm::mat4 getMatrix() const override {
-        return glm::translate(glm::mat4(1.0f), offset);
-    }
-    
     void setOffset(const glm::vec3& newOffset) {
         offset = newOffset;
+        markDirty();
     }
     
     glm::vec3 getOffset() const {
         return offset;
     }
 
+protected:
+    glm::mat4 computeMatrix() const override {
+        return glm::translate(glm::mat4(1.0f), offset);
+    }
+
 private:
     glm::vec3 offset;
-};
\ No newline at end of file
+};
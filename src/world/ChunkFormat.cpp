@@ -0,0 +1,134 @@
+#include "ChunkFormat.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+const char MAGIC[4] = {'K', 'M', 'S', 'C'};
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    int32_t x;
+    int32_t z;
+    uint32_t vertexFloats;
+    uint32_t indexCount;
+    uint32_t propCount;
+};
+
+struct PropRecord {
+    uint32_t model;
+    float position[3];
+    float yaw;
+    float scale;
+};
+
+template <typename T>
+bool readArray(std::ifstream& in, std::vector<T>& out, uint32_t count) {
+    out.resize(count);
+    in.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<bool>(in);
+}
+}
+
+namespace ChunkFile {
+std::string path(const std::string& directory, ChunkCoord coord) {
+    return directory + "/chunk_" + std::to_string(coord.x) + "_" + std::to_string(coord.z) + ".bin";
+}
+
+bool write(const std::string& path, const ChunkData& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Can't write chunk file " << path << "!!!" << std::endl;
+        return false;
+    }
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.x = data.coord.x;
+    header.z = data.coord.z;
+    header.vertexFloats = static_cast<uint32_t>(data.terrainVertices.size());
+    header.indexCount = static_cast<uint32_t>(data.terrainIndices.size());
+    header.propCount = static_cast<uint32_t>(data.props.size());
+
+    std::vector<PropRecord> props;
+    props.reserve(data.props.size());
+    for (const auto& p : data.props) {
+        props.push_back({p.model, {p.position.x, p.position.y, p.position.z}, p.yaw, p.scale});
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(data.terrainVertices.data()), header.vertexFloats * sizeof(float));
+    out.write(reinterpret_cast<const char*>(data.terrainIndices.data()), header.indexCount * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(props.data()), props.size() * sizeof(PropRecord));
+    return static_cast<bool>(out);
+}
+
+bool read(const std::string& path, ChunkData& data) {
+    data = ChunkData();
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+
+    Header header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        std::cerr << "Chunk file " << path << " is not a version " << VERSION << " chunk!!!" << std::endl;
+        return false;
+    }
+    // the counts come from the file, check them before allocating anything
+    uint64_t payload = static_cast<uint64_t>(header.vertexFloats) * sizeof(float) +
+                       static_cast<uint64_t>(header.indexCount) * sizeof(uint32_t) +
+                       static_cast<uint64_t>(header.propCount) * sizeof(PropRecord);
+    if (payload != fileSize - sizeof(header) || header.vertexFloats % TERRAIN_STRIDE != 0) {
+        std::cerr << "Chunk file " << path << " doesn't match its header!!!" << std::endl;
+        return false;
+    }
+
+    std::vector<PropRecord> props;
+    if (!readArray(in, data.terrainVertices, header.vertexFloats) ||
+        !readArray(in, data.terrainIndices, header.indexCount) || !readArray(in, props, header.propCount)) {
+        std::cerr << "Can't read chunk file " << path << "!!!" << std::endl;
+        data = ChunkData();
+        return false;
+    }
+    uint32_t vertexCount = header.vertexFloats / TERRAIN_STRIDE;
+    for (uint32_t idx : data.terrainIndices) {
+        if (idx >= vertexCount) {
+            std::cerr << "Chunk file " << path << " indexes past its vertices!!!" << std::endl;
+            data = ChunkData();
+            return false;
+        }
+    }
+
+    data.coord = {header.x, header.z};
+    data.props.reserve(props.size());
+    for (const auto& p : props) {
+        data.props.push_back({p.model, glm::vec3(p.position[0], p.position[1], p.position[2]), p.yaw, p.scale});
+    }
+    return true;
+}
+
+std::string infoPath(const std::string& directory) {
+    return directory + "/world.info";
+}
+
+bool writeInfo(const std::string& directory, const WorldInfo& info) {
+    std::ofstream out(infoPath(directory), std::ios::trunc);
+    if (!out) {
+        std::cerr << "Can't write " << infoPath(directory) << "!!!" << std::endl;
+        return false;
+    }
+    out << VERSION << " " << info.chunkSize << " " << info.min.x << " " << info.min.z << " " << info.max.x << " "
+        << info.max.z << "\n";
+    return static_cast<bool>(out);
+}
+
+bool readInfo(const std::string& directory, WorldInfo& info) {
+    std::ifstream in(infoPath(directory));
+    uint32_t version = 0;
+    if (!(in >> version >> info.chunkSize >> info.min.x >> info.min.z >> info.max.x >> info.max.z)) return false;
+    return version == VERSION && info.chunkSize > 0.0f;
+}
+}
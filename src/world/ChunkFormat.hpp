@@ -0,0 +1,71 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct ChunkCoord {
+    int32_t x = 0;
+    int32_t z = 0;
+
+    bool operator==(const ChunkCoord& o) const { return x == o.x && z == o.z; }
+    bool operator!=(const ChunkCoord& o) const { return !(*this == o); }
+};
+
+struct ChunkCoordHash {
+    size_t operator()(const ChunkCoord& c) const {
+        return std::hash<uint64_t>()((static_cast<uint64_t>(static_cast<uint32_t>(c.x)) << 32) |
+                                     static_cast<uint32_t>(c.z));
+    }
+};
+
+// one placed prop, model indexes the palette the world was built with
+struct ChunkProp {
+    uint32_t model;
+    glm::vec3 position;
+    float yaw;
+    float scale;
+};
+
+// CPU side content of one chunk, loaded on a worker and uploaded on the
+// thread owning the GL context
+struct ChunkData {
+    ChunkCoord coord;
+    // world space terrain, position/normal/uv (ModelType::UV), indexed
+    std::vector<float> terrainVertices;
+    std::vector<uint32_t> terrainIndices;
+    // sorted by model
+    std::vector<ChunkProp> props;
+
+    bool isEmpty() const { return terrainIndices.empty() && props.empty(); }
+};
+
+// what a built world covers, written next to its chunks
+struct WorldInfo {
+    float chunkSize = 32.0f;
+    // inclusive range of chunk coordinates that have a file
+    ChunkCoord min;
+    ChunkCoord max;
+
+    bool contains(ChunkCoord c) const { return c.x >= min.x && c.x <= max.x && c.z >= min.z && c.z <= max.z; }
+};
+
+// one little-endian file per chunk:
+//   "KMSC" | version u32 | x i32 | z i32 | vertex floats u32 | indices u32 | props u32
+//   | vertices f32[] | indices u32[] | props (model u32, position f32[3], yaw f32, scale f32)[]
+namespace ChunkFile {
+constexpr uint32_t VERSION = 1;
+constexpr int TERRAIN_STRIDE = 8;
+
+std::string path(const std::string& directory, ChunkCoord coord);
+bool write(const std::string& path, const ChunkData& data);
+// false when the file is missing, broken or its size disagrees with the
+// header, data is left empty then
+bool read(const std::string& path, ChunkData& data);
+
+std::string infoPath(const std::string& directory);
+bool writeInfo(const std::string& directory, const WorldInfo& info);
+bool readInfo(const std::string& directory, WorldInfo& info);
+}
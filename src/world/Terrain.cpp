@@ -0,0 +1,321 @@
+#include "Terrain.hpp"
+#include "../AssetCache.hpp"
+#include "../Model.hpp"
+#include "../ThreadPool.hpp"
+#include "../renderers/Shader.hpp"
+#include "../renderers/Texture.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+Heightmap::Heightmap(int width, int height, const glm::vec2& origin, const glm::vec2& size,
+                     std::vector<float> heights)
+    : width(width), height(height), origin(origin), size(size), heights(std::move(heights)) {
+    if (width < 2 || height < 2 || this->heights.size() != static_cast<size_t>(width) * height) {
+        std::cerr << "Heightmap needs at least 2x2 samples matching its size!!!" << std::endl;
+        this->heights.clear();
+    }
+}
+
+Heightmap Heightmap::FromFunction(int width, int height, const glm::vec2& origin, const glm::vec2& size,
+                                  const std::function<float(float, float)>& f, ThreadPool* workers) {
+    std::vector<float> heights(static_cast<size_t>(width) * height);
+    auto fillRows = [&](int begin, int end) {
+        for (int z = begin; z < end; ++z) {
+            float wz = origin.y + static_cast<float>(z) / (height - 1) * size.y;
+            for (int x = 0; x < width; ++x) {
+                heights[z * width + x] = f(origin.x + static_cast<float>(x) / (width - 1) * size.x, wz);
+            }
+        }
+    };
+    if (workers) {
+        workers->parallelFor(height, 16, fillRows);
+    } else {
+        fillRows(0, height);
+    }
+    return Heightmap(width, height, origin, size, std::move(heights));
+}
+
+Heightmap Heightmap::FromImage(const std::string& path, const glm::vec2& origin, const glm::vec2& size,
+                               float minHeight, float maxHeight) {
+    ImageData image;
+    if (!Texture::DecodeImage(path, false, image)) return Heightmap();
+    std::vector<float> heights(static_cast<size_t>(image.width) * image.height);
+    for (size_t i = 0; i < heights.size(); ++i) {
+        heights[i] = minHeight + image.pixels[i * image.channels] / 255.0f * (maxHeight - minHeight);
+    }
+    return Heightmap(image.width, image.height, origin, size, std::move(heights));
+}
+
+glm::vec2 Heightmap::getSpacing() const {
+    return size / glm::vec2(static_cast<float>(width - 1), static_cast<float>(height - 1));
+}
+
+float Heightmap::sample(int x, int z) const {
+    x = std::clamp(x, 0, width - 1);
+    z = std::clamp(z, 0, height - 1);
+    return heights[z * width + x];
+}
+
+float Heightmap::heightAt(float x, float z) const {
+    if (heights.empty()) return 0.0f;
+    float fx = std::clamp((x - origin.x) / size.x * (width - 1), 0.0f, static_cast<float>(width - 1));
+    float fz = std::clamp((z - origin.y) / size.y * (height - 1), 0.0f, static_cast<float>(height - 1));
+    int x0 = static_cast<int>(fx);
+    int z0 = static_cast<int>(fz);
+    float tx = fx - x0;
+    float tz = fz - z0;
+    float top = sample(x0, z0) * (1.0f - tx) + sample(x0 + 1, z0) * tx;
+    float bottom = sample(x0, z0 + 1) * (1.0f - tx) + sample(x0 + 1, z0 + 1) * tx;
+    return top * (1.0f - tz) + bottom * tz;
+}
+
+glm::vec3 Heightmap::normalAt(float x, float z) const {
+    glm::vec2 spacing = getSpacing();
+    float dx = heightAt(x + spacing.x, z) - heightAt(x - spacing.x, z);
+    float dz = heightAt(x, z + spacing.y) - heightAt(x, z - spacing.y);
+    return glm::normalize(glm::vec3(-dx / (2.0f * spacing.x), 1.0f, -dz / (2.0f * spacing.y)));
+}
+
+bool Heightmap::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, glm::vec3& hit) const {
+    if (heights.empty()) return false;
+    glm::vec2 spacing = getSpacing();
+    float step = 0.5f * std::min(spacing.x, spacing.y);
+    float prevT = 0.0f;
+    // starting under the surface counts as no hit
+    if (origin.y < heightAt(origin.x, origin.z)) return false;
+
+    int steps = static_cast<int>(std::ceil(maxDistance / step));
+    for (int i = 1; i <= steps; ++i) {
+        float t = std::min(i * step, maxDistance);
+        glm::vec3 p = origin + dir * t;
+        if (p.y <= heightAt(p.x, p.z)) {
+            float lo = prevT;
+            float hi = t;
+            for (int k = 0; k < 12; ++k) {
+                float mid = 0.5f * (lo + hi);
+                glm::vec3 m = origin + dir * mid;
+                if (m.y <= heightAt(m.x, m.z)) {
+                    hi = mid;
+                } else {
+                    lo = mid;
+                }
+            }
+            hit = origin + dir * hi;
+            return true;
+        }
+        prevT = t;
+    }
+    return false;
+}
+
+glm::vec2 Heightmap::heightRange(const glm::vec2& min, const glm::vec2& max) const {
+    if (heights.empty()) return glm::vec2(0.0f);
+    glm::vec2 spacing = getSpacing();
+    int x0 = std::clamp(static_cast<int>(std::floor((min.x - origin.x) / spacing.x)), 0, width - 1);
+    int z0 = std::clamp(static_cast<int>(std::floor((min.y - origin.y) / spacing.y)), 0, height - 1);
+    int x1 = std::clamp(static_cast<int>(std::ceil((max.x - origin.x) / spacing.x)), 0, width - 1);
+    int z1 = std::clamp(static_cast<int>(std::ceil((max.y - origin.y) / spacing.y)), 0, height - 1);
+    glm::vec2 range(1e30f, -1e30f);
+    for (int z = z0; z <= z1; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+            float h = heights[z * width + x];
+            range.x = std::min(range.x, h);
+            range.y = std::max(range.y, h);
+        }
+    }
+    return range;
+}
+
+Terrain::Terrain(Heightmap heightmap, const Settings& settings)
+    : heightmap(std::move(heightmap)), settings(settings) {
+    this->settings.patchResolution = std::max(2, settings.patchResolution & ~1);
+    this->settings.lodLevels = std::clamp(settings.lodLevels, 1, 12);
+    for (int l = 0; l < this->settings.lodLevels; ++l) ranges.push_back(settings.baseRange * static_cast<float>(1 << l));
+
+    buildPatch();
+    if (this->heightmap.isEmpty()) return;
+    buildNodeHeights();
+    uploadTextures();
+}
+
+Terrain::~Terrain() {
+    if (heightTexture) glDeleteTextures(1, &heightTexture);
+    if (normalTexture) glDeleteTextures(1, &normalTexture);
+}
+
+void Terrain::setSurface(Texture* texture, float tiling) {
+    surface = texture;
+    surfaceTiling = tiling;
+}
+
+void Terrain::buildPatch() {
+    int n = settings.patchResolution;
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    vertices.reserve((n + 1) * (n + 1) * 3);
+    for (int z = 0; z <= n; ++z) {
+        for (int x = 0; x <= n; ++x) {
+            vertices.push_back(static_cast<float>(x) / n);
+            vertices.push_back(0.0f);
+            vertices.push_back(static_cast<float>(z) / n);
+        }
+    }
+    for (int z = 0; z < n; ++z) {
+        for (int x = 0; x < n; ++x) {
+            uint32_t a = z * (n + 1) + x;
+            uint32_t b = a + n + 1;
+            indices.insert(indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+    patch = std::make_unique<Model>(vertices, indices, 3, ModelType::BASIC);
+}
+
+void Terrain::buildNodeHeights() {
+    nodeHeights.assign(settings.lodLevels, {});
+    int leaves = nodesAcross(0);
+    glm::vec2 leafSize = nodeSize(0);
+    nodeHeights[0].resize(static_cast<size_t>(leaves) * leaves);
+    for (int z = 0; z < leaves; ++z) {
+        for (int x = 0; x < leaves; ++x) {
+            glm::vec2 min = heightmap.getOrigin() + glm::vec2(x, z) * leafSize;
+            nodeHeights[0][z * leaves + x] = heightmap.heightRange(min, min + leafSize);
+        }
+    }
+    for (int l = 1; l < settings.lodLevels; ++l) {
+        int n = nodesAcross(l);
+        int children = nodesAcross(l - 1);
+        nodeHeights[l].resize(static_cast<size_t>(n) * n);
+        for (int z = 0; z < n; ++z) {
+            for (int x = 0; x < n; ++x) {
+                glm::vec2 range(1e30f, -1e30f);
+                for (int c = 0; c < 4; ++c) {
+                    glm::vec2 child = nodeHeights[l - 1][(2 * z + c / 2) * children + 2 * x + c % 2];
+                    range = glm::vec2(std::min(range.x, child.x), std::max(range.y, child.y));
+                }
+                nodeHeights[l][z * n + x] = range;
+            }
+        }
+    }
+}
+
+void Terrain::uploadTextures() {
+    int w = heightmap.getWidth();
+    int h = heightmap.getHeight();
+
+    // normals packed to bytes, like a normal map
+    std::vector<unsigned char> normals(static_cast<size_t>(w) * h * 4);
+    glm::vec2 spacing = heightmap.getSpacing();
+    for (int z = 0; z < h; ++z) {
+        for (int x = 0; x < w; ++x) {
+            glm::vec3 n = heightmap.normalAt(heightmap.getOrigin().x + x * spacing.x,
+                                             heightmap.getOrigin().y + z * spacing.y);
+            unsigned char* out = &normals[(static_cast<size_t>(z) * w + x) * 4];
+            out[0] = static_cast<unsigned char>((n.x * 0.5f + 0.5f) * 255.0f + 0.5f);
+            out[1] = static_cast<unsigned char>((n.y * 0.5f + 0.5f) * 255.0f + 0.5f);
+            out[2] = static_cast<unsigned char>((n.z * 0.5f + 0.5f) * 255.0f + 0.5f);
+            out[3] = 255;
+        }
+    }
+
+    GLuint textures[2];
+    glGenTextures(2, textures);
+    heightTexture = textures[0];
+    normalTexture = textures[1];
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, w, h, 0, GL_RED, GL_FLOAT, heightmap.getHeights().data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindTexture(GL_TEXTURE_2D, normalTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, normals.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+glm::vec2 Terrain::nodeSize(int level) const {
+    return heightmap.getSize() / static_cast<float>(nodesAcross(level));
+}
+
+Aabb Terrain::nodeBounds(int level, int x, int z) const {
+    glm::vec2 size = nodeSize(level);
+    glm::vec2 min = heightmap.getOrigin() + glm::vec2(x, z) * size;
+    glm::vec2 heights = nodeHeights[level][z * nodesAcross(level) + x];
+    return {glm::vec3(min.x, heights.x, min.y), glm::vec3(min.x + size.x, heights.y, min.y + size.y)};
+}
+
+void Terrain::select(int level, int x, int z, const glm::vec3& eye, const Frustum& frustum) {
+    Aabb box = nodeBounds(level, x, z);
+    if (frustum.test(box) == Frustum::Result::OUTSIDE) return;
+
+    // split while any part of the node is within the finer level's range
+    bool split = false;
+    if (level > 0) {
+        glm::vec3 closest = glm::clamp(eye, box.min, box.max);
+        split = glm::length(closest - eye) < ranges[level - 1];
+    }
+    if (!split) {
+        selected.push_back({level, x, z});
+        return;
+    }
+    for (int c = 0; c < 4; ++c) select(level - 1, 2 * x + c % 2, 2 * z + c / 2, eye, frustum);
+}
+
+size_t Terrain::getVertexCount() const {
+    return selected.size() * static_cast<size_t>(patch->getVertexCount());
+}
+
+void Terrain::draw(Shader& shader, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos) {
+    selected.clear();
+    if (heightmap.isEmpty()) return;
+    select(settings.lodLevels - 1, 0, 0, viewPos, Frustum(projection * view));
+    if (selected.empty()) return;
+
+    shader.use();
+    shader.SetUniform("view", view);
+    shader.SetUniform("projection", projection);
+    shader.SetUniform("viewPos", viewPos);
+    shader.SetUniform("terrainOrigin", heightmap.getOrigin());
+    shader.SetUniform("terrainSize", heightmap.getSize());
+    shader.SetUniform("heightMapSize", glm::vec2(heightmap.getWidth(), heightmap.getHeight()));
+    shader.SetUniform("gridResolution", static_cast<float>(settings.patchResolution));
+    shader.SetUniform("textureTiling", surfaceTiling);
+    shader.SetUniform("heightMap", 1);
+    shader.SetUniform("normalMap", 2);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, heightTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, normalTexture);
+    glActiveTexture(GL_TEXTURE0);
+    if (surface) {
+        surface->bind(0);
+        shader.SetUniform("textureSampler", 0);
+    }
+    shader.SetUniform("useTexture", surface != nullptr);
+
+    for (const Node& node : selected) {
+        glm::vec2 size = nodeSize(node.level);
+        float end = ranges[node.level];
+        // the top level has nothing coarser to morph into
+        float start = node.level == settings.lodLevels - 1 ? 1e30f : end * settings.morphStart;
+        shader.SetUniform("patchOffset", heightmap.getOrigin() + glm::vec2(node.x, node.z) * size);
+        shader.SetUniform("patchSize", size);
+        shader.SetUniform("morphRange", glm::vec2(start, std::max(end, start + 1e-3f)));
+        patch->draw();
+    }
+
+    if (surface) surface->unbind();
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../spatial/Bounds.hpp"
+
+class Model;
+class Shader;
+class Texture;
+class ThreadPool;
+
+// heights on a regular grid over a rectangle of the XZ plane, sample (0, 0)
+// at origin and the last one at origin + size; queries outside clamp to the edge
+class Heightmap {
+public:
+    Heightmap() = default;
+    Heightmap(int width, int height, const glm::vec2& origin, const glm::vec2& size, std::vector<float> heights);
+
+    // f gets world x and z of every sample, evaluated on the workers when given
+    static Heightmap FromFunction(int width, int height, const glm::vec2& origin, const glm::vec2& size,
+                                  const std::function<float(float, float)>& f, ThreadPool* workers = nullptr);
+    // first channel of an image mapped to [minHeight, maxHeight], top row at the -z edge
+    static Heightmap FromImage(const std::string& path, const glm::vec2& origin, const glm::vec2& size,
+                               float minHeight, float maxHeight);
+
+    // bilinear, the same filtering the vertex shader gets from the texture
+    float heightAt(float x, float z) const;
+    glm::vec3 normalAt(float x, float z) const;
+    // first crossing of the surface along a normalized direction, refined by bisection
+    bool raycast(const glm::vec3& origin, const glm::vec3& dir, float maxDistance, glm::vec3& hit) const;
+    // lowest and highest sample in a world rectangle
+    glm::vec2 heightRange(const glm::vec2& min, const glm::vec2& max) const;
+
+    bool isEmpty() const { return heights.empty(); }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const glm::vec2& getOrigin() const { return origin; }
+    const glm::vec2& getSize() const { return size; }
+    // world distance between neighbouring samples
+    glm::vec2 getSpacing() const;
+    const std::vector<float>& getHeights() const { return heights; }
+
+private:
+    int width = 0;
+    int height = 0;
+    glm::vec2 origin = glm::vec2(0.0f);
+    glm::vec2 size = glm::vec2(1.0f);
+    std::vector<float> heights;
+
+    float sample(int x, int z) const;
+};
+
+// continuous distance-dependent LOD over a heightmap: a quadtree whose
+// selected nodes each draw the same grid patch, scaled to the node, with
+// heights and normals read from textures in the vertex shader. every LOD
+// level covers twice the distance of the one below it, and vertices near the
+// end of a level's range morph onto the next coarser grid, so neighbouring
+// levels meet without cracks or popping. the vertex count depends on the
+// view and the settings, not on the terrain's extent
+class Terrain {
+public:
+    struct Settings {
+        // quads along a patch edge, even so every other vertex can morph away
+        int patchResolution = 16;
+        // quadtree depth, the finest nodes are size / 2^(lodLevels - 1) wide
+        int lodLevels = 7;
+        // the finest level is drawn out to this distance, each next one twice as far
+        float baseRange = 32.0f;
+        // fraction of a level's range where the morph to the coarser grid starts
+        float morphStart = 0.7f;
+    };
+
+    // needs the GL context
+    Terrain(Heightmap heightmap, const Settings& settings);
+    ~Terrain();
+    Terrain(const Terrain&) = delete;
+    Terrain& operator=(const Terrain&) = delete;
+
+    // surface color texture repeated every 1 / tiling world units
+    void setSurface(Texture* texture, float tiling);
+
+    // shader is terrain_vertex.glsl with a textured lighting program, its lights updated
+    void draw(Shader& shader, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos);
+
+    const Heightmap& getHeightmap() const { return heightmap; }
+    size_t getPatchCount() const { return selected.size(); }
+    size_t getVertexCount() const;
+
+private:
+    struct Node {
+        int level;
+        int x;
+        int z;
+    };
+
+    Heightmap heightmap;
+    Settings settings;
+    std::unique_ptr<Model> patch;
+    GLuint heightTexture = 0;
+    GLuint normalTexture = 0;
+    Texture* surface = nullptr;
+    float surfaceTiling = 0.1f;
+
+    // per level, finest first, the height range of every node in row-major order
+    std::vector<std::vector<glm::vec2>> nodeHeights;
+    std::vector<float> ranges;
+    std::vector<Node> selected;
+
+    int nodesAcross(int level) const { return 1 << (settings.lodLevels - 1 - level); }
+    glm::vec2 nodeSize(int level) const;
+    Aabb nodeBounds(int level, int x, int z) const;
+    void select(int level, int x, int z, const glm::vec3& eye, const Frustum& frustum);
+    void buildPatch();
+    void buildNodeHeights();
+    void uploadTextures();
+};
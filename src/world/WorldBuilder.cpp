@@ -0,0 +1,154 @@
+#include "WorldBuilder.hpp"
+#include "../Random.hpp"
+#include "../ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+using Vertex = std::array<float, ChunkFile::TERRAIN_STRIDE>;
+
+struct VertexHash {
+    size_t operator()(const Vertex& v) const {
+        uint32_t h = 2166136261u;
+        for (float f : v) {
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            h = (h ^ hash(bits)) * 16777619u;
+        }
+        return h;
+    }
+};
+}
+
+WorldBuilder::WorldBuilder(float chunkSize) : chunkSize(chunkSize) {}
+
+ChunkCoord WorldBuilder::coordOf(float x, float z) const {
+    return {static_cast<int32_t>(std::floor(x / chunkSize)), static_cast<int32_t>(std::floor(z / chunkSize))};
+}
+
+void WorldBuilder::addTerrain(const std::vector<float>& triangles, int stride, const glm::mat4& transform) {
+    if (stride < ChunkFile::TERRAIN_STRIDE) {
+        std::cerr << "World terrain needs position, normal and uv!!!" << std::endl;
+        return;
+    }
+    glm::mat3 normalMat = glm::transpose(glm::inverse(glm::mat3(transform)));
+    // a mirroring transform turns the triangles inside out, so the winding is swapped back
+    bool mirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+
+    std::unordered_map<ChunkCoord, std::unordered_map<Vertex, uint32_t, VertexHash>, ChunkCoordHash> lookups;
+    size_t vertexCount = triangles.size() / stride;
+    for (size_t t = 0; t + 2 < vertexCount; t += 3) {
+        Vertex tri[3];
+        glm::vec3 centroid(0.0f);
+        for (int k = 0; k < 3; ++k) {
+            const float* v = &triangles[(t + k) * stride];
+            glm::vec4 p = transform * glm::vec4(v[0], v[1], v[2], 1.0f);
+            glm::vec3 pos = glm::vec3(p) / p.w;
+            glm::vec3 n = glm::normalize(normalMat * glm::vec3(v[3], v[4], v[5]));
+            tri[k] = {pos.x, pos.y, pos.z, n.x, n.y, n.z, v[6], v[7]};
+            centroid += pos / 3.0f;
+        }
+        if (mirrored) std::swap(tri[1], tri[2]);
+
+        ChunkCoord coord = coordOf(centroid.x, centroid.z);
+        ChunkData& chunk = chunks[coord];
+        chunk.coord = coord;
+        auto& lookup = lookups[coord];
+        for (const Vertex& v : tri) {
+            auto it = lookup.find(v);
+            if (it == lookup.end()) {
+                uint32_t idx = static_cast<uint32_t>(chunk.terrainVertices.size() / ChunkFile::TERRAIN_STRIDE);
+                // vertices from earlier calls aren't in the lookup, they just don't get shared
+                it = lookup.emplace(v, idx).first;
+                chunk.terrainVertices.insert(chunk.terrainVertices.end(), v.begin(), v.end());
+            }
+            chunk.terrainIndices.push_back(it->second);
+        }
+    }
+}
+
+bool WorldBuilder::heightAt(const ChunkData& chunk, float x, float z, float& y) {
+    const auto& v = chunk.terrainVertices;
+    const auto& idx = chunk.terrainIndices;
+    for (size_t i = 0; i + 2 < idx.size(); i += 3) {
+        const float* a = &v[idx[i] * ChunkFile::TERRAIN_STRIDE];
+        const float* b = &v[idx[i + 1] * ChunkFile::TERRAIN_STRIDE];
+        const float* c = &v[idx[i + 2] * ChunkFile::TERRAIN_STRIDE];
+        // barycentrics of x, z in the triangle's projection onto XZ
+        float det = (b[2] - c[2]) * (a[0] - c[0]) + (c[0] - b[0]) * (a[2] - c[2]);
+        if (std::abs(det) < 1e-8f) continue;
+        float l0 = ((b[2] - c[2]) * (x - c[0]) + (c[0] - b[0]) * (z - c[2])) / det;
+        float l1 = ((c[2] - a[2]) * (x - c[0]) + (a[0] - c[0]) * (z - c[2])) / det;
+        float l2 = 1.0f - l0 - l1;
+        if (l0 < 0.0f || l1 < 0.0f || l2 < 0.0f) continue;
+        y = l0 * a[1] + l1 * b[1] + l2 * c[1];
+        return true;
+    }
+    return false;
+}
+
+void WorldBuilder::addScatter(uint32_t model, float density, float minScale, float maxScale, uint32_t seed) {
+    for (auto& entry : chunks) {
+        ChunkData& chunk = entry.second;
+        SeededRandom rng{hash(seed ^ hash(model * 73856093u ^ static_cast<uint32_t>(chunk.coord.x) * 19349663u ^
+                                         static_cast<uint32_t>(chunk.coord.z) * 83492791u))};
+        float x0 = chunk.coord.x * chunkSize;
+        float z0 = chunk.coord.z * chunkSize;
+        int count = static_cast<int>(density * chunkSize * chunkSize + rng.next());
+        for (int i = 0; i < count; ++i) {
+            float x = x0 + rng.next() * chunkSize;
+            float z = z0 + rng.next() * chunkSize;
+            float yaw = rng.next() * TWO_PI;
+            float scale = minScale + rng.next() * (maxScale - minScale);
+            float y;
+            if (!heightAt(chunk, x, z, y)) continue;
+            chunk.props.push_back({model, glm::vec3(x, y, z), yaw, scale});
+        }
+        std::stable_sort(chunk.props.begin(), chunk.props.end(),
+                         [](const ChunkProp& a, const ChunkProp& b) { return a.model < b.model; });
+    }
+}
+
+bool WorldBuilder::write(const std::string& directory, ThreadPool* workers) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Can't create world directory " << directory << "!!!" << std::endl;
+        return false;
+    }
+    if (chunks.empty()) {
+        std::cerr << "World has no chunks to write!!!" << std::endl;
+        return false;
+    }
+
+    std::vector<const ChunkData*> list;
+    WorldInfo info;
+    info.chunkSize = chunkSize;
+    info.min = {INT32_MAX, INT32_MAX};
+    info.max = {INT32_MIN, INT32_MIN};
+    for (const auto& entry : chunks) {
+        list.push_back(&entry.second);
+        info.min = {std::min(info.min.x, entry.first.x), std::min(info.min.z, entry.first.z)};
+        info.max = {std::max(info.max.x, entry.first.x), std::max(info.max.z, entry.first.z)};
+    }
+
+    std::atomic<int> failed{0};
+    auto writeRange = [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            if (!ChunkFile::write(ChunkFile::path(directory, list[i]->coord), *list[i])) ++failed;
+        }
+    };
+    int count = static_cast<int>(list.size());
+    if (workers) {
+        workers->parallelFor(count, 8, writeRange);
+    } else {
+        writeRange(0, count);
+    }
+    // the info file goes last, it marks the directory as complete
+    return failed == 0 && ChunkFile::writeInfo(directory, info);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ChunkFormat.hpp"
+
+class ThreadPool;
+
+// cuts terrain and props into square chunks on the XZ plane and writes them
+// out for the WorldStreamer; the whole world is held in memory while it is
+// built, only the streamer is bounded
+class WorldBuilder {
+public:
+    explicit WorldBuilder(float chunkSize);
+
+    // triangle list of position/normal/uv vertices with stride >= 8; every
+    // triangle goes to the chunk holding its centroid
+    void addTerrain(const std::vector<float>& triangles, int stride, const glm::mat4& transform);
+    // density props per square unit, standing on the terrain added so far;
+    // the same seed places them the same way on every build
+    void addScatter(uint32_t model, float density, float minScale, float maxScale, uint32_t seed);
+
+    // one file per chunk plus world.info, on the workers when given
+    bool write(const std::string& directory, ThreadPool* workers = nullptr);
+
+    size_t getChunkCount() const { return chunks.size(); }
+
+private:
+    float chunkSize;
+    std::unordered_map<ChunkCoord, ChunkData, ChunkCoordHash> chunks;
+
+    ChunkCoord coordOf(float x, float z) const;
+    // terrain height under x, z from the chunk's triangles, false off the terrain
+    static bool heightAt(const ChunkData& chunk, float x, float z, float& y);
+};
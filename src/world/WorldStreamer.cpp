@@ -0,0 +1,295 @@
+#include "WorldStreamer.hpp"
+#include "../Model.hpp"
+#include "../ThreadPool.hpp"
+#include "../renderers/Shader.hpp"
+#include "../renderers/Texture.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+glm::vec2 xz(const glm::vec3& v) {
+    return glm::vec2(v.x, v.z);
+}
+}
+
+WorldStreamer::WorldStreamer(const std::string& directory, const Settings& settings)
+    : directory(directory), settings(settings) {
+    valid = ChunkFile::readInfo(directory, info);
+    if (!valid) {
+        std::cerr << "No streamable world in " << directory << "!!!" << std::endl;
+    }
+    loaders = std::make_unique<ThreadPool>(settings.workerCount);
+}
+
+WorldStreamer::~WorldStreamer() {
+    // drops the queued loads and waits for the running ones
+    loaders->clear();
+    loaders.reset();
+    for (auto& entry : chunks) release(entry.second);
+}
+
+void WorldStreamer::setTerrain(Shader* shader, Texture* texture) {
+    terrainShader = shader;
+    terrainTexture = texture;
+}
+
+int WorldStreamer::addPaletteEntry(Model* model, Shader* shader, const glm::vec3& color) {
+    // the workers read the palette, it has to be complete before the first update
+    if (!model || !shader || hasLastPosition) {
+        std::cerr << "Palette entries need a model and a program and go in before streaming starts!!!" << std::endl;
+        return -1;
+    }
+    palette.push_back({model, shader, color});
+    return static_cast<int>(palette.size()) - 1;
+}
+
+glm::vec3 WorldStreamer::chunkCenter(ChunkCoord coord) const {
+    return glm::vec3((coord.x + 0.5f) * info.chunkSize, 0.0f, (coord.z + 0.5f) * info.chunkSize);
+}
+
+float WorldStreamer::priority(ChunkCoord coord, const glm::vec3& position, const glm::vec3& predicted,
+                              const glm::vec3& front) const {
+    glm::vec2 center = xz(chunkCenter(coord));
+    float distance = glm::length(center - xz(predicted));
+    // chunks in front of the camera count as up to a third closer than ones behind it
+    glm::vec2 toChunk = center - xz(position);
+    glm::vec2 facing = xz(front);
+    float ahead = 0.0f;
+    if (glm::length(toChunk) > 1e-3f && glm::length(facing) > 1e-3f) {
+        ahead = glm::dot(glm::normalize(toChunk), glm::normalize(facing));
+    }
+    return distance * (1.0f - 0.25f * ahead);
+}
+
+void WorldStreamer::update(const glm::vec3& position, const glm::vec3& front, float dt) {
+    if (!valid) return;
+
+    if (hasLastPosition && dt > 0.0f) {
+        // smoothed, a single jittery frame shouldn't swing the prediction around
+        velocity = glm::mix(velocity, (position - lastPosition) / dt, 0.2f);
+    }
+    lastPosition = position;
+    hasLastPosition = true;
+    glm::vec3 predicted = position + velocity * settings.lookAhead;
+
+    auto wanted = [&](ChunkCoord coord, float radius) {
+        glm::vec2 center = xz(chunkCenter(coord));
+        return glm::length(center - xz(position)) < radius || glm::length(center - xz(predicted)) < radius;
+    };
+
+    // finished loads, a few per frame so uploads don't spike the frame time
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        size_t take = std::min(completed.size(), static_cast<size_t>(settings.maxUploadsPerFrame));
+        for (size_t i = 0; i < take; ++i) ready.push_back(std::move(completed[i]));
+        completed.erase(completed.begin(), completed.begin() + take);
+    }
+    for (auto& loaded : ready) {
+        --inFlight;
+        auto it = chunks.find(loaded->coord);
+        // evicted while it was loading
+        if (it == chunks.end() || it->second.state != ChunkState::LOADING) continue;
+        upload(*loaded);
+    }
+    // the loaded buffers go now, the capacity stays for the next frame
+    ready.clear();
+
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        if (!wanted(it->first, settings.unloadRadius)) {
+            release(it->second);
+            it = chunks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // the resident chunk that would be missed least
+    auto worstResident = [&](float& worst) {
+        auto found = chunks.end();
+        worst = -1.0f;
+        for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+            if (it->second.state != ChunkState::RESIDENT || it->second.bytes == 0) continue;
+            float p = priority(it->first, position, predicted, front);
+            if (p > worst) {
+                worst = p;
+                found = it;
+            }
+        }
+        return found;
+    };
+    while (residentBytes > settings.memoryBudget) {
+        float worst;
+        auto it = worstResident(worst);
+        if (it == chunks.end()) break;
+        release(it->second);
+        chunks.erase(it);
+    }
+
+    candidates.clear();
+    glm::vec2 lo = glm::min(xz(position), xz(predicted)) - settings.loadRadius;
+    glm::vec2 hi = glm::max(xz(position), xz(predicted)) + settings.loadRadius;
+    int minX = std::max(info.min.x, static_cast<int>(std::floor(lo.x / info.chunkSize)));
+    int minZ = std::max(info.min.z, static_cast<int>(std::floor(lo.y / info.chunkSize)));
+    int maxX = std::min(info.max.x, static_cast<int>(std::floor(hi.x / info.chunkSize)));
+    int maxZ = std::min(info.max.z, static_cast<int>(std::floor(hi.y / info.chunkSize)));
+    for (int z = minZ; z <= maxZ; ++z) {
+        for (int x = minX; x <= maxX; ++x) {
+            ChunkCoord coord{x, z};
+            if (chunks.count(coord) || !wanted(coord, settings.loadRadius)) continue;
+            candidates.push_back({priority(coord, position, predicted, front), coord});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (const auto& candidate : candidates) {
+        if (inFlight >= settings.maxInFlight) break;
+        // the chunks in flight are assumed to be as big as the resident ones on average
+        size_t average = residentCount ? residentBytes / residentCount : 0;
+        bool fits = residentBytes + (inFlight + 1) * average <= settings.memoryBudget;
+        while (!fits) {
+            float worst;
+            auto it = worstResident(worst);
+            if (it == chunks.end() || worst <= candidate.first) break;
+            release(it->second);
+            chunks.erase(it);
+            fits = residentBytes + (inFlight + 1) * average <= settings.memoryBudget;
+        }
+        if (!fits) break;
+        request(candidate.second);
+    }
+}
+
+void WorldStreamer::request(ChunkCoord coord) {
+    chunks[coord] = Chunk();
+    ++inFlight;
+    loaders->enqueue([this, coord]() {
+        std::unique_ptr<LoadedChunk> loaded = load(coord);
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completed.push_back(std::move(loaded));
+    });
+}
+
+std::unique_ptr<WorldStreamer::LoadedChunk> WorldStreamer::load(ChunkCoord coord) const {
+    auto loaded = std::make_unique<LoadedChunk>();
+    loaded->coord = coord;
+
+    // a missing or broken file comes back empty and stays resident as such,
+    // so it isn't asked for again every frame
+    ChunkData data;
+    if (!ChunkFile::read(ChunkFile::path(directory, coord), data) || data.coord != coord) return loaded;
+
+    for (size_t i = 0; i < data.terrainVertices.size(); i += ChunkFile::TERRAIN_STRIDE) {
+        loaded->bounds.expand(glm::vec3(data.terrainVertices[i], data.terrainVertices[i + 1],
+                                        data.terrainVertices[i + 2]));
+    }
+    loaded->terrainVertices = std::move(data.terrainVertices);
+    loaded->terrainIndices = std::move(data.terrainIndices);
+
+    loaded->instances.reserve(data.props.size());
+    for (const ChunkProp& prop : data.props) {
+        if (prop.model >= palette.size()) continue;
+        glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), prop.yaw, glm::vec3(0.0f, 1.0f, 0.0f));
+        InstanceData instance;
+        instance.model = glm::translate(glm::mat4(1.0f), prop.position) * rotation *
+                         glm::scale(glm::mat4(1.0f), glm::vec3(prop.scale));
+        for (int c = 0; c < 3; ++c) instance.normal[c] = glm::vec4(glm::vec3(rotation[c]), 0.0f);
+        loaded->bounds.expand(TransformBounds(palette[prop.model].model->getBounds(), instance.model));
+
+        if (loaded->runs.empty() || loaded->runs.back().palette != prop.model) {
+            loaded->runs.push_back({prop.model, static_cast<uint32_t>(loaded->instances.size()), 0});
+        }
+        ++loaded->runs.back().count;
+        loaded->instances.push_back(instance);
+    }
+    return loaded;
+}
+
+void WorldStreamer::upload(LoadedChunk& loaded) {
+    Chunk& chunk = chunks[loaded.coord];
+    chunk.bounds = loaded.bounds;
+    chunk.bytes = 0;
+    if (!loaded.terrainIndices.empty()) {
+        chunk.terrain = std::make_unique<Model>(loaded.terrainVertices, loaded.terrainIndices,
+                                                ChunkFile::TERRAIN_STRIDE, ModelType::UV);
+        // the model keeps a separate position stream next to the full vertices
+        size_t vertexCount = loaded.terrainVertices.size() / ChunkFile::TERRAIN_STRIDE;
+        chunk.bytes += loaded.terrainVertices.size() * sizeof(float) + vertexCount * 3 * sizeof(float) +
+                       loaded.terrainIndices.size() * sizeof(uint32_t);
+    }
+    for (const PropRun& run : loaded.runs) {
+        PropBatch batch;
+        batch.palette = run.palette;
+        batch.count = static_cast<int>(run.count);
+        glGenBuffers(1, &batch.buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, batch.buffer);
+        glBufferData(GL_ARRAY_BUFFER, run.count * sizeof(InstanceData), &loaded.instances[run.first],
+                     GL_STATIC_DRAW);
+        batch.vao = palette[run.palette].model->createInstancedVAO(batch.buffer);
+        chunk.props.push_back(batch);
+        chunk.bytes += run.count * sizeof(InstanceData);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    chunk.state = ChunkState::RESIDENT;
+    ++residentCount;
+    residentBytes += chunk.bytes;
+}
+
+void WorldStreamer::release(Chunk& chunk) {
+    if (chunk.state != ChunkState::RESIDENT) return;
+    for (const PropBatch& batch : chunk.props) {
+        glDeleteVertexArrays(1, &batch.vao);
+        glDeleteBuffers(1, &batch.buffer);
+    }
+    chunk.props.clear();
+    chunk.terrain.reset();
+    --residentCount;
+    residentBytes -= chunk.bytes;
+    chunk.bytes = 0;
+    chunk.state = ChunkState::LOADING;
+}
+
+void WorldStreamer::draw(const Frustum& frustum) {
+    visible.clear();
+    for (auto& entry : chunks) {
+        Chunk& chunk = entry.second;
+        if (chunk.state != ChunkState::RESIDENT || chunk.bounds.isEmpty()) continue;
+        if (frustum.test(chunk.bounds) == Frustum::Result::OUTSIDE) continue;
+        visible.push_back(&chunk);
+    }
+    if (visible.empty()) return;
+
+    if (terrainShader) {
+        terrainShader->use();
+        terrainShader->SetUniform("model", glm::mat4(1.0f));
+        terrainShader->SetUniform("useInstancing", false);
+        terrainShader->SetUniform("shininess", 16.0f);
+        terrainShader->SetUniform("objectColor", glm::vec3(1.0f));
+        if (terrainTexture) {
+            terrainTexture->bind(0);
+            terrainShader->SetUniform("textureSampler", 0);
+        }
+        terrainShader->SetUniform("useTexture", terrainTexture != nullptr);
+        for (Chunk* chunk : visible) {
+            if (chunk->terrain) chunk->terrain->draw();
+        }
+        if (terrainTexture) terrainTexture->unbind();
+    }
+
+    for (size_t p = 0; p < palette.size(); ++p) {
+        const PaletteEntry& entry = palette[p];
+        entry.shader->use();
+        entry.shader->SetUniform("objectColor", entry.color);
+        entry.shader->SetUniform("useInstancing", true);
+        for (Chunk* chunk : visible) {
+            for (const PropBatch& batch : chunk->props) {
+                if (batch.palette == p) entry.model->drawInstancedVAO(batch.vao, batch.count);
+            }
+        }
+        entry.shader->SetUniform("useInstancing", false);
+    }
+    glUseProgram(0);
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ChunkFormat.hpp"
+#include "../spatial/Bounds.hpp"
+
+class Model;
+class Shader;
+class Texture;
+class ThreadPool;
+
+// keeps the chunks of a world written by WorldBuilder resident around the
+// camera. files are read and turned into upload-ready buffers on its own
+// workers, the main thread only uploads a few finished chunks per frame.
+// requests are ordered by distance to where the camera will be in a moment,
+// cheaper ahead of it than behind, and GPU memory stays under a budget by
+// evicting the least wanted chunks, so the cost doesn't grow with the world
+class WorldStreamer {
+public:
+    struct Settings {
+        // chunk centers closer than this to the camera are wanted
+        float loadRadius = 96.0f;
+        // resident chunks are dropped past this, the gap keeps them from flickering
+        float unloadRadius = 128.0f;
+        size_t memoryBudget = 64u << 20;
+        int maxInFlight = 4;
+        int maxUploadsPerFrame = 2;
+        // seconds of the current velocity to predict the camera over
+        float lookAhead = 1.0f;
+        unsigned int workerCount = 2;
+    };
+
+    WorldStreamer(const std::string& directory, const Settings& settings);
+    ~WorldStreamer();
+    WorldStreamer(const WorldStreamer&) = delete;
+    WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+    // false when the directory holds no built world
+    bool isValid() const { return valid; }
+
+    // a program on vertex_textured.glsl
+    void setTerrain(Shader* shader, Texture* texture);
+    // what ChunkProp::model indexes, in order; a program on vertex.glsl with objectColor
+    int addPaletteEntry(Model* model, Shader* shader, const glm::vec3& color);
+
+    // requests, evicts and uploads, once per frame on the GL thread
+    void update(const glm::vec3& position, const glm::vec3& front, float dt);
+    void draw(const Frustum& frustum);
+
+    size_t getResidentCount() const { return residentCount; }
+    size_t getResidentBytes() const { return residentBytes; }
+    int getInFlightCount() const { return inFlight; }
+
+private:
+    struct InstanceData {
+        glm::mat4 model;
+        glm::vec4 normal[3];
+    };
+
+    // one palette entry's props inside a chunk
+    struct PropRun {
+        uint32_t palette;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    // everything a worker prepares, no GL objects
+    struct LoadedChunk {
+        ChunkCoord coord;
+        std::vector<float> terrainVertices;
+        std::vector<uint32_t> terrainIndices;
+        std::vector<InstanceData> instances;
+        std::vector<PropRun> runs;
+        Aabb bounds;
+    };
+
+    struct PropBatch {
+        uint32_t palette;
+        GLuint buffer;
+        GLuint vao;
+        int count;
+    };
+
+    enum class ChunkState {
+        LOADING,
+        RESIDENT
+    };
+
+    struct Chunk {
+        ChunkState state = ChunkState::LOADING;
+        std::unique_ptr<Model> terrain;
+        std::vector<PropBatch> props;
+        Aabb bounds;
+        size_t bytes = 0;
+    };
+
+    struct PaletteEntry {
+        Model* model;
+        Shader* shader;
+        glm::vec3 color;
+    };
+
+    std::string directory;
+    Settings settings;
+    WorldInfo info;
+    bool valid = false;
+
+    Shader* terrainShader = nullptr;
+    Texture* terrainTexture = nullptr;
+    std::vector<PaletteEntry> palette;
+
+    std::unordered_map<ChunkCoord, Chunk, ChunkCoordHash> chunks;
+    size_t residentCount = 0;
+    size_t residentBytes = 0;
+    int inFlight = 0;
+
+    glm::vec3 lastPosition = glm::vec3(0.0f);
+    glm::vec3 velocity = glm::vec3(0.0f);
+    bool hasLastPosition = false;
+
+    std::mutex completedMutex;
+    std::vector<std::unique_ptr<LoadedChunk>> completed;
+    // declared last so it is torn down first, before anything its jobs touch
+    std::unique_ptr<ThreadPool> loaders;
+
+    // reused every frame
+    std::vector<std::pair<float, ChunkCoord>> candidates;
+    std::vector<Chunk*> visible;
+    std::vector<std::unique_ptr<LoadedChunk>> ready;
+
+    glm::vec3 chunkCenter(ChunkCoord coord) const;
+    float priority(ChunkCoord coord, const glm::vec3& position, const glm::vec3& predicted,
+                   const glm::vec3& front) const;
+    void request(ChunkCoord coord);
+    std::unique_ptr<LoadedChunk> load(ChunkCoord coord) const;
+    void upload(LoadedChunk& loaded);
+    void release(Chunk& chunk);
+};